@@ -23,10 +23,14 @@
  * Edited by Njaal Brekke for the ESP Ascom Alpaca Library
  * Fixed getDiff error due to 'prop' being overwritten by recursion
  * Change boolean to checkbox
+ *
+ * Optional schema (GET schema of the page, same nesting as the data): each field has Type, Min,
+ * Max and ReadOnly; inputs get min/max/step or minlength/maxlength and read-only fields are locked
  */
 $.widget('jsnook.jsonFormer', {
     options: {
         title: 'The data you passed',
+        schema: {},
         rootTemplate: '<div id="json-object"><form class="form-horizontal json-form-inner" ></form></div>',
         objectTemplate: '<div id="json-object" class="card mb-2 mt-2"><div class="card-header"><div id="title"></div></div><div class="card-body"><form class="form-horizontal json-form-inner" ></form></div></div>',
         arrayTemplate: '<div id="json-array" class="form-group row"><label class="control-label col-sm-4 col-form-label"></label><form class="form-inline col-sm-8 json-form-inner"></form></div>',
@@ -53,7 +57,7 @@ $.widget('jsnook.jsonFormer', {
         var box = $(this.options.rootTemplate);
         $(container).append(box);
         container = $(box).find('form');
-        self._recursiveFunction('data', this.jsonObject, container, pKey);
+        self._recursiveFunction('data', this.jsonObject, container, pKey, this.options.schema);
         $('[data-original]').on('keyup keypress blur change', function (e) {
             let val;
             if ($(e.target).attr('type') === 'checkbox') {
@@ -74,6 +78,14 @@ $.widget('jsnook.jsonFormer', {
     refresh: function () {
         this._makeForm();
     },
+    /**
+     * Replaces the original object, e.g. after the changes were applied, and redraws the form
+     * @returns jQuery
+     */
+    load: function (jsonObject) {
+        this.jsonObject = jsonObject;
+        this._makeForm();
+    },
     /**
      * Gets the changed items from our form and pokes them into a clone of
      * the original and return it
@@ -139,15 +151,32 @@ $.widget('jsnook.jsonFormer', {
         });
         return theDiff;
     },
-    _recursiveFunction: function (key, val, container, parentKey) {
-        $.each(val, this._eachClosure(container, parentKey));
+    _recursiveFunction: function (key, val, container, parentKey, schema) {
+        $.each(val, this._eachClosure(container, parentKey, schema));
+    },
+    /**
+     * Bounds and access of the field from the schema; integer types get step 1
+     */
+    _applySchema: function (input, field) {
+        if (!field || !field.Type)
+            return;
+        if (field.Type === 'string') {
+            input.attr('minlength', field.Min).attr('maxlength', field.Max);
+        } else if (field.Type !== 'bool') {
+            input.attr('min', field.Min).attr('max', field.Max);
+            if (field.Type !== 'float' && field.Type !== 'double')
+                input.attr('step', 1);
+        }
+        if (field.ReadOnly)
+            input.prop(field.Type === 'bool' ? 'disabled' : 'readonly', true);
     },
-    _eachClosure: function (containerElem, parentKey) {
+    _eachClosure: function (containerElem, parentKey, parentSchema) {
         var ppKey = parentKey;
         var self = this;
         var container = containerElem;
         return function (key, val) {
             var pKey = ppKey + (typeof (key) === 'number' ? '[' + key + ']' : '-' + key);
+            var schema = parentSchema ? parentSchema[key] : undefined;
             var box;
             switch (typeof (val)) {
                 case "array":
@@ -155,7 +184,7 @@ $.widget('jsnook.jsonFormer', {
                     $(box).find('label').text(key);
                     innerContainer = $(box).find('.json-form-inner');
                     $(container).append(box);
-                    self._recursiveFunction(key, val, innerContainer, pKey);
+                    self._recursiveFunction(key, val, innerContainer, pKey, schema);
                     break;
                 case "object":
                     if (!self._isEmpty(val)) {
@@ -169,7 +198,7 @@ $.widget('jsnook.jsonFormer', {
                             innerContainer = $(box).find('.json-form-inner');
                         }
                         $(container).append(box);
-                        self._recursiveFunction(key, val, innerContainer, pKey);
+                        self._recursiveFunction(key, val, innerContainer, pKey, schema);
                     } else {
                         box = $(self.options.emptyObjectTemplate);
                         val = JSON.stringify(val);
@@ -193,6 +222,7 @@ $.widget('jsnook.jsonFormer', {
                                 .attr('value', val)
                                 .attr('data-original', val)
                                 .attr('placeholder', key);
+                        self._applySchema($(box).find('input'), schema);
                     }
                     $(container).append(box);
                     break;
@@ -213,6 +243,7 @@ $.widget('jsnook.jsonFormer', {
                                 .attr('data-original', val)
                                 .attr('type', 'number')
                                 .attr('step','any');
+                        self._applySchema($(box).find('input'), schema);
                     }
                     $(container).append(box);
                     break;
@@ -224,6 +255,7 @@ $.widget('jsnook.jsonFormer', {
                         .attr('id', pKey)
                         .attr('data-original', val)
                         .prop('checked', val);
+                    self._applySchema($(box).find('input'), schema);
                     $(container).append(box);
                     break;
                 case "null":
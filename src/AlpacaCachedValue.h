@@ -0,0 +1,95 @@
+/**************************************************************************************************
+  Filename:       AlpacaCachedValue.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 04 $
+
+  Description:    Read-through cache of a driver getter
+
+  Reads of a property within its TTL (e.g. several clients polling in the same instant, or the
+  state poll of AlpacaServer) share one call of the driver getter. All getter calls run under the
+  driver lock of the device, so a read never overlaps a getter call in flight; the TTL alone decides
+  what is shared. State that changes quickly (Slewing, IsMoving, IsSafe) uses a TTL of at most
+  kAlpacaCoalesceMs, slow sensors a longer one. Drivers invalidate the value when they know it
+  changed. Hits and misses are shown by /metrics.
+**************************************************************************************************/
+#pragma once
+#include <Arduino.h>
+#include "AlpacaConfig.h"
+
+// type independent part; AlpacaDevice lists these for /metrics
+class AlpacaCachedValueBase
+{
+protected:
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+    const char *_name;
+    uint32_t _ttl_ms;
+    uint32_t _ms = 0; // start of the getter call that returned the value
+    bool _valid = false;
+    uint32_t _generation = 0; // bumped by Invalidate(); a getter call that overlaps it does not store its value
+    uint32_t _hits = 0;
+    uint32_t _misses = 0;
+
+    // true if the value is valid at now; counts hit or miss; call under _mux
+    bool _fresh(uint32_t now)
+    {
+        bool fresh = _valid && (now - _ms) < _ttl_ms;
+        if (fresh)
+            _hits++;
+        else
+            _misses++;
+        return fresh;
+    }
+
+public:
+    AlpacaCachedValueBase(const char *name, uint32_t ttl_ms) : _name(name), _ttl_ms(ttl_ms) {}
+
+    void Invalidate()
+    {
+        portENTER_CRITICAL(&_mux);
+        _valid = false;
+        _generation++;
+        portEXIT_CRITICAL(&_mux);
+    }
+    void SetTTL(uint32_t ttl_ms) { _ttl_ms = ttl_ms; } // 0: every read calls the getter
+    const char *GetName() { return _name; }
+    const uint32_t GetTTL() { return _ttl_ms; }
+    const uint32_t GetHits() { return _hits; }
+    const uint32_t GetMisses() { return _misses; }
+};
+
+template <typename T>
+class AlpacaCachedValue : public AlpacaCachedValueBase
+{
+private:
+    T _value = T();
+
+public:
+    AlpacaCachedValue(const char *name, uint32_t ttl_ms = kAlpacaCoalesceMs) : AlpacaCachedValueBase(name, ttl_ms) {}
+
+    // value of a getter call started less than the TTL ago; otherwise call getter
+    template <typename F>
+    T Get(F getter)
+    {
+        uint32_t now = millis();
+        portENTER_CRITICAL(&_mux);
+        if (_fresh(now))
+        {
+            T value = _value;
+            portEXIT_CRITICAL(&_mux);
+            return value;
+        }
+        uint32_t generation = _generation;
+        portEXIT_CRITICAL(&_mux);
+
+        T value = getter(); // not under _mux; may block on the bus
+        portENTER_CRITICAL(&_mux);
+        if (_generation == generation)
+        {
+            _value = value;
+            _ms = now;
+            _valid = true;
+        }
+        portEXIT_CRITICAL(&_mux);
+        return value;
+    }
+};
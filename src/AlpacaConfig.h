@@ -20,6 +20,12 @@ const char esp32_alpaca_device_library_version[] = "1.0.0";
 #define ALPACA_TCP_PORT 80
 #define ALPACA_CLIENT_CONNECTION_TIMEOUT_SEC 120
 #define ALPACA_CONNECTION_LESS_CLIENT_ID 42424242   // used for services without connection 
+#define ALPACA_SETTINGS_WRITE_DELAY_MS 2000         // settings are written after no change for this time
+#define ALPACA_SETTINGS_MAX_WRITE_DELAY_MS 10000    // ... but not later than this after the first change
+#define ALPACA_COALESCE_MS 20                       // property reads within this time share one driver call
+#define ALPACA_JOURNAL_PARTITION_LABEL "journal"    // data partition of the position journal; see partitions.csv
+#define ALPACA_SIM_MAX_LATENCY_MS 1000              // latency of a simulated driver call; it blocks under the driver lock
+#define ALPACA_DRIVER_LOCK_TIMEOUT_MS 500           // a REST request waits this long for the driver, then answers "driver busy"
 
 //#define ALPACA_ENABLE_OTA_UPDATE
 
@@ -63,6 +69,15 @@ const char esp32_alpaca_device_library_version[] = "1.0.0";
 #define ALPACA_DOME_NAME "not used"                           // init with <deviceType>-<deviceNumber>; managed by config
 #define ALPACA_DOME_DEVICE_TYPE "dome"                        // don't change
 
+// Dome - Specific Properties
+#define ALPACA_DOME_STATUS_TTL_MS ALPACA_COALESCE_MS         // cache of Slewing
+#define ALPACA_DOME_SHUTTER_TIMEOUT_MS 60000                  // shutter travel longer than this is reported as error
+#define ALPACA_DOME_SHUTTER_POLL_MS 250                       // _getShutter() period of drivers without shutter events
+#define ALPACA_DOME_ROTATOR_PERIOD_US 10000                   // control tick of the azimuth rotator
+#define ALPACA_DOME_ROTATOR_JITTER_BUDGET_US 1000             // ticks off by more are counted as over budget
+#define ALPACA_DOME_ROTATOR_STALL_MS 2000                     // driven without encoder counts for longer is a fault
+#define ALPACA_DOME_SLAVING_PERIOD_MS 100                     // slaved dome: target azimuth update period
+
 // // Focuser - Optional Methods
 // #define ALPACA_DOME_PUT_ACTION_IMPLEMENTED
 // #define ALPACA_DOME_PUT_COMMAND_BLIND_IMPLEMENTED
@@ -77,6 +92,9 @@ const char esp32_alpaca_device_library_version[] = "1.0.0";
 #define ALPACA_SAFETYMONITOR_NAME "not used"                            // init with <deviceType>-<deviceNumber>; managed by config
 #define ALPACA_SAFETYMONITOR_DEVICE_TYPE "safetymonitor"                // don't change
 
+// SAFETYMONITOR - Specific Properties
+#define ALPACA_SAFETYMONITOR_IS_SAFE_TTL_MS ALPACA_COALESCE_MS  // cache of IsSafe; drivers invalidate _is_safe_value on a change
+
 // // SAFETYMONITOR - Optional Methods
 // #define ALPACA_SAFETYMONITOR_PUT_ACTION_IMPLEMENTED
 // #define ALPACA_SAFETYMONITOR_PUT_COMMAND_BLIND_IMPLEMENTED
@@ -102,6 +120,13 @@ const char esp32_alpaca_device_library_version[] = "1.0.0";
 #define ALPACA_OBSERVING_CONDITIONS_NAME "not used"                                          // init with <deviceType>-<deviceNumber>; managed by config
 #define ALPACA_OBSERVING_CONDITIONS_DEVICE_TYPE "observingconditions"                        // don't change
 
+// ObservingConditions - Specific Properties
+#define ALPACA_OBSERVING_CONDITIONS_SERIES_SIZE 48             // time buckets per sensor for the AveragePeriod mean
+#define ALPACA_OBSERVING_CONDITIONS_MAX_AVERAGE_PERIOD_H 24.0  // longest AveragePeriod [h]
+#define ALPACA_OBSERVING_CONDITIONS_HISTORY_PERIOD_MS 10000    // sample period of the sensor history
+#define ALPACA_OBSERVING_CONDITIONS_HISTORY_KB 4               // compressed history per implemented sensor in RAM
+#define ALPACA_OBSERVING_CONDITIONS_HISTORY_PSRAM_KB 64        // ... in PSRAM when present
+
 // =======================================================================================================
 // Focuser - Comon Properties
 #define ALPACA_FOCUSER_DESCRIPTION "Alpaca Focuser"        // init value; managed by config
@@ -110,6 +135,14 @@ const char esp32_alpaca_device_library_version[] = "1.0.0";
 #define ALPACA_FOCUSER_NAME "not used"                              // init with <deviceType>-<deviceNumber>; managed by config
 #define ALPACA_FOCUSER_DEVICE_TYPE "focuser"                        // don't change
 
+// Focuser - Specific Properties
+#define ALPACA_FOCUSER_POSITION_TTL_MS ALPACA_COALESCE_MS    // cache of Position and IsMoving
+#define ALPACA_FOCUSER_TEMPERATURE_TTL_MS 1000               // cache of Temperature
+#define ALPACA_FOCUSER_STEP_RAMP_SIZE 512                    // max steps of the acceleration ramp of the step generator
+#define ALPACA_FOCUSER_STEP_MIN_INTERVAL_US 100              // shortest step interval; limits the speed to 10000 steps/s
+#define ALPACA_FOCUSER_STEP_JITTER_BUDGET_US 50              // steps started later are counted as late
+#define ALPACA_FOCUSER_TEMP_COMP_PERIOD_MS 1000              // tick of the built-in temperature compensation
+
 // // Focuser - Optional Methods
 //#define ALPACA_FOCUSER_PUT_ACTION_IMPLEMENTED
 //#define ALPACA_FOCUSER_PUT_COMMAND_BLIND_IMPLEMENTED
@@ -124,5 +157,37 @@ const uint32_t kAlpacaMaxDevices = ALPACA_MAX_DEVICES;
 const uint32_t kAlpacaUdpPort = ALPACA_UDP_PORT;
 const uint32_t kAlpacaTcpPort = ALPACA_TCP_PORT;
 const uint32_t kAlpacaClientConnectionTimeoutMs = ALPACA_CLIENT_CONNECTION_TIMEOUT_SEC * 1000;
+const uint32_t kAlpacaSettingsWriteDelayMs = ALPACA_SETTINGS_WRITE_DELAY_MS;
+const uint32_t kAlpacaSettingsMaxWriteDelayMs = ALPACA_SETTINGS_MAX_WRITE_DELAY_MS;
+const uint32_t kAlpacaCoalesceMs = ALPACA_COALESCE_MS;
+const uint32_t kAlpacaSimMaxLatencyMs = ALPACA_SIM_MAX_LATENCY_MS; // well below the 5 s task watchdog
+const uint32_t kAlpacaDriverLockTimeoutMs = ALPACA_DRIVER_LOCK_TIMEOUT_MS; // plus the driver call itself below the 5 s task watchdog
+const char kAlpacaJournalPartitionLabel[] = ALPACA_JOURNAL_PARTITION_LABEL;
+const uint8_t kAlpacaJournalPartitionSubtype = 0x40; // custom data subtype
+const uint32_t kAlpacaJournalMaxKeys = 16;
+const uint32_t kAlpacaMaxCachedValues = 8; // per device
+const uint32_t kAlpacaDomeShutterPollMs = ALPACA_DOME_SHUTTER_POLL_MS;
+const uint32_t kAlpacaDomeShutterQueueSize = 8;
+const uint32_t kAlpacaDomeRotatorPeriodUs = ALPACA_DOME_ROTATOR_PERIOD_US;
+const uint32_t kAlpacaDomeRotatorJitterBudgetUs = ALPACA_DOME_ROTATOR_JITTER_BUDGET_US;
+const uint32_t kAlpacaDomeRotatorStallUs = ALPACA_DOME_ROTATOR_STALL_MS * 1000;
+const uint32_t kAlpacaDomeRotatorSettleUs = 200000;  // standstill after the motor stopped
+const float kAlpacaDomeRotatorHomingSpeed = 0.5f;
+const float kAlpacaDomeRotatorVelocityAlpha = 0.2f;  // low pass of the velocity estimate
+const uint32_t kAlpacaDomeJournalSettleMs = 2000;    // at rest before the azimuth goes to the position journal
+const uint32_t kAlpacaDomeSlavingPeriodMs = ALPACA_DOME_SLAVING_PERIOD_MS;
+const uint32_t kAlpacaDomeSlavingCheckEvery = 16;    // updates per double precision check of the solver
+const uint32_t kAlpacaFocuserStepRampSize = ALPACA_FOCUSER_STEP_RAMP_SIZE;
+const uint32_t kAlpacaFocuserStepMinIntervalUs = ALPACA_FOCUSER_STEP_MIN_INTERVAL_US;
+const uint32_t kAlpacaFocuserStepJitterBudgetUs = ALPACA_FOCUSER_STEP_JITTER_BUDGET_US;
+const uint32_t kAlpacaFocuserTempCompPeriodMs = ALPACA_FOCUSER_TEMP_COMP_PERIOD_MS;
+const double kAlpacaFocuserTempCompAlpha = 0.2;         // low pass of the temperature per tick
+const double kAlpacaFocuserTempCompMinVariance = 0.25;  // temperature variance of the samples needed for a fit [degC^2]
+const uint32_t kAlpacaOcSeriesSize = ALPACA_OBSERVING_CONDITIONS_SERIES_SIZE;
+const double kAlpacaOcMaxAveragePeriodH = ALPACA_OBSERVING_CONDITIONS_MAX_AVERAGE_PERIOD_H;
+const uint32_t kAlpacaOcHistoryPeriodMs = ALPACA_OBSERVING_CONDITIONS_HISTORY_PERIOD_MS;
+const uint32_t kAlpacaOcHistoryBytes = ALPACA_OBSERVING_CONDITIONS_HISTORY_KB * 1024;
+const uint32_t kAlpacaOcHistoryPsramBytes = ALPACA_OBSERVING_CONDITIONS_HISTORY_PSRAM_KB * 1024;
+const uint32_t kAlpacaOcHistoryBlockSize = 256; // independently decodable; oldest block dropped when full
 
 
@@ -15,7 +15,7 @@ const char *const AlpacaCoverCalibrator::k_alpaca_cover_status_str[7] = {"NotPre
 AlpacaCoverCalibrator::AlpacaCoverCalibrator()
 {
     strlcpy(_device_type, ALPACA_COVER_CALIBRATOR_DEVICE_TYPE, sizeof(_device_type));
-    strlcpy(_device_description, ALPACA_COVER_CALIBRATOR_DESCRIPTION, sizeof(_device_description));
+    strlcpy(_general.description, ALPACA_COVER_CALIBRATOR_DESCRIPTION, sizeof(_general.description));
     strlcpy(_driver_info, ALPACA_COVER_CALIBRATOR_DRIVER_INFO, sizeof(_driver_info));
     strlcpy(_device_and_driver_version, esp32_alpaca_device_library_version, sizeof(_device_and_driver_version));
     _device_interface_version = ALPACA_COVER_CALIBRATOR_INTERFACE_VERSION;
@@ -322,3 +322,12 @@ mycatch:
     _alpaca_server->Respond(request, _clients[client_idx], _rsp_status);
     DBG_END
 }
+
+// state for the events of AlpacaServer
+void AlpacaCoverCalibrator::AlpacaWriteState(JsonObject &root)
+{
+    AlpacaDevice::AlpacaWriteState(root);
+    root["CoverState"] = (int32_t)GetCoverState();
+    root["CalibratorState"] = (int32_t)GetCalibratorState();
+    root["Brightness"] = GetBrightness();
+}
@@ -112,4 +112,5 @@ protected:
   const char *const GetAlpacaCoverStatusStr(AlpacaCoverStatus_t state) { return k_alpaca_cover_status_str[(uint32_t)state]; };
 
 public:
+    void AlpacaWriteState(JsonObject &root);
 };
@@ -10,6 +10,13 @@
 **************************************************************************************************/
 #include "AlpacaDevice.h"
 
+// "General" section of every device
+static constexpr AlpacaSettingField_t kAlpacaDeviceGeneralSettings[] = {
+    ALPACA_SETTING(AlpacaDeviceGeneral_t, name, "General", "Name", kString, 1, 32, false),
+    ALPACA_SETTING(AlpacaDeviceGeneral_t, description, "General", "Description", kString, 0, 128, false),
+    ALPACA_SETTING(AlpacaDeviceGeneral_t, uid, "General", "UID", kString, 0, 64, true),
+};
+
 void AlpacaDevice::Begin()
 {
     for (int i = 0; i <= kAlpacaMaxClients; i++)
@@ -22,14 +29,32 @@ void AlpacaDevice::Begin()
 
 // create url from device <command> and register callback <fn> for REST API
 // /api/v1/<_device_type>/<_device_number>/<command>
-void AlpacaDevice::createCallBack(ArRequestHandlerFunction fn, WebRequestMethodComposite type, const char command[])
+// <driver>: fn calls the driver; it runs with the driver lock until its Respond(), the Loop task calls
+// the driver only with the same lock. A request that does not get the lock within kAlpacaDriverLockTimeoutMs
+// is answered "driver busy" instead of blocking the AsyncTCP task.
+void AlpacaDevice::createCallBack(ArRequestHandlerFunction fn, WebRequestMethodComposite type, const char command[], bool driver)
 {
     char url[64];
     snprintf(url, sizeof(url), kAlpacaDeviceCommand, _device_type, _device_number, command);
     SLOG_PRINTF(SLOG_INFO, "REGISTER handler for \"%s\" to %s\n", url, command);
 
     // register handler for generated URI
-    _alpaca_server->getServerTCP()->on(url, type, fn);
+    if (!driver)
+    {
+        _alpaca_server->getServerTCP()->on(url, type, fn);
+        return;
+    }
+    _alpaca_server->getServerTCP()->on(url, type, [this, fn](AsyncWebServerRequest *request)
+                                       {
+                                           if (!LockDriver(kAlpacaDriverLockTimeoutMs))
+                                           {
+                                               _respondDriverBusy(request);
+                                               return;
+                                           }
+                                           _rsp_status.driver_lock = _driver_mutex;
+                                           fn(request);
+                                           _alpaca_server->RspStatusReleaseDriver(_rsp_status); // fn without Respond()
+                                       });
 }
 
 // create <url> and register callback <fn> for REST API
@@ -52,32 +77,72 @@ void AlpacaDevice::_setSetupPage()
     snprintf(url, sizeof(url), kAlpacaDeviceSetup, _device_type, _device_number, "jsondata");
     this->createCallBackUrl(LHF(_getJsondata), HTTP_GET, url, "_getJsondata");
 
+    // HTTP_GET /setup/v1/<_device_type>/<_device_number>/schema
+    snprintf(url, sizeof(url), kAlpacaDeviceSetup, _device_type, _device_number, "schema");
+    this->createCallBackUrl(LHF(_getSchema), HTTP_GET, url, "_getSchema");
+
     // HTTP_GET /setup/v1/<_device_type>/<_device_number>/setup
     snprintf(url, sizeof(url), kAlpacaDeviceSetup, _device_type, _device_number, "setup");
     this->createCallBackUrl(LHF(_getSetupPage), HTTP_GET, url, "_getSetupPage");
 
-    // handler for HTTP_POST /setup/v1/<_device_type>/<_device_number>/jsondata
+    // handler for HTTP_POST and HTTP_PATCH /setup/v1/<_device_type>/<_device_number>/jsondata
+    // POST: whole form; PATCH: only the changed keys, response with per-field errors
     snprintf(url, sizeof(url), kAlpacaDeviceSetup, _device_type, _device_number, "jsondata");
-    AsyncCallbackJsonWebHandler *jsonhandler = new AsyncCallbackJsonWebHandler(url, [this](AsyncWebServerRequest *request, JsonVariant &json)
-                                                                               {    
+    SLOG_PRINTF(SLOG_INFO, "REGISTER handler for \"%s\" to AlpacaReadJson\n", url);
+    _alpaca_server->OnJson(url, HTTP_POST | HTTP_PATCH, kAlpacaMaxJsonContentLength, [this](AsyncWebServerRequest *request, JsonObject &root)
+                           {
         SLOG_PRINTF(SLOG_INFO, "BEGIN REQ (%02x %s) ...\n", (int)request->method(), request->url().c_str());
-        //DBG_JSON_PRINTFJ(SLOG_INFO, json, "BEGIN REQ AlpacaDevice::handler(url=%s, json=%s)\n", request->url().c_str(), _ser_json_);
         DBG_REQ
-        JsonObject jsonObj = json.as<JsonObject>();
-        this->AlpacaReadJson(jsonObj); 
-        request->send(200, F("application/json"), F("{\"recieved\":\"true\"}")); 
+        if (request->method() == HTTP_PATCH)
+        {
+            JsonDocument rsp;
+            JsonObject errors = rsp["errors"].to<JsonObject>();
+            if (root && root.size() > 0)
+            {
+                JsonDocument known_doc;
+                JsonObject known = known_doc.to<JsonObject>();
+                _alpaca_server->LockSettings();
+                this->AlpacaWriteJson(known);
+                AlpacaSettings::Unknown(root, known, errors);
+                _patch_errors = errors;
+                this->AlpacaReadJson(root);
+                _patch_errors = JsonObject();
+                _alpaca_server->UnlockSettings();
+                if (AlpacaSettings::Count(root) > AlpacaSettings::Count(errors)) // at least one value applied
+                    _alpaca_server->MarkSettingsDirty(this);
+            }
+            String ser_json = "";
+            serializeJson(rsp, ser_json);
+            request->send(errors.size() == 0 ? 200 : 400, kAlpacaJsonType, ser_json);
+        }
+        else
+        {
+            if (root)
+            {
+                _alpaca_server->LockSettings();
+                this->AlpacaReadJson(root);
+                _alpaca_server->UnlockSettings();
+                _alpaca_server->MarkSettingsDirty(this);
+            }
+            request->send(200, F("application/json"), F("{\"recieved\":\"true\"}")); 
+        }
         SLOG_PRINTF(SLOG_INFO, "... END REQ AlpacaDevice::*jsonhandler(%s)\n", request->url().c_str());          
         DBG_END });
-
-    SLOG_PRINTF(SLOG_INFO, "ADD HANDLER jsonhandler for %sr\n", url);
-    _alpaca_server->getServerTCP()->addHandler(jsonhandler);
 }
 
 void AlpacaDevice::_getSetupPage(AsyncWebServerRequest *request)
 {
     _service_counter++;
     SLOG_PRINTF(SLOG_INFO, "REQ url=%s\n", request->url().c_str());
-    _alpaca_server->GetPath(request, kAlpacaSetupPagePath); // TODO setup
+    JsonDocument doc;
+    JsonObject root = doc.to<JsonObject>();
+    JsonDocument schema_doc;
+    JsonObject schema = schema_doc.to<JsonObject>();
+    AlpacaWriteSchema(schema);
+    _alpaca_server->LockSettings();
+    AlpacaWriteJson(root);
+    _alpaca_server->SendSetupPage(request, root, schema);
+    _alpaca_server->UnlockSettings();
 }
 
 void AlpacaDevice::_addAction(const char *const action)
@@ -87,16 +152,25 @@ void AlpacaDevice::_addAction(const char *const action)
     snprintf(&_supported_actions[len - 1], sizeof(_supported_actions) - len - 1, "%s\"%s\"]", len > 2 ? ", " : "", action);
 }
 
+// list cached_value for /metrics
+void AlpacaDevice::_addCachedValue(AlpacaCachedValueBase *cached_value)
+{
+    if (_n_cached_values < kAlpacaMaxCachedValues)
+        _cached_values[_n_cached_values++] = cached_value;
+}
+
 void AlpacaDevice::RegisterCallbacks()
 {
-    this->createCallBack(LHF(AlpacaGetConnected), HTTP_GET, "connected");
-    this->createCallBack(LHF(AlpacaPutConnected), HTTP_PUT, "connected");
-    this->createCallBack(LHF(AlpacaGetDescription), HTTP_GET, "description");
-    this->createCallBack(LHF(AlpacaGetDriverInfo), HTTP_GET, "driverinfo");
-    this->createCallBack(LHF(AlpacaGetDriverVersion), HTTP_GET, "driverversion");
-    this->createCallBack(LHF(AlpacaGetInterfaceVersion), HTTP_GET, "interfaceversion");
-    this->createCallBack(LHF(AlpacaGetName), HTTP_GET, "name");
-    this->createCallBack(LHF(AlpacaGetSupportedActions), HTTP_GET, "supportedactions");
+    // common properties; no driver calls
+    this->createCallBack(LHF(AlpacaGetConnected), HTTP_GET, "connected", false);
+    this->createCallBack(LHF(AlpacaPutConnected), HTTP_PUT, "connected", false);
+    this->createCallBack(LHF(AlpacaGetDescription), HTTP_GET, "description", false);
+    this->createCallBack(LHF(AlpacaGetDriverInfo), HTTP_GET, "driverinfo", false);
+    this->createCallBack(LHF(AlpacaGetDriverVersion), HTTP_GET, "driverversion", false);
+    this->createCallBack(LHF(AlpacaGetInterfaceVersion), HTTP_GET, "interfaceversion", false);
+    this->createCallBack(LHF(AlpacaGetName), HTTP_GET, "name", false);
+    this->createCallBack(LHF(AlpacaGetSupportedActions), HTTP_GET, "supportedactions", false);
+    this->createCallBack(LHF(AlpacaGetChanges), HTTP_GET, "changes", false); // extension
 
     _setSetupPage();
 }
@@ -105,8 +179,8 @@ void AlpacaDevice::SetDeviceNumber(int8_t device_number)
 {
     _device_number = device_number;
     snprintf(_device_url, sizeof(_device_url), kAlpacaDeviceSetup, _device_type, _device_number, "setup"); // TODO
-    snprintf(_device_name, sizeof(_device_name), "%s-%i", _device_type, _device_number);
-    snprintf(_device_uid, sizeof(_device_uid), "%s-%s%02X", _device_type, _alpaca_server->GetUID(), _device_number);
+    snprintf(_general.name, sizeof(_general.name), "%s-%i", _device_type, _device_number);
+    snprintf(_general.uid, sizeof(_general.uid), "%s-%s%02X", _device_type, _alpaca_server->GetUID(), _device_number);
 }
 
 // alpaca commands
@@ -286,7 +360,7 @@ void AlpacaDevice::AlpacaGetDescription(AsyncWebServerRequest *request)
     DBG_DEVICE_GET_DESCRIPTION
     _service_counter++;
     uint32_t client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kIgnoreCase);
-    _alpaca_server->Respond(request, _clients[client_idx], _rsp_status, _device_description, JsonValue_t::kAsJsonStringValue);
+    _alpaca_server->Respond(request, _clients[client_idx], _rsp_status, _general.description, JsonValue_t::kAsJsonStringValue);
     DBG_END
 };
 void AlpacaDevice::AlpacaGetDriverInfo(AsyncWebServerRequest *request)
@@ -330,41 +404,102 @@ void AlpacaDevice::AlpacaGetSupportedActions(AsyncWebServerRequest *request)
     DBG_END
 };
 
+// extension: state keys changed since the sequence number of parameter Since; see AlpacaServer::GetChanges()
+void AlpacaDevice::AlpacaGetChanges(AsyncWebServerRequest *request)
+{
+    _service_counter++;
+    uint32_t since = 0;
+    std::shared_ptr<String> value; // on the heap; the AsyncTCP task has a small stack
+    JsonDocument doc;
+    JsonObject root = doc.to<JsonObject>();
+
+    uint32_t client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kIgnoreCase);
+    if (_rsp_status.error_code != AlpacaErrorCode_t::Ok)
+        goto mycatch;
+    if (!_alpaca_server->GetParam(request, "Since", since, Spelling_t::kIgnoreCase))
+        since = 0;
+
+    _alpaca_server->GetChanges(this, since, root);
+    value = std::make_shared<String>();
+    serializeJson(root, *value);
+    _alpaca_server->RespondChunked(request, _clients[client_idx], _rsp_status, [value, pos = (size_t)0](char *buffer, size_t max_len) mutable -> size_t
+                                   {
+        size_t len = min(max_len, value->length() - pos);
+        memcpy(buffer, value->c_str() + pos, len);
+        pos += len;
+        return len; });
+    return;
+
+mycatch:
+    _alpaca_server->Respond(request, _clients[client_idx], _rsp_status);
+}
+
 void AlpacaDevice::AlpacaReadJson(JsonObject &root)
 {
     DBG_JSON_PRINTFJ(SLOG_NOTICE, root, "BEGIN (root=<%s>) ...\n", _ser_json_);
-    const char *name = root["General"]["Name"];
-    if (name)
-        strlcpy(_device_name, name, sizeof(_device_name));
-    const char *desc = root["General"]["Description"];
-    if (desc)
-        strlcpy(_device_description, desc, sizeof(_device_description));
-
-    SLOG_PRINTF(SLOG_INFO, "... END _device_name=%s _device_desc=%s\n", _device_name, _device_description);
+    AlpacaSettings::Read(kAlpacaDeviceGeneralSettings, root, &_general, _patch_errors);
+    SLOG_PRINTF(SLOG_INFO, "... END name=%s description=%s\n", _general.name, _general.description);
 }
 
 void AlpacaDevice::AlpacaWriteJson(JsonObject &root)
 {
     SLOG_PRINTF(SLOG_INFO, "BEGIN ...\n");
-    // read-only values marked with #
-    // JsonObject obj_general = root.createNestedObject("General");
-    JsonObject obj_general = root["General"].to<JsonObject>();
-    obj_general["Name"] = GetDeviceName();
-    obj_general["Description"] = _device_description;
-    obj_general["UID"] = _device_uid;
+    AlpacaSettings::Write(kAlpacaDeviceGeneralSettings, &_general, root);
     DBG_JSON_PRINTFJ(SLOG_NOTICE, root, "... END root=<%s>\n", _ser_json_);
 }
 
+void AlpacaDevice::AlpacaWriteState(JsonObject &root)
+{
+    root["Connected"] = GetNumberOfConnectedClients() > 0;
+}
+
+void AlpacaDevice::AlpacaWriteSchema(JsonObject &root)
+{
+    AlpacaSettings::Schema(kAlpacaDeviceGeneralSettings, root);
+}
+
+void AlpacaDevice::GeneralSettingsFilter(JsonObject &filter)
+{
+    AlpacaSettings::Filter(kAlpacaDeviceGeneralSettings, filter);
+}
+
+// json schema handler
+void AlpacaDevice::_getSchema(AsyncWebServerRequest *request)
+{
+    SLOG_PRINTF(SLOG_INFO, "BEGIN REQ %s...\n", request->url().c_str());
+    JsonDocument doc;
+    JsonObject root = doc.to<JsonObject>();
+    AlpacaWriteSchema(root);
+    String ser_json = "";
+    serializeJson(root, ser_json);
+    request->send(200, kAlpacaJsonType, ser_json);
+    SLOG_PRINTF(SLOG_INFO, "... END REQ %s\n", request->url().c_str());
+}
+
 // json get handler
 void AlpacaDevice::_getJsondata(AsyncWebServerRequest *request)
 {
     SLOG_PRINTF(SLOG_INFO, "BEGIN REQ %s...\n", request->url().c_str());
+    char etag[40];
     JsonDocument doc;
     JsonObject root = doc.to<JsonObject>();
+    _alpaca_server->LockSettings(); // ETag and values of the same version
+    if (!_alpaca_server->GetSettingsETag(this, AlpacaJsonRevision(), etag, sizeof(etag)))
+    {
+        _alpaca_server->UnlockSettings();
+        request->send(404, "text/plain", "device not added");
+        return;
+    }
+    if (_alpaca_server->SendNotModified(request, etag))
+    {
+        _alpaca_server->UnlockSettings();
+        return;
+    }
     AlpacaWriteJson(root);
+    _alpaca_server->UnlockSettings();
     String ser_json = "";
     serializeJson(root, ser_json);
-    request->send(200, kAlpacaJsonType, ser_json);
+    _alpaca_server->SendJson(request, ser_json, etag);
     DBG_JSON_PRINTFJ(SLOG_NOTICE, root, "..., END ser_json=<%s>\n", _ser_json_);
 }
 
@@ -473,6 +608,17 @@ mycatch:
     return client_idx;
 }
 
+// answer of a request that did not get the driver lock; ClientTransactionID is echoed as usual
+void AlpacaDevice::_respondDriverBusy(AsyncWebServerRequest *request)
+{
+    uint32_t client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kIgnoreCase);
+    SLOG_WARNING_PRINTF("%s - driver busy for %u ms\n", request->url().c_str(), kAlpacaDriverLockTimeoutMs);
+    MYTHROW_RspStatusDriverBusy(request, _rsp_status, kAlpacaDriverLockTimeoutMs);
+
+mycatch:
+    _alpaca_server->Respond(request, _clients[client_idx], _rsp_status);
+}
+
 const uint32_t AlpacaDevice::GetNumberOfConnectedClients()
 {
     uint32_t numberOfConnectedClients = 0;
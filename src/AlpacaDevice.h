@@ -10,6 +10,15 @@
 **************************************************************************************************/
 #pragma once
 #include "AlpacaServer.h"
+#include "AlpacaCachedValue.h"
+
+// "General" settings of every device; described by kAlpacaDeviceGeneralSettings in AlpacaDevice.cpp
+struct AlpacaDeviceGeneral_t
+{
+    char name[33];         // device name - set by config; init with <deviceType>-<deviceNumber>
+    char description[129]; // device description - set by config; init with default from specific device
+    char uid[65];          // unique device id
+};
 
 class AlpacaDevice
 {
@@ -19,12 +28,10 @@ protected:
     // Data defined and requested by Alpaca
     char _device_type[30] = "empty";       // device type
     int32_t _device_interface_version = 0; // device type specific interface version
-    char _device_uid[65] = "";             // unique device id
-    char _device_description[129] = "";    // device description - set by config; init with default from specific device
+    AlpacaDeviceGeneral_t _general = {"", "", ""}; // name, description, uid
     char _device_url[129] = "";            // /api/v1/<deviceType>/<deviceNumber>/setup
 
     int8_t _device_number = -1;            // A0,... for each device_type
-    char _device_name[33] = "";            // device name - set by config; init with <deviceType>-<deviceNumber>
 
     char _device_and_driver_version[32] = "";
     char _driver_info[64] = "";
@@ -34,6 +41,12 @@ protected:
     AlpacaRspStatus_t _rsp_status;
 
     uint32_t _service_counter = 0;
+    AlpacaCachedValueBase *_cached_values[kAlpacaMaxCachedValues] = {nullptr};
+    size_t _n_cached_values = 0;
+    JsonObject _patch_errors; // per-field errors of the PATCH being applied by AlpacaReadJson(); null otherwise
+    SemaphoreHandle_t _driver_mutex = xSemaphoreCreateMutex(); // driver calls of the REST handlers (AsyncTCP task) vs Loop() and the state poll (Loop task)
+
+    void GeneralSettingsFilter(JsonObject &filter); // "General" keys; for AlpacaSettingsFilter() of derived classes
 
     // bool _isconnected = false;
 
@@ -42,10 +55,12 @@ protected:
     virtual void _setSetupPage();
     void _getJsondata(AsyncWebServerRequest *request);
     void _putJsondata(AsyncWebServerRequest *request);
-    void createCallBack(ArRequestHandlerFunction fn, WebRequestMethodComposite type, const char command[]);
+    void _getSchema(AsyncWebServerRequest *request);
+    void createCallBack(ArRequestHandlerFunction fn, WebRequestMethodComposite type, const char command[], bool driver = true);
     void createCallBackUrl(ArRequestHandlerFunction fn, WebRequestMethodComposite type, const char url[], const char handler_name[]);
     void _getSetupPage(AsyncWebServerRequest *request);
     void _addAction(const char *const action);
+    void _addCachedValue(AlpacaCachedValueBase *cached_value);
 
     // alpaca commands
 
@@ -63,9 +78,11 @@ protected:
     void AlpacaGetInterfaceVersion(AsyncWebServerRequest *request);
     void AlpacaGetName(AsyncWebServerRequest *request);
     void AlpacaGetSupportedActions(AsyncWebServerRequest *request);
+    void AlpacaGetChanges(AsyncWebServerRequest *request);
 
     // helpers
     int32_t checkClientDataAndConnection(AsyncWebServerRequest *request, uint32_t &clientIdx, Spelling_t spelling);
+    void _respondDriverBusy(AsyncWebServerRequest *request);
     uint32_t getClientIdxByClientID(uint32_t clientID);
 
 public:
@@ -73,13 +90,26 @@ public:
     void SetAlpacaServer(AlpacaServer *alpaca_server) { _alpaca_server = alpaca_server; }
     void SetDeviceNumber(int8_t device_number);
     void CheckClientConnectionTimeout();
+    virtual void Loop() {};     // called by AlpacaServer::Loop(); overload for periodic device work
     const uint8_t GetDeviceNumber() { return _device_number; }
     const char *GetDeviceType() { return _device_type; }
-    const char *GetDeviceName() { return _device_name; };
-    const char *GetDeviceUID() { return _device_uid; }
+    const char *GetDeviceName() { return _general.name; };
+    const char *GetDeviceUID() { return _general.uid; }
     const char *GetDeviceURL() { return _device_url; };
     virtual void AlpacaReadJson(JsonObject &root);
     virtual void AlpacaWriteJson(JsonObject &root);
+    virtual void AlpacaSettingsFilter(JsonObject &filter) {}; // keys read by AlpacaReadJson(); empty - whole device section; overloads call the base
+    virtual void AlpacaRestoreJson(JsonObject &root) {};      // read-only state saved with the settings; after AlpacaReadJson() on loading or import only
+    virtual void AlpacaWriteSchema(JsonObject &root);         // type, bounds and access of the AlpacaWriteJson() keys
+    virtual uint32_t AlpacaJsonRevision() { return 0; };      // changes with AlpacaWriteJson() values that are no settings
+    virtual void AlpacaWriteState(JsonObject &root);          // state sent by AlpacaServer as event when it changes
+    virtual size_t AlpacaGetMetrics(AlpacaMetric_t *metrics, size_t n) { return 0; }; // device specific metrics; returns count <= n
     const uint32_t GetNumberOfConnectedClients();
     const uint32_t GetServiceCounter() { return _service_counter; };
+    void LockDriver() { xSemaphoreTake(_driver_mutex, portMAX_DELAY); }
+    bool LockDriver(uint32_t timeout_ms) { return xSemaphoreTake(_driver_mutex, pdMS_TO_TICKS(timeout_ms)) == pdTRUE; }
+    bool TryLockDriver() { return xSemaphoreTake(_driver_mutex, 0) == pdTRUE; }
+    void UnlockDriver() { xSemaphoreGive(_driver_mutex); }
+    const size_t GetNumberOfCachedValues() { return _n_cached_values; }
+    AlpacaCachedValueBase *GetCachedValue(size_t i) { return i < _n_cached_values ? _cached_values[i] : nullptr; }
 };
\ No newline at end of file
@@ -8,21 +8,62 @@
 **************************************************************************************************/
 #include "AlpacaDome.h"
 
-const char *const AlpacaDome::kAlpacaShutterStatusStr[5] = {"Open", "Opening", "Closed", "Closing", "Error"};
+const char *const AlpacaDome::kAlpacaShutterStatusStr[5] = {"Open", "Closed", "Opening", "Closing", "Error"};
+
+// "Rotator" section of domes with an azimuth rotator
+static constexpr AlpacaSettingField_t kAlpacaDomeRotatorSettings[] = {
+    ALPACA_SETTING(AlpacaDomeRotatorConfig_t, park_azimuth, "Rotator", "ParkAzimuth", kDouble, 0.0, 359.99, false),
+    ALPACA_SETTING(AlpacaDomeRotatorConfig_t, home_azimuth, "Rotator", "HomeAzimuth", kDouble, 0.0, 359.99, false),
+    ALPACA_SETTING(AlpacaDomeRotatorConfig_t, decel_deg, "Rotator", "Deceleration_deg", kDouble, 0.1, 180.0, false),
+    ALPACA_SETTING(AlpacaDomeRotatorConfig_t, tolerance_deg, "Rotator", "Tolerance_deg", kDouble, 0.01, 10.0, false),
+    ALPACA_SETTING(AlpacaDomeRotatorConfig_t, min_speed, "Rotator", "MinSpeed", kFloat, 0.0, 1.0, false),
+};
+
+// "Slaving" section of domes with an azimuth rotator
+static constexpr AlpacaSettingField_t kAlpacaDomeSlavingSettings[] = {
+    ALPACA_SETTING(AlpacaDomeSlavingConfig_t, latitude_deg, "Slaving", "Latitude_deg", kDouble, -90.0, 90.0, false),
+    ALPACA_SETTING(AlpacaDomeSlavingConfig_t, dome_radius_mm, "Slaving", "DomeRadius_mm", kInt32, 500, 20000, false),
+    ALPACA_SETTING(AlpacaDomeSlavingConfig_t, mount_east_mm, "Slaving", "MountEast_mm", kInt32, -10000, 10000, false),
+    ALPACA_SETTING(AlpacaDomeSlavingConfig_t, mount_north_mm, "Slaving", "MountNorth_mm", kInt32, -10000, 10000, false),
+    ALPACA_SETTING(AlpacaDomeSlavingConfig_t, mount_up_mm, "Slaving", "MountUp_mm", kInt32, -10000, 10000, false),
+    ALPACA_SETTING(AlpacaDomeSlavingConfig_t, dec_offset_mm, "Slaving", "DecAxisOffset_mm", kInt32, -5000, 5000, false),
+    ALPACA_SETTING(AlpacaDomeSlavingConfig_t, deadband_deg, "Slaving", "Deadband_deg", kDouble, 0.0, 45.0, false),
+};
 
 AlpacaDome::AlpacaDome()
 {
     strlcpy(_device_type, ALPACA_DOME_DEVICE_TYPE, sizeof(_device_type));
-    strlcpy(_device_description, ALPACA_DOME_DESCRIPTION, sizeof(_device_description));
+    strlcpy(_general.description, ALPACA_DOME_DESCRIPTION, sizeof(_general.description));
     strlcpy(_driver_info, ALPACA_DOME_DRIVER_INFO, sizeof(_driver_info));
     strlcpy(_device_and_driver_version, esp32_alpaca_device_library_version, sizeof(_device_and_driver_version));
     _device_interface_version = ALPACA_DOME_INTERFACE_VERSION;
+    _addCachedValue(&_slewing_value);
+    _shutter_queue = xQueueCreate(kAlpacaDomeShutterQueueSize, sizeof(AlpacaShutterEvent_t));
 }
 
 void AlpacaDome::Begin()
 {
+    int32_t azimuth = 0;
+    uint16_t flags = 0;
     snprintf(_device_and_driver_version, sizeof(_device_and_driver_version), "%s/%s", _getFirmwareVersion(), esp32_alpaca_device_library_version);
     AlpacaDevice::Begin();
+
+    // initial shutter state from the event posted by the driver or from _getShutter()
+    if (_shutter_events)
+        _shutterTick();
+    else
+    {
+        _shutter_state = _getShutter();
+        _shutter_move_ms = millis(); // a travel in progress is timed from here
+    }
+
+    // azimuth of the rotator from before the reset; saves a homing run
+    if (_rotator != nullptr && _alpaca_server != nullptr &&
+        _alpaca_server->GetPositionJournal().Read(AlpacaPositionJournal::Key(AlpacaPositionJournalKind_t::kDomeAzimuth, GetDeviceNumber()), azimuth, flags))
+    {
+        _rotator->Restore((double)azimuth / 100.0, (flags & 0x01) != 0);
+        SLOG_INFO_PRINTF("dome azimuth %.2f restored\n", (double)azimuth / 100.0);
+    }
 }
 
 void AlpacaDome::RegisterCallbacks()
@@ -67,6 +108,7 @@ void AlpacaDome::RegisterCallbacks()
 	this->createCallBack(LHF(_alpacaGetSlaved ), HTTP_GET, "slaved");
 	this->createCallBack(LHF(_alpacaPutSlaved ), HTTP_PUT, "slaved");
 	this->createCallBack(LHF(_alpacaGetSlewing ), HTTP_GET, "slewing");
+	this->createCallBack(LHF(_alpacaPutMountPointing ), HTTP_PUT, "mountpointing"); // extension
 }
 
 void AlpacaDome::_alpacaPutAbortSlew(AsyncWebServerRequest *request)
@@ -80,13 +122,18 @@ void AlpacaDome::_alpacaPutAbortSlew(AsyncWebServerRequest *request)
         goto mycatch;
 
     _slewing = false;
-    _shutter_state = AlpacaShutterStatus_t::kError;
+    _parking = false;
+    _slaved = false;
+    if (_rotator != nullptr)
+        _rotator->Abort();
     if( false == _putAbort()) {
+        _shutterEvent(AlpacaShutterEvent_t::kFault);
         MYTHROW_RspStatusDriverError( request, _rsp_status, "Abort" );
     }
-
+    _shutterEvent(AlpacaShutterEvent_t::kStopped);
 
 mycatch:
+    _slewing_value.Invalidate();
     _alpaca_server->Respond(request, _clients[client_idx], _rsp_status);
     //DBG_END
 }
@@ -102,14 +149,15 @@ void AlpacaDome::_alpacaPutCloseShutter(AsyncWebServerRequest *request)
         goto mycatch;
         
     _slewing = true;
-	_shutter_state = AlpacaShutterStatus_t::kClosing;
+    _shutterMove(AlpacaShutterStatus_t::kClosing); // before the driver call, so its limit event follows
     if( false == _putClose()) {
         _slewing = false;
-	    _shutter_state = AlpacaShutterStatus_t::kError;
+        _shutterEvent(AlpacaShutterEvent_t::kFault);
         MYTHROW_RspStatusDriverError( request, _rsp_status, "CloseShutter" );
     }
 
 mycatch:
+    _slewing_value.Invalidate();
     _alpaca_server->Respond(request, _clients[client_idx], _rsp_status);
     //DBG_END
 }
@@ -120,10 +168,18 @@ void AlpacaDome::_alpacaPutFindHome(AsyncWebServerRequest *request)
     _service_counter++;
     uint32_t client_idx = 0;    
     _alpaca_server->RspStatusClear(_rsp_status);
-    client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kStrict);
-    MYTHROW_RspStatusCommandNotImplemented(request, _rsp_status, "FindHome");
+
+    if ((client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kStrict)) == 0)
+        goto mycatch;
+    if (_rotator == nullptr)
+        MYTHROW_RspStatusCommandNotImplemented(request, _rsp_status, "FindHome");
+
+    _parking = false;
+    _slaved = false;
+    _rotator->FindHome();
 
 mycatch:
+    _slewing_value.Invalidate();
     _alpaca_server->Respond(request, _clients[client_idx], _rsp_status);
     //DBG_END
 }
@@ -139,14 +195,15 @@ void AlpacaDome::_alpacaPutOpenShutter(AsyncWebServerRequest *request)
         goto mycatch;
         
     _slewing = true;
-	_shutter_state = AlpacaShutterStatus_t::kOpening;
+    _shutterMove(AlpacaShutterStatus_t::kOpening); // before the driver call, so its limit event follows
     if( false == _putOpen()) {
         _slewing = false;
-	    _shutter_state = AlpacaShutterStatus_t::kError;
+        _shutterEvent(AlpacaShutterEvent_t::kFault);
         MYTHROW_RspStatusDriverError( request, _rsp_status, "OpenShutter" );
     }
 
 mycatch:
+    _slewing_value.Invalidate();
     _alpaca_server->Respond(request, _clients[client_idx], _rsp_status);
     //DBG_END
 }
@@ -157,10 +214,18 @@ void AlpacaDome::_alpacaPutPark(AsyncWebServerRequest *request)
     _service_counter++;
     uint32_t client_idx = 0;    
     _alpaca_server->RspStatusClear(_rsp_status);
-    client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kStrict);
-    MYTHROW_RspStatusCommandNotImplemented(request, _rsp_status, "Park");
+
+    if ((client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kStrict)) == 0)
+        goto mycatch;
+    if (_rotator == nullptr)
+        MYTHROW_RspStatusCommandNotImplemented(request, _rsp_status, "Park");
+
+    _parking = true; // AtPark when the slew to the park azimuth is done
+    _slaved = false;
+    _rotator->SlewTo(_rotator->GetConfig().park_azimuth);
 
 mycatch:
+    _slewing_value.Invalidate();
     _alpaca_server->Respond(request, _clients[client_idx], _rsp_status);
     //DBG_END
 }
@@ -171,8 +236,18 @@ void AlpacaDome::_alpacaPutSetPark(AsyncWebServerRequest *request)
     _service_counter++;
     uint32_t client_idx = 0;    
     _alpaca_server->RspStatusClear(_rsp_status);
-    client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kStrict);
-    MYTHROW_RspStatusCommandNotImplemented(request, _rsp_status, "SetPark");
+    AlpacaDomeRotatorConfig_t config;
+
+    if ((client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kStrict)) == 0)
+        goto mycatch;
+    if (_rotator == nullptr)
+        MYTHROW_RspStatusCommandNotImplemented(request, _rsp_status, "SetPark");
+
+    config = _rotator->GetConfig();
+    config.park_azimuth = _rotator->GetAzimuth();
+    _rotator->SetConfig(config);
+    _alpaca_server->MarkSettingsDirty(this);
+    SLOG_INFO_PRINTF("park azimuth %.1f\n", config.park_azimuth);
 
 mycatch:
     _alpaca_server->Respond(request, _clients[client_idx], _rsp_status);
@@ -199,10 +274,24 @@ void AlpacaDome::_alpacaPutSlewToAzimuth(AsyncWebServerRequest *request)
     _service_counter++;
     uint32_t client_idx = 0;    
     _alpaca_server->RspStatusClear(_rsp_status);
-    client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kStrict);
-    MYTHROW_RspStatusCommandNotImplemented(request, _rsp_status, "SlewToAzimuth");
+    double azimuth = 0.0;
+
+    if ((client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kStrict)) == 0)
+        goto mycatch;
+    if (_rotator == nullptr)
+        MYTHROW_RspStatusCommandNotImplemented(request, _rsp_status, "SlewToAzimuth");
+    if (_slaved)
+        MYTHROW_RspStatusInvalidWhileSlaved(request, _rsp_status, "SlewToAzimuth");
+    if (_alpaca_server->GetParam(request, "Azimuth", azimuth, Spelling_t::kStrict) == false)
+        MYTHROW_RspStatusParameterNotFound(request, _rsp_status, "Azimuth");
+    if (!(azimuth >= 0.0 && azimuth < 360.0))
+        MYTHROW_RspStatusParameterInvalidDoubleValue(request, _rsp_status, "Azimuth", azimuth);
+
+    _parking = false;
+    _rotator->SlewTo(azimuth);
 
 mycatch:
+    _slewing_value.Invalidate();
     _alpaca_server->Respond(request, _clients[client_idx], _rsp_status);
     //DBG_END
 }
@@ -213,8 +302,19 @@ void AlpacaDome::_alpacaPutSyncToAzimuth(AsyncWebServerRequest *request)
     _service_counter++;
     uint32_t client_idx = 0;    
     _alpaca_server->RspStatusClear(_rsp_status);
-    client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kStrict);
-    MYTHROW_RspStatusCommandNotImplemented(request, _rsp_status, "SyncToAzimuth");
+    double azimuth = 0.0;
+
+    if ((client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kStrict)) == 0)
+        goto mycatch;
+    if (_rotator == nullptr)
+        MYTHROW_RspStatusCommandNotImplemented(request, _rsp_status, "SyncToAzimuth");
+    if (_alpaca_server->GetParam(request, "Azimuth", azimuth, Spelling_t::kStrict) == false)
+        MYTHROW_RspStatusParameterNotFound(request, _rsp_status, "Azimuth");
+    if (!(azimuth >= 0.0 && azimuth < 360.0))
+        MYTHROW_RspStatusParameterInvalidDoubleValue(request, _rsp_status, "Azimuth", azimuth);
+
+    _parking = false;
+    _rotator->Sync(azimuth);
 
 mycatch:
     _alpaca_server->Respond(request, _clients[client_idx], _rsp_status);
@@ -241,8 +341,14 @@ void AlpacaDome::_alpacaGetAtHome(AsyncWebServerRequest *request)
     _service_counter++;
     uint32_t client_idx = 0;    
     _alpaca_server->RspStatusClear(_rsp_status);
-    client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kStrict);
-    MYTHROW_RspStatusCommandNotImplemented(request, _rsp_status, "AtHome");
+
+    if ((client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kIgnoreCase)) == 0)
+        goto mycatch;
+    if (_rotator == nullptr)
+        MYTHROW_RspStatusCommandNotImplemented(request, _rsp_status, "AtHome");
+
+    _alpaca_server->Respond(request, _clients[client_idx], _rsp_status, _atHome());
+    return;
 
 mycatch:
     _alpaca_server->Respond(request, _clients[client_idx], _rsp_status);
@@ -255,8 +361,14 @@ void AlpacaDome::_alpacaGetAtPark(AsyncWebServerRequest *request)
     _service_counter++;
     uint32_t client_idx = 0;    
     _alpaca_server->RspStatusClear(_rsp_status);
-    client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kStrict);
-    MYTHROW_RspStatusCommandNotImplemented(request, _rsp_status, "AtPark");
+
+    if ((client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kIgnoreCase)) == 0)
+        goto mycatch;
+    if (_rotator == nullptr)
+        MYTHROW_RspStatusCommandNotImplemented(request, _rsp_status, "AtPark");
+
+    _alpaca_server->Respond(request, _clients[client_idx], _rsp_status, _atPark());
+    return;
 
 mycatch:
     _alpaca_server->Respond(request, _clients[client_idx], _rsp_status);
@@ -269,8 +381,14 @@ void AlpacaDome::_alpacaGetAzimuth(AsyncWebServerRequest *request)
     _service_counter++;
     uint32_t client_idx = 0;    
     _alpaca_server->RspStatusClear(_rsp_status);
-    client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kStrict);
-    MYTHROW_RspStatusCommandNotImplemented(request, _rsp_status, "GetAzimuth");
+
+    if ((client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kIgnoreCase)) == 0)
+        goto mycatch;
+    if (_rotator == nullptr)
+        MYTHROW_RspStatusCommandNotImplemented(request, _rsp_status, "GetAzimuth");
+
+    _alpaca_server->Respond(request, _clients[client_idx], _rsp_status, _rotator->GetAzimuth());
+    return;
 
 mycatch:
     _alpaca_server->Respond(request, _clients[client_idx], _rsp_status);
@@ -286,7 +404,7 @@ void AlpacaDome::_alpacaGetCanFindHome(AsyncWebServerRequest *request)
 
     if (client_idx > 0)
 	{
-		_alpaca_server->Respond(request, _clients[client_idx], _rsp_status, false);
+		_alpaca_server->Respond(request, _clients[client_idx], _rsp_status, _rotator != nullptr);
 	} else {
 		MYTHROW_RspStatusClientIDInvalid(request, _rsp_status, client_idx);
         mycatch:
@@ -304,7 +422,7 @@ void AlpacaDome::_alpacaGetCanPark(AsyncWebServerRequest *request)
 
     if (client_idx > 0)
 	{
-		_alpaca_server->Respond(request, _clients[client_idx], _rsp_status, false);
+		_alpaca_server->Respond(request, _clients[client_idx], _rsp_status, _rotator != nullptr);
 	} else {
 		MYTHROW_RspStatusClientIDInvalid(request, _rsp_status, client_idx);
         mycatch:
@@ -340,7 +458,7 @@ void AlpacaDome::_alpacaGetCanSetAzimuth(AsyncWebServerRequest *request)
 
     if (client_idx > 0)
 	{
-		_alpaca_server->Respond(request, _clients[client_idx], _rsp_status, false);
+		_alpaca_server->Respond(request, _clients[client_idx], _rsp_status, _rotator != nullptr);
 	} else {
 		MYTHROW_RspStatusClientIDInvalid(request, _rsp_status, client_idx);
         mycatch:
@@ -358,7 +476,7 @@ void AlpacaDome::_alpacaGetCanSetPark(AsyncWebServerRequest *request)
 
     if (client_idx > 0)
 	{
-		_alpaca_server->Respond(request, _clients[client_idx], _rsp_status, false);
+		_alpaca_server->Respond(request, _clients[client_idx], _rsp_status, _rotator != nullptr);
 	} else {
 		MYTHROW_RspStatusClientIDInvalid(request, _rsp_status, client_idx);
         mycatch:
@@ -394,7 +512,7 @@ void AlpacaDome::_alpacaGetCanSlave(AsyncWebServerRequest *request)
 
     if (client_idx > 0)
 	{
-		_alpaca_server->Respond(request, _clients[client_idx], _rsp_status, false);
+		_alpaca_server->Respond(request, _clients[client_idx], _rsp_status, _rotator != nullptr);
 	} else {
 		MYTHROW_RspStatusClientIDInvalid(request, _rsp_status, client_idx);
         mycatch:
@@ -412,7 +530,7 @@ void AlpacaDome::_alpacaGetCanSyncAzimuth(AsyncWebServerRequest *request)
 
     if (client_idx > 0)
 	{
-		_alpaca_server->Respond(request, _clients[client_idx], _rsp_status, false);
+		_alpaca_server->Respond(request, _clients[client_idx], _rsp_status, _rotator != nullptr);
 	} else {
 		MYTHROW_RspStatusClientIDInvalid(request, _rsp_status, client_idx);
         mycatch:
@@ -431,7 +549,7 @@ void AlpacaDome::_alpacaGetShutterStatus(AsyncWebServerRequest *request)
     uint32_t client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kIgnoreCase);
     if (client_idx > 0)
     {
-        _shut = _getShutter();
+        _shut = _shutter_state;
     }
     _alpaca_server->Respond(request, _clients[client_idx], _rsp_status, (int32_t)_shut);
     //DBG_END
@@ -446,7 +564,7 @@ void AlpacaDome::_alpacaGetSlaved(AsyncWebServerRequest *request)
 
     if (client_idx > 0)
 	{
-		_alpaca_server->Respond(request, _clients[client_idx], _rsp_status, false);
+		_alpaca_server->Respond(request, _clients[client_idx], _rsp_status, _slaved);
 	} else {
 		MYTHROW_RspStatusClientIDInvalid(request, _rsp_status, client_idx);
         mycatch:
@@ -461,14 +579,93 @@ void AlpacaDome::_alpacaPutSlaved(AsyncWebServerRequest *request)
     _service_counter++;
     uint32_t client_idx = 0;    
     _alpaca_server->RspStatusClear(_rsp_status);
-    client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kStrict);
-    MYTHROW_RspStatusCommandNotImplemented(request, _rsp_status, "Slaved");
+    bool slaved = false;
+
+    if ((client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kStrict)) == 0)
+        goto mycatch;
+    if (_alpaca_server->GetParam(request, "Slaved", slaved, Spelling_t::kStrict) == false)
+        MYTHROW_RspStatusParameterNotFound(request, _rsp_status, "Slaved");
+    if (slaved && _rotator == nullptr)
+        MYTHROW_RspStatusCommandNotImplemented(request, _rsp_status, "Slaved");
+
+    if (slaved != _slaved)
+        SLOG_INFO_PRINTF("slaved %s\n", slaved ? "true" : "false");
+    _slaved = slaved;
+    _slave_target_valid = false;
 
 mycatch:
     _alpaca_server->Respond(request, _clients[client_idx], _rsp_status);
     //DBG_END
 }
 
+// extension: pointing of the mount for slaving; Altitude and Azimuth, HourAngle and Declination or
+// RightAscension, Declination and SiderealTime; optional SideOfPier (ASCOM PierSide) and Tracking
+void AlpacaDome::_alpacaPutMountPointing(AsyncWebServerRequest *request)
+{
+    _service_counter++;
+    uint32_t client_idx = 0;
+    _alpaca_server->RspStatusClear(_rsp_status);
+    double altitude = 0.0;
+    double azimuth = 0.0;
+    double hour_angle = 0.0;
+    double right_ascension = 0.0;
+    double declination = 0.0;
+    double sidereal_time = 0.0;
+    int32_t side_of_pier = (int32_t)AlpacaPierSide_t::kUnknown;
+    AlpacaPierSide_t pier = AlpacaPierSide_t::kUnknown;
+    bool tracking = true;
+
+    if ((client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kStrict)) == 0)
+        goto mycatch;
+    if (_rotator == nullptr)
+        MYTHROW_RspStatusCommandNotImplemented(request, _rsp_status, "MountPointing");
+
+    _alpaca_server->GetParam(request, "SideOfPier", side_of_pier, Spelling_t::kStrict);
+    if (side_of_pier < -1 || side_of_pier > 1)
+        MYTHROW_RspStatusParameterInvalidInt32Value(request, _rsp_status, "SideOfPier", side_of_pier);
+    pier = (AlpacaPierSide_t)side_of_pier;
+    _alpaca_server->GetParam(request, "Tracking", tracking, Spelling_t::kStrict);
+
+    if (_alpaca_server->GetParam(request, "Altitude", altitude, Spelling_t::kStrict))
+    {
+        if (_alpaca_server->GetParam(request, "Azimuth", azimuth, Spelling_t::kStrict) == false)
+            MYTHROW_RspStatusParameterNotFound(request, _rsp_status, "Azimuth");
+        if (!(altitude >= -90.0 && altitude <= 90.0))
+            MYTHROW_RspStatusParameterInvalidDoubleValue(request, _rsp_status, "Altitude", altitude);
+        if (!(azimuth >= 0.0 && azimuth < 360.0))
+            MYTHROW_RspStatusParameterInvalidDoubleValue(request, _rsp_status, "Azimuth", azimuth);
+        _slaving.SetPointingAltAz(altitude, azimuth, pier, tracking);
+    }
+    else
+    {
+        if (_alpaca_server->GetParam(request, "Declination", declination, Spelling_t::kStrict) == false)
+            MYTHROW_RspStatusParameterNotFound(request, _rsp_status, "Declination");
+        if (!(declination >= -90.0 && declination <= 90.0))
+            MYTHROW_RspStatusParameterInvalidDoubleValue(request, _rsp_status, "Declination", declination);
+        if (_alpaca_server->GetParam(request, "HourAngle", hour_angle, Spelling_t::kStrict))
+        {
+            if (!(hour_angle >= -12.0 && hour_angle <= 24.0))
+                MYTHROW_RspStatusParameterInvalidDoubleValue(request, _rsp_status, "HourAngle", hour_angle);
+            _slaving.SetPointingHaDec(hour_angle, declination, pier, tracking);
+        }
+        else
+        {
+            if (_alpaca_server->GetParam(request, "RightAscension", right_ascension, Spelling_t::kStrict) == false)
+                MYTHROW_RspStatusParameterNotFound(request, _rsp_status, "RightAscension");
+            if (_alpaca_server->GetParam(request, "SiderealTime", sidereal_time, Spelling_t::kStrict) == false)
+                MYTHROW_RspStatusParameterNotFound(request, _rsp_status, "SiderealTime");
+            if (!(right_ascension >= 0.0 && right_ascension < 24.0))
+                MYTHROW_RspStatusParameterInvalidDoubleValue(request, _rsp_status, "RightAscension", right_ascension);
+            if (!(sidereal_time >= 0.0 && sidereal_time < 24.0))
+                MYTHROW_RspStatusParameterInvalidDoubleValue(request, _rsp_status, "SiderealTime", sidereal_time);
+            _slaving.SetPointingRaDec(right_ascension, declination, sidereal_time, pier, tracking);
+        }
+    }
+
+mycatch:
+    _alpaca_server->Respond(request, _clients[client_idx], _rsp_status);
+}
+
 void AlpacaDome::_alpacaGetSlewing(AsyncWebServerRequest *request)
 {
     //DBG_DOME_GET_SLEWING
@@ -478,7 +675,7 @@ void AlpacaDome::_alpacaGetSlewing(AsyncWebServerRequest *request)
     uint32_t client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kIgnoreCase);
     if (client_idx > 0)
     {
-        _slewing = _getSlewing();
+        _slewing = _isSlewing();
     }
     _alpaca_server->Respond(request, _clients[client_idx], _rsp_status, (bool)_slewing);
     //DBG_END
@@ -586,3 +783,253 @@ mycatch:
     DBG_END
 };
 #endif
+
+// state for the events of AlpacaServer
+void AlpacaDome::AlpacaWriteState(JsonObject &root)
+{
+    AlpacaDevice::AlpacaWriteState(root);
+    root["ShutterStatus"] = (int32_t)_shutter_state;
+    root["Slewing"] = _isSlewing();
+    if (_rotator != nullptr)
+    {
+        root["Azimuth"] = _rotator->GetAzimuth();
+        root["AtHome"] = _atHome();
+        root["AtPark"] = _atPark();
+        root["Slaved"] = _slaved;
+    }
+}
+
+bool AlpacaDome::_isSlewing()
+{
+    return _slewing_value.Get([this]() { return _getSlewing(); }) || (_rotator != nullptr && _rotator->IsSlewing());
+}
+
+bool AlpacaDome::_atHome()
+{
+    return _rotator->IsHomed() && _rotator->AtAzimuth(_rotator->GetConfig().home_azimuth);
+}
+
+// only after Park(); any other movement clears it
+bool AlpacaDome::_atPark()
+{
+    return _parking && _rotator->AtAzimuth(_rotator->GetConfig().park_azimuth);
+}
+
+void AlpacaDome::AlpacaReadJson(JsonObject &root)
+{
+    AlpacaDevice::AlpacaReadJson(root);
+    if (_rotator == nullptr)
+        return;
+    AlpacaDomeRotatorConfig_t config = _rotator->GetConfig();
+    AlpacaSettings::Read(kAlpacaDomeRotatorSettings, root, &config, _patch_errors);
+    _rotator->SetConfig(config);
+    AlpacaDomeSlavingConfig_t slaving = _slaving.GetConfig();
+    AlpacaSettings::Read(kAlpacaDomeSlavingSettings, root, &slaving, _patch_errors);
+    _slaving.SetConfig(slaving);
+}
+
+void AlpacaDome::AlpacaWriteJson(JsonObject &root)
+{
+    AlpacaDevice::AlpacaWriteJson(root);
+    if (_rotator == nullptr)
+        return;
+    AlpacaSettings::Write(kAlpacaDomeRotatorSettings, &_rotator->GetConfig(), root);
+    AlpacaSettings::Write(kAlpacaDomeSlavingSettings, &_slaving.GetConfig(), root);
+}
+
+void AlpacaDome::AlpacaSettingsFilter(JsonObject &filter)
+{
+    GeneralSettingsFilter(filter);
+    if (_rotator == nullptr)
+        return;
+    AlpacaSettings::Filter(kAlpacaDomeRotatorSettings, filter);
+    AlpacaSettings::Filter(kAlpacaDomeSlavingSettings, filter);
+}
+
+void AlpacaDome::AlpacaWriteSchema(JsonObject &root)
+{
+    AlpacaDevice::AlpacaWriteSchema(root);
+    if (_rotator == nullptr)
+        return;
+    AlpacaSettings::Schema(kAlpacaDomeRotatorSettings, root);
+    AlpacaSettings::Schema(kAlpacaDomeSlavingSettings, root);
+}
+
+// control loop of the rotator and slaving solver
+size_t AlpacaDome::AlpacaGetMetrics(AlpacaMetric_t *metrics, size_t n)
+{
+    if (_rotator == nullptr || n < 10)
+        return 0;
+    AlpacaDomeRotatorStats_t stats;
+    _rotator->GetStats(stats);
+    metrics[0] = {"dome_rotator_ticks_total", "counter", stats.ticks};
+    metrics[1] = {"dome_rotator_ticks_over_budget_total", "counter", stats.ticks_over_budget};
+    metrics[2] = {"dome_rotator_jitter_max_us", "gauge", stats.jitter_max_us};
+    metrics[3] = {"dome_rotator_jitter_mean_us", "gauge", stats.jitter_mean_us};
+    metrics[4] = {"dome_rotator_tick_max_us", "gauge", stats.tick_max_us};
+    AlpacaDomeSlavingStats_t slaving;
+    _slaving.GetStats(slaving);
+    metrics[5] = {"dome_slaving_updates_total", "counter", slaving.updates};
+    metrics[6] = {"dome_slaving_slews_total", "counter", _slave_slews};
+    metrics[7] = {"dome_slaving_solve_max_us", "gauge", slaving.solve_max_us};
+    metrics[8] = {"dome_slaving_solve_mean_us", "gauge", slaving.solve_mean_us};
+    metrics[9] = {"dome_slaving_error_max_mdeg", "gauge", slaving.error_max_mdeg};
+    return 10;
+}
+
+// shutter starts travelling; driver accepted open or close
+void AlpacaDome::_shutterMove(AlpacaShutterStatus_t moving)
+{
+    portENTER_CRITICAL(&_shutter_mux);
+    _shutter_state = moving;
+    _shutter_move_ms = millis();
+    _shutter_stalled = false;
+    portEXIT_CRITICAL(&_shutter_mux);
+}
+
+void AlpacaDome::_shutterEvent(AlpacaShutterEvent_t event)
+{
+    AlpacaShutterStatus_t old_state = _shutter_state;
+    portENTER_CRITICAL(&_shutter_mux);
+    switch (event)
+    {
+    case AlpacaShutterEvent_t::kOpenLimit:
+        _shutter_state = AlpacaShutterStatus_t::kOpen;
+        _shutter_stalled = false;
+        break;
+    case AlpacaShutterEvent_t::kClosedLimit:
+        _shutter_state = AlpacaShutterStatus_t::kClosed;
+        _shutter_stalled = false;
+        break;
+    case AlpacaShutterEvent_t::kStopped:
+        if (_shutter_state == AlpacaShutterStatus_t::kOpening || _shutter_state == AlpacaShutterStatus_t::kClosing)
+            _shutter_state = AlpacaShutterStatus_t::kError; // stopped half way
+        break;
+    case AlpacaShutterEvent_t::kFault:
+        _shutter_state = AlpacaShutterStatus_t::kError;
+        break;
+    }
+    portEXIT_CRITICAL(&_shutter_mux);
+    if (_shutter_state != old_state)
+        SLOG_PRINTF(SLOG_INFO, "shutter %s -> %s (event %d)\n", GetShutterStatusStr(old_state), GetShutterStatusStr(_shutter_state), (int)event);
+}
+
+// driver event from a task
+bool AlpacaDome::ShutterEvent(AlpacaShutterEvent_t event)
+{
+    _shutter_events = true;
+    return _shutter_queue != nullptr && xQueueSend(_shutter_queue, &event, 0) == pdTRUE;
+}
+
+// driver event from an ISR, e.g. limit switch
+bool IRAM_ATTR AlpacaDome::ShutterEventFromISR(AlpacaShutterEvent_t event)
+{
+    BaseType_t woken = pdFALSE;
+    _shutter_events = true;
+    bool result = _shutter_queue != nullptr && xQueueSendFromISR(_shutter_queue, &event, &woken) == pdTRUE;
+    if (woken)
+        portYIELD_FROM_ISR();
+    return result;
+}
+
+/**
+ * Periodic tick of the shutter state machine: handle queued driver events, poll _getShutter() of
+ * drivers without events and report a travel exceeding the timeout as kError
+ */
+void AlpacaDome::_shutterTick()
+{
+    AlpacaShutterEvent_t event;
+    while (_shutter_queue != nullptr && xQueueReceive(_shutter_queue, &event, 0) == pdTRUE)
+        _shutterEvent(event);
+
+    uint32_t now = millis();
+    if (!_shutter_events && (now - _shutter_poll_ms) >= kAlpacaDomeShutterPollMs)
+    {
+        _shutter_poll_ms = now;
+        AlpacaShutterStatus_t state = _getShutter();
+        bool moving = (state == AlpacaShutterStatus_t::kOpening || state == AlpacaShutterStatus_t::kClosing);
+        if (state == AlpacaShutterStatus_t::kOpen)
+            _shutterEvent(AlpacaShutterEvent_t::kOpenLimit);
+        else if (state == AlpacaShutterStatus_t::kClosed)
+            _shutterEvent(AlpacaShutterEvent_t::kClosedLimit);
+        else if (state == AlpacaShutterStatus_t::kError)
+            _shutterEvent(AlpacaShutterEvent_t::kFault);
+        else if (moving && state != _shutter_state && !_shutter_stalled)
+            _shutterMove(state);
+    }
+
+    if ((_shutter_state == AlpacaShutterStatus_t::kOpening || _shutter_state == AlpacaShutterStatus_t::kClosing) && (now - _shutter_move_ms) > _shutter_timeout_ms)
+    {
+        SLOG_WARNING_PRINTF("shutter %s stalled; no limit after %u ms\n", GetShutterStatusStr(_shutter_state), _shutter_timeout_ms);
+        _shutter_stalled = true;
+        _shutterEvent(AlpacaShutterEvent_t::kFault);
+    }
+}
+
+/**
+ * Slaved dome: target azimuth of the mount pointing every kAlpacaDomeSlavingPeriodMs. A slew starts
+ * when the target moves out of the deadband around the current target, or around the azimuth
+ * once the dome is at rest
+ */
+void AlpacaDome::_slaveTick()
+{
+    uint32_t now = millis();
+    if (!_slaved || _rotator == nullptr || (now - _slave_ms) < kAlpacaDomeSlavingPeriodMs)
+        return;
+    _slave_ms = now;
+
+    uint16_t target;
+    if (!_slaving.Update(target))
+        return;
+    uint16_t deadband = AlpacaFixedTrig::FromDeg(_slaving.GetConfig().deadband_deg);
+    uint16_t azimuth = AlpacaFixedTrig::FromDeg(_rotator->GetAzimuth());
+    bool retarget = _slave_target_valid && abs((int16_t)(target - _slave_target)) > deadband;
+    bool resting = !_rotator->IsSlewing() && abs((int16_t)(target - azimuth)) > deadband;
+    if (!_slave_target_valid || retarget || resting)
+    {
+        _slave_target = target;
+        _slave_target_valid = true;
+        _slave_slews++;
+        _rotator->SlewTo(AlpacaFixedTrig::ToDeg(target));
+        _slewing_value.Invalidate();
+    }
+}
+
+void AlpacaDome::Loop()
+{
+    _shutterTick();
+    if (_rotator != nullptr)
+        _rotator->Loop();
+    _slaveTick();
+    _journalTick();
+}
+
+// azimuth to the position journal once settled at rest; changes up to one encoder count are
+// flicker and not written
+void AlpacaDome::_journalTick()
+{
+    if (_rotator == nullptr || _alpaca_server == nullptr)
+        return;
+    if (_rotator->GetMode() != AlpacaDomeRotatorMode_t::kIdle)
+    {
+        _journal_idle_ms = millis();
+        return;
+    }
+    if (millis() - _journal_idle_ms < kAlpacaDomeJournalSettleMs)
+        return;
+
+    AlpacaPositionJournal &journal = _alpaca_server->GetPositionJournal();
+    uint16_t key = AlpacaPositionJournal::Key(AlpacaPositionJournalKind_t::kDomeAzimuth, GetDeviceNumber());
+    int32_t azimuth = (int32_t)lround(_rotator->GetAzimuth() * 100.0); // [0.01 deg]
+    uint16_t flags = _rotator->IsHomed() ? 0x01 : 0x00;
+    int32_t journaled = 0;
+    uint16_t journaled_flags = 0;
+    if (journal.Read(key, journaled, journaled_flags) && journaled_flags == flags)
+    {
+        int32_t deadband = (int32_t)ceil(36000.0 / (double)_rotator->GetCountsPerRev()); // one count
+        int32_t diff = abs(azimuth - journaled) % 36000;
+        if (min(diff, 36000 - diff) <= deadband)
+            return;
+    }
+    journal.Write(key, azimuth, flags);
+}
@@ -6,6 +6,8 @@
 **************************************************************************************************/
 #pragma once
 #include "AlpacaDevice.h"
+#include "AlpacaDomeRotator.h"
+#include "AlpacaDomeSlaving.h"
 
 // ASCOM  / ALPACA ShutterStatus Enumeration
 enum struct AlpacaShutterStatus_t
@@ -17,12 +19,47 @@ enum struct AlpacaShutterStatus_t
   kError
 };
 
+// shutter events of the driver; see AlpacaDome::ShutterEvent()
+enum struct AlpacaShutterEvent_t : uint8_t
+{
+  kOpenLimit,   // open limit reached
+  kClosedLimit, // closed limit reached
+  kStopped,     // stopped between the limits
+  kFault        // driver or motor fault
+};
+
 class AlpacaDome : public AlpacaDevice
 {
 private:
-	AlpacaShutterStatus_t _shutter_state = AlpacaShutterStatus_t::kError;
+	// shutter state machine; changed by commands, driver events and the travel timeout
+	portMUX_TYPE _shutter_mux = portMUX_INITIALIZER_UNLOCKED;
+	volatile AlpacaShutterStatus_t _shutter_state = AlpacaShutterStatus_t::kError;
+	QueueHandle_t _shutter_queue = nullptr; // driver events, also from ISR
+	uint32_t _shutter_move_ms = 0;          // start of the current travel
+	uint32_t _shutter_timeout_ms = ALPACA_DOME_SHUTTER_TIMEOUT_MS;
+	uint32_t _shutter_poll_ms = 0;
+	volatile bool _shutter_events = false;  // driver posts events; _getShutter() is not polled
+	bool _shutter_stalled = false;
 	static const char *const kAlpacaShutterStatusStr[5];
 	bool _slewing = false;
+	AlpacaDomeRotator *_rotator = nullptr; // azimuth; nullptr - only the shutter
+	uint32_t _journal_idle_ms = 0;         // latest motion of the rotator
+	bool _parking = false;
+	AlpacaDomeSlaving _slaving;
+	bool _slaved = false;
+	uint16_t _slave_target = 0;          // binary angle of the latest slaving slew
+	bool _slave_target_valid = false;
+	uint32_t _slave_ms = 0;
+	uint32_t _slave_slews = 0;
+
+	void _shutterMove(AlpacaShutterStatus_t moving);
+	void _shutterEvent(AlpacaShutterEvent_t event);
+	void _shutterTick();
+	void _slaveTick();
+	void _journalTick();
+	bool _isSlewing();
+	bool _atHome();
+	bool _atPark();
 
     void _alpacaPutAbortSlew(AsyncWebServerRequest *request);
     void _alpacaPutCloseShutter(AsyncWebServerRequest *request);
@@ -49,6 +86,7 @@ private:
 	void _alpacaGetSlaved(AsyncWebServerRequest *request);
 	void _alpacaPutSlaved(AsyncWebServerRequest *request);
 	void _alpacaGetSlewing(AsyncWebServerRequest *request);
+	void _alpacaPutMountPointing(AsyncWebServerRequest *request);
 
 #ifdef ALPACA_DOME_PUT_ACTION_IMPLEMENTED
     void AlpacaPutAction(AsyncWebServerRequest *request);
@@ -68,16 +106,35 @@ private:
 	virtual const bool _putAbort() = 0;		// must be implemented in TSBoard
 	virtual const bool _putClose() = 0;
 	virtual const bool _putOpen() = 0;
-	virtual const AlpacaShutterStatus_t _getShutter() = 0;
+	// only polled while the driver posts no events; default: state of the state machine
+	virtual const AlpacaShutterStatus_t _getShutter() { return _shutter_state; };
 	virtual const bool _getSlewing() = 0;
     
 protected:
+    AlpacaCachedValue<bool> _slewing_value{"Slewing", ALPACA_DOME_STATUS_TTL_MS};
+
     AlpacaDome();
     void Begin();
     void RegisterCallbacks();
 
+    // shutter events of the driver, e.g. limit switches; handled by Loop()
+    // a driver with events posts the initial state before AlpacaDome::Begin(); others are polled by _getShutter()
+    bool ShutterEvent(AlpacaShutterEvent_t event);
+    bool IRAM_ATTR ShutterEventFromISR(AlpacaShutterEvent_t event);
+    void SetShutterTimeout(uint32_t timeout_ms) { _shutter_timeout_ms = timeout_ms; }; // max travel time
+    const char *GetShutterStatusStr(AlpacaShutterStatus_t state) { return kAlpacaShutterStatusStr[(uint32_t)state]; };
+    // azimuth rotation; enables slewtoazimuth, synctoazimuth, findhome, park and setpark
+    void SetRotator(AlpacaDomeRotator *rotator) { _rotator = rotator; };
+
 
 public:
+    void Loop(); // derived classes overloading Loop() must call AlpacaDome::Loop()
+    void AlpacaWriteState(JsonObject &root);
+    void AlpacaReadJson(JsonObject &root);
+    void AlpacaWriteJson(JsonObject &root);
+    void AlpacaSettingsFilter(JsonObject &filter); // General, Rotator and Slaving; overloads call it and add their keys
+    void AlpacaWriteSchema(JsonObject &root);
+    size_t AlpacaGetMetrics(AlpacaMetric_t *metrics, size_t n);
     //void _alpacaGetPage(AsyncWebServerRequest *request, const char* const page);
 
 };
\ No newline at end of file
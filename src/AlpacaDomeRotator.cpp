@@ -0,0 +1,278 @@
+/**************************************************************************************************
+  Filename:       AlpacaDomeRotator.cpp
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 02 $
+  Description:    Azimuth rotation engine of AlpacaDome
+**************************************************************************************************/
+#include "AlpacaDomeRotator.h"
+#include "AlpacaDebug.h"
+
+// x2 decoding on both edges of A; swap A and B if the direction is reversed
+void IRAM_ATTR AlpacaDomeRotator::_encoderISR(void *arg)
+{
+    AlpacaDomeRotator *rotator = (AlpacaDomeRotator *)arg;
+    bool a = digitalRead(rotator->_pin_a);
+    bool b = digitalRead(rotator->_pin_b);
+    rotator->_counts = rotator->_counts + (a != b ? 1 : -1);
+}
+
+void IRAM_ATTR AlpacaDomeRotator::_homeISR(void *arg)
+{
+    ((AlpacaDomeRotator *)arg)->HomeSensor();
+}
+
+void AlpacaDomeRotator::Begin(AlpacaDomeMotor *motor, int32_t counts_per_rev, int8_t pin_a, int8_t pin_b, int8_t pin_home)
+{
+    _motor = motor;
+    _counts_per_rev = counts_per_rev > 0 ? counts_per_rev : 1;
+    _pin_a = pin_a;
+    _pin_b = pin_b;
+    if (pin_a >= 0 && pin_b >= 0)
+    {
+        pinMode(pin_a, INPUT_PULLUP);
+        pinMode(pin_b, INPUT_PULLUP);
+        attachInterruptArg(digitalPinToInterrupt(pin_a), _encoderISR, this, CHANGE);
+    }
+    if (pin_home >= 0)
+    {
+        pinMode(pin_home, INPUT_PULLUP);
+        attachInterruptArg(digitalPinToInterrupt(pin_home), _homeISR, this, FALLING);
+    }
+
+    _last_counts = _counts;
+    _last_tick_us = esp_timer_get_time();
+    _moved_us = _last_tick_us;
+
+    esp_timer_create_args_t args = {};
+    args.callback = _timerCallback;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "rotator";
+    args.skip_unhandled_events = true;
+    if (_timer == nullptr && esp_timer_create(&args, &_timer) != ESP_OK)
+    {
+        _timer = nullptr;
+        SLOG_ERROR_PRINTF("rotator timer not created\n");
+        return;
+    }
+    esp_timer_start_periodic(_timer, kAlpacaDomeRotatorPeriodUs);
+    SLOG_INFO_PRINTF("rotator %d counts/rev, tick %u us\n", _counts_per_rev, kAlpacaDomeRotatorPeriodUs);
+}
+
+int32_t AlpacaDomeRotator::_relCounts(int32_t counts) const
+{
+    int32_t rel = (counts - _zero) % _counts_per_rev;
+    return rel < 0 ? rel + _counts_per_rev : rel;
+}
+
+int32_t AlpacaDomeRotator::_position() const
+{
+    portENTER_CRITICAL(&_mux);
+    int32_t rel = _relCounts(_counts);
+    portEXIT_CRITICAL(&_mux);
+    return rel;
+}
+
+int32_t AlpacaDomeRotator::_azimuthToCounts(double azimuth) const
+{
+    azimuth = fmod(azimuth, 360.0);
+    if (azimuth < 0.0)
+        azimuth += 360.0;
+    return (int32_t)lround(azimuth * (double)_counts_per_rev / 360.0) % _counts_per_rev;
+}
+
+// signed distance from -> to across 0/360; (-rev/2, rev/2]
+int32_t AlpacaDomeRotator::_shortestPath(int32_t from, int32_t to) const
+{
+    int32_t d = (to - from) % _counts_per_rev;
+    if (d > _counts_per_rev / 2)
+        d -= _counts_per_rev;
+    else if (d <= -_counts_per_rev / 2)
+        d += _counts_per_rev;
+    return d;
+}
+
+void AlpacaDomeRotator::_command(AlpacaDomeRotatorMode_t mode, int32_t target)
+{
+    portENTER_CRITICAL(&_mux);
+    _mode = mode;
+    _target = target;
+    _start_counts = _counts;
+    _moved_us = esp_timer_get_time(); // stall detection starts now
+    portEXIT_CRITICAL(&_mux);
+}
+
+void AlpacaDomeRotator::SlewTo(double azimuth)
+{
+    _command(AlpacaDomeRotatorMode_t::kSlewing, _azimuthToCounts(azimuth));
+    SLOG_INFO_PRINTF("rotator slew %.1f -> %.1f\n", GetAzimuth(), azimuth);
+}
+
+void AlpacaDomeRotator::Sync(double azimuth)
+{
+    portENTER_CRITICAL(&_mux);
+    _zero = _counts - _azimuthToCounts(azimuth);
+    portEXIT_CRITICAL(&_mux);
+    SLOG_INFO_PRINTF("rotator sync %.1f\n", azimuth);
+}
+
+void AlpacaDomeRotator::Restore(double azimuth, bool homed)
+{
+    Sync(azimuth);
+    _homed = homed;
+}
+
+void AlpacaDomeRotator::FindHome()
+{
+    _home_seen = false;
+    _command(AlpacaDomeRotatorMode_t::kHoming, 0);
+    SLOG_INFO_PRINTF("rotator find home\n");
+}
+
+void AlpacaDomeRotator::Abort()
+{
+    _command(AlpacaDomeRotatorMode_t::kIdle, _target); // motor is stopped by the next tick
+}
+
+void AlpacaDomeRotator::Loop()
+{
+    portENTER_CRITICAL(&_mux);
+    const char *fault = _fault;
+    int32_t counts = _fault_counts;
+    _fault = nullptr;
+    portEXIT_CRITICAL(&_mux);
+    if (fault != nullptr)
+        SLOG_WARNING_PRINTF("rotator %s at %.1f\n", fault, (double)counts * 360.0 / (double)_counts_per_rev);
+}
+
+bool AlpacaDomeRotator::AtAzimuth(double azimuth) const
+{
+    int32_t tolerance = (int32_t)lround(_config.tolerance_deg * (double)_counts_per_rev / 360.0);
+    return !IsSlewing() && abs(_shortestPath(_position(), _azimuthToCounts(azimuth))) <= max(tolerance, (int32_t)1);
+}
+
+void AlpacaDomeRotator::SetConfig(const AlpacaDomeRotatorConfig_t &config)
+{
+    portENTER_CRITICAL(&_mux);
+    _config = config;
+    portEXIT_CRITICAL(&_mux);
+}
+
+void AlpacaDomeRotator::GetStats(AlpacaDomeRotatorStats_t &stats)
+{
+    portENTER_CRITICAL(&_mux);
+    stats = _stats;
+    stats.jitter_mean_us = _stats.ticks > 0 ? (uint32_t)(_jitter_sum_us / _stats.ticks) : 0;
+    portEXIT_CRITICAL(&_mux);
+}
+
+/**
+ * Control tick in the esp_timer task: velocity estimate, homing, shortest path slew with
+ * deceleration before the target, settling and stall detection. The interval to the previous
+ * tick and the execution time are measured against the jitter budget. A fault is only recorded;
+ * Loop() logs it.
+ */
+void AlpacaDomeRotator::_tick()
+{
+    int64_t now_us = esp_timer_get_time();
+    uint32_t interval_us = (uint32_t)(now_us - _last_tick_us);
+    uint32_t jitter_us = interval_us > kAlpacaDomeRotatorPeriodUs ? interval_us - kAlpacaDomeRotatorPeriodUs : kAlpacaDomeRotatorPeriodUs - interval_us;
+    _last_tick_us = now_us;
+
+    if (_motor != nullptr)
+        _motor->Tick(interval_us);
+
+    int32_t counts = _counts;
+    int32_t delta = counts - _last_counts;
+    _last_counts = counts;
+    if (interval_us > 0)
+        _velocity += kAlpacaDomeRotatorVelocityAlpha * ((float)delta * 1000000.0f / (float)interval_us - _velocity);
+
+    portENTER_CRITICAL(&_mux);
+    AlpacaDomeRotatorConfig_t config = _config;
+    portEXIT_CRITICAL(&_mux);
+    int32_t tolerance = max((int32_t)lround(config.tolerance_deg * (double)_counts_per_rev / 360.0), (int32_t)1);
+    int32_t decel = max((int32_t)lround(config.decel_deg * (double)_counts_per_rev / 360.0), (int32_t)1);
+    const char *fault = nullptr;
+    float speed = 0.0f;
+
+    portENTER_CRITICAL(&_mux);
+    if (delta != 0)
+        _moved_us = now_us;
+    AlpacaDomeRotatorMode_t mode = _mode;
+    int32_t err = _shortestPath(_relCounts(counts), _target);
+
+    switch (mode)
+    {
+    case AlpacaDomeRotatorMode_t::kHoming:
+        if (_home_seen)
+        {
+            // the sensor edge is at home_azimuth; then go back to it
+            _zero = _home_counts - _azimuthToCounts(config.home_azimuth);
+            _homed = true;
+            _target = _azimuthToCounts(config.home_azimuth);
+            mode = AlpacaDomeRotatorMode_t::kSlewing;
+        }
+        else if (abs(counts - _start_counts) > _counts_per_rev + _counts_per_rev / 10)
+        {
+            fault = "home not found";
+            mode = AlpacaDomeRotatorMode_t::kFault;
+        }
+        else
+        {
+            speed = kAlpacaDomeRotatorHomingSpeed;
+        }
+        break;
+    case AlpacaDomeRotatorMode_t::kSlewing:
+        if (abs(err) <= tolerance)
+        {
+            mode = AlpacaDomeRotatorMode_t::kSettling;
+        }
+        else
+        {
+            float magnitude = abs(err) >= decel ? 1.0f : max(config.min_speed, (float)abs(err) / (float)decel);
+            speed = err > 0 ? magnitude : -magnitude;
+        }
+        break;
+    case AlpacaDomeRotatorMode_t::kSettling:
+        // coasting after the stop; slew again if it overshot
+        if ((now_us - _moved_us) >= kAlpacaDomeRotatorSettleUs)
+            mode = abs(err) <= tolerance ? AlpacaDomeRotatorMode_t::kIdle : AlpacaDomeRotatorMode_t::kSlewing;
+        break;
+    default:
+        break;
+    }
+
+    if (speed != 0.0f && (now_us - _moved_us) > kAlpacaDomeRotatorStallUs)
+    {
+        fault = "stalled";
+        mode = AlpacaDomeRotatorMode_t::kFault;
+        speed = 0.0f;
+    }
+    if (mode != _mode)
+    {
+        if (mode == AlpacaDomeRotatorMode_t::kSlewing)
+            _moved_us = now_us;
+        _mode = mode;
+    }
+    if (fault != nullptr)
+    {
+        _fault = fault; // logged by Loop(); the timer task must not block on the log
+        _fault_counts = _relCounts(counts);
+    }
+    portEXIT_CRITICAL(&_mux);
+
+    if (speed != _speed && _motor != nullptr)
+        _motor->Drive(speed);
+    _speed = speed;
+
+    uint32_t tick_us = (uint32_t)(esp_timer_get_time() - now_us);
+    portENTER_CRITICAL(&_mux);
+    _stats.ticks++;
+    _jitter_sum_us += jitter_us;
+    _stats.jitter_max_us = max(_stats.jitter_max_us, jitter_us);
+    _stats.tick_max_us = max(_stats.tick_max_us, tick_us);
+    if (jitter_us > kAlpacaDomeRotatorJitterBudgetUs || tick_us > kAlpacaDomeRotatorJitterBudgetUs)
+        _stats.ticks_over_budget++;
+    portEXIT_CRITICAL(&_mux);
+}
@@ -0,0 +1,133 @@
+/**************************************************************************************************
+  Filename:       AlpacaDomeRotator.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 02 $
+  Description:    Azimuth rotation engine of AlpacaDome
+
+  The dome position is counted by an encoder - quadrature ISR or EncoderStep() of a simulated
+  motor. A periodic esp_timer tick estimates the velocity and drives the motor backend along the
+  shortest path to the target, slowing down in the deceleration zone before it. The motor backend
+  is only called from the tick; the tick does not log, its faults are logged by Loop(). The encoder
+  counts are read lock-free (single writer, aligned 32 bit reads are atomic); the azimuth is
+  counts and zero of the same instant, read under the mux.
+**************************************************************************************************/
+#pragma once
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "AlpacaConfig.h"
+
+// motor of the rotator; all calls from the control tick of AlpacaDomeRotator
+class AlpacaDomeMotor
+{
+public:
+    virtual ~AlpacaDomeMotor() {};
+    virtual void Drive(float speed) = 0;  // -1.0 full speed ccw,..., 0 stop,..., +1.0 full speed cw
+    virtual void Tick(uint32_t dt_us) {}; // before each control step; e.g. simulated motor moves the encoder
+};
+
+enum struct AlpacaDomeRotatorMode_t : uint8_t
+{
+    kIdle = 0,
+    kSlewing,  // driving to the target
+    kSettling, // target reached, motor stopped; waiting for standstill
+    kHoming,   // driving cw until the home sensor
+    kFault     // stalled or home not found; cleared by the next command
+};
+
+// "Rotator" settings of AlpacaDome
+struct AlpacaDomeRotatorConfig_t
+{
+    double park_azimuth;  // [deg]
+    double home_azimuth;  // azimuth of the home sensor [deg]
+    double decel_deg;     // speed is reduced linearly within this distance to the target
+    double tolerance_deg; // target reached
+    float min_speed;      // lowest speed in the deceleration zone; overcomes friction
+};
+
+// control loop statistics for /metrics
+struct AlpacaDomeRotatorStats_t
+{
+    uint32_t ticks;
+    uint32_t ticks_over_budget; // started later than period + jitter budget or ran longer than the budget
+    uint32_t jitter_max_us;     // max |interval - period|
+    uint32_t jitter_mean_us;
+    uint32_t tick_max_us;       // max execution time of a tick
+};
+
+class AlpacaDomeRotator
+{
+private:
+    AlpacaDomeMotor *_motor = nullptr;
+    esp_timer_handle_t _timer = nullptr;
+    int8_t _pin_a = -1;
+    int8_t _pin_b = -1;
+    int32_t _counts_per_rev = 3600;
+    AlpacaDomeRotatorConfig_t _config = {0.0, 0.0, 10.0, 0.5, 0.1f};
+
+    // encoder; written by the ISR or EncoderStep() only
+    volatile int32_t _counts = 0;
+    volatile int32_t _home_counts = 0;  // counts at the latest home sensor edge
+    volatile bool _home_seen = false;
+    bool _homed = false;
+
+    // commands; set by the server task, executed by the tick
+    mutable portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+    volatile int32_t _zero = 0;         // counts at azimuth 0; under _mux, written by Sync() and the homing tick
+    volatile AlpacaDomeRotatorMode_t _mode = AlpacaDomeRotatorMode_t::kIdle;
+    int32_t _target = 0;                // relative to _zero; [0, _counts_per_rev)
+    int32_t _start_counts = 0;          // homing start
+
+    // control tick
+    float _velocity = 0.0f;             // low pass estimate [counts/s]
+    float _speed = 0.0f;                // latest motor command
+    int32_t _last_counts = 0;
+    int64_t _last_tick_us = 0;
+    int64_t _moved_us = 0;              // latest encoder counts or command
+    AlpacaDomeRotatorStats_t _stats = {0, 0, 0, 0, 0};
+    uint64_t _jitter_sum_us = 0;
+    const char *_fault = nullptr;       // fault of the tick not logged yet; under _mux
+    int32_t _fault_counts = 0;          // position of the fault relative to _zero
+
+    static void IRAM_ATTR _encoderISR(void *arg);
+    static void IRAM_ATTR _homeISR(void *arg);
+    static void _timerCallback(void *arg) { ((AlpacaDomeRotator *)arg)->_tick(); }
+    void _tick();
+    void _command(AlpacaDomeRotatorMode_t mode, int32_t target);
+
+    int32_t _relCounts(int32_t counts) const; // counts relative to _zero; [0, _counts_per_rev); under _mux
+    int32_t _position() const;                // _counts relative to _zero
+    int32_t _azimuthToCounts(double azimuth) const;
+    int32_t _shortestPath(int32_t from, int32_t to) const;
+
+public:
+    // starts the control tick; pin_a/pin_b - quadrature encoder; pin_home - home sensor, active low
+    // pins < 0: counts come from EncoderStep() and HomeSensor(), e.g. by a simulated motor
+    void Begin(AlpacaDomeMotor *motor, int32_t counts_per_rev, int8_t pin_a = -1, int8_t pin_b = -1, int8_t pin_home = -1);
+
+    void SlewTo(double azimuth);
+    void Sync(double azimuth); // current position is azimuth
+    void Restore(double azimuth, bool homed); // position from before a reset
+    void FindHome();
+    void Abort();
+    void Loop(); // logs the faults of the tick; called by the loop task
+
+    double GetAzimuth() const { return (double)_position() * 360.0 / (double)_counts_per_rev; };
+    int32_t GetCountsPerRev() const { return _counts_per_rev; };
+    float GetVelocity() const { return _velocity * 360.0f / (float)_counts_per_rev; }; // [deg/s]
+    AlpacaDomeRotatorMode_t GetMode() const { return _mode; };
+    bool IsSlewing() const { return _mode == AlpacaDomeRotatorMode_t::kSlewing || _mode == AlpacaDomeRotatorMode_t::kSettling || _mode == AlpacaDomeRotatorMode_t::kHoming; };
+    bool IsHomed() const { return _homed; };
+    bool AtAzimuth(double azimuth) const; // at rest within tolerance
+
+    void SetConfig(const AlpacaDomeRotatorConfig_t &config);
+    const AlpacaDomeRotatorConfig_t &GetConfig() const { return _config; };
+    void GetStats(AlpacaDomeRotatorStats_t &stats);
+
+    // encoder input of custom encoders and simulated motors; not together with encoder pins
+    void IRAM_ATTR EncoderStep(int32_t delta) { _counts = _counts + delta; };
+    void IRAM_ATTR HomeSensor()
+    {
+        _home_counts = _counts;
+        _home_seen = true;
+    };
+};
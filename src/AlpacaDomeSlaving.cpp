@@ -0,0 +1,238 @@
+/**************************************************************************************************
+  Filename:       AlpacaDomeSlaving.cpp
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Dome slaving - dome azimuth of the mount pointing
+**************************************************************************************************/
+#include "AlpacaDomeSlaving.h"
+#include <esp_timer.h>
+#include "AlpacaDebug.h"
+
+static const uint64_t kAlpacaSiderealDayMs = 86164091;
+static const int64_t kPositionScale = 256; // positions of the solver in 1/256 mm; azimuth stays resolved close to the zenith
+
+int32_t AlpacaFixedTrig::_sin[1025];
+uint16_t AlpacaFixedTrig::_atan[257];
+bool AlpacaFixedTrig::_initialized = false;
+
+void AlpacaFixedTrig::Init()
+{
+    if (_initialized)
+        return;
+    for (int i = 0; i <= 1024; i++)
+        _sin[i] = (int32_t)lround(sin(i * M_PI / 2048.0) * kOne);
+    for (int i = 0; i <= 256; i++)
+        _atan[i] = (uint16_t)lround(atan(i / 256.0) * 32768.0 / M_PI);
+    _initialized = true;
+}
+
+int32_t AlpacaFixedTrig::Sin(uint16_t angle)
+{
+    uint32_t quadrant = angle >> 14;
+    uint32_t x = angle & 0x3fff;
+    if (quadrant & 1)
+        x = 0x4000 - x; // falling half of the quarter wave
+    uint32_t i = x >> 4;
+    int32_t frac = x & 0x0f;
+    int32_t value = i < 1024 ? _sin[i] + (((_sin[i + 1] - _sin[i]) * frac) >> 4) : _sin[1024];
+    return quadrant & 2 ? -value : value;
+}
+
+// octant reduction to atan(k/256) in [0, 45] deg
+uint16_t AlpacaFixedTrig::Atan2(int64_t y, int64_t x)
+{
+    if (x == 0 && y == 0)
+        return 0;
+    uint64_t ax = x < 0 ? -x : x;
+    uint64_t ay = y < 0 ? -y : y;
+    bool swap = ay > ax;
+    uint64_t ratio = swap ? (ax << 16) / ay : (ay << 16) / ax; // [0, 0x10000]
+    uint32_t i = (uint32_t)(ratio >> 8);
+    int32_t frac = (int32_t)(ratio & 0xff);
+    int32_t angle = i < 256 ? _atan[i] + ((((int32_t)_atan[i + 1] - (int32_t)_atan[i]) * frac) >> 8) : _atan[256];
+    if (swap)
+        angle = 0x4000 - angle;
+    if (x < 0)
+        angle = 0x8000 - angle;
+    if (y < 0)
+        angle = -angle;
+    return (uint16_t)angle;
+}
+
+uint64_t AlpacaFixedTrig::Sqrt(uint64_t x)
+{
+    uint64_t result = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+    while (bit > x)
+        bit >>= 2;
+    while (bit != 0)
+    {
+        if (x >= result + bit)
+        {
+            x -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else
+        {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return result;
+}
+
+AlpacaDomeSlaving::AlpacaDomeSlaving()
+{
+    AlpacaFixedTrig::Init();
+    SetConfig(_config);
+}
+
+// precompute the latitude terms and the dome radius; the latitude is not rounded to a binary angle,
+// 0.003 deg of latitude moves the slit of a 20 m dome by 1 mm
+void AlpacaDomeSlaving::SetConfig(const AlpacaDomeSlavingConfig_t &config)
+{
+    double latitude = config.latitude_deg * M_PI / 180.0;
+    portENTER_CRITICAL(&_mux);
+    _config = config;
+    _sin_lat = (int32_t)lround(sin(latitude) * AlpacaFixedTrig::kOne);
+    _cos_lat = (int32_t)lround(cos(latitude) * AlpacaFixedTrig::kOne);
+    _radius2 = ((int64_t)config.dome_radius_mm * kPositionScale) * ((int64_t)config.dome_radius_mm * kPositionScale);
+    portEXIT_CRITICAL(&_mux);
+}
+
+void AlpacaDomeSlaving::_setPointing(uint16_t ha, uint16_t dec, AlpacaPierSide_t pier, bool tracking)
+{
+    portENTER_CRITICAL(&_mux);
+    _ha = ha;
+    _dec = dec;
+    _pier = pier;
+    _tracking = tracking;
+    _pointing_ms = millis();
+    _valid = true;
+    portEXIT_CRITICAL(&_mux);
+}
+
+void AlpacaDomeSlaving::SetPointingHaDec(double ha_hours, double dec_deg, AlpacaPierSide_t pier, bool tracking)
+{
+    _setPointing(AlpacaFixedTrig::FromDeg(ha_hours * 15.0), AlpacaFixedTrig::FromDeg(dec_deg), pier, tracking);
+}
+
+void AlpacaDomeSlaving::SetPointingRaDec(double ra_hours, double dec_deg, double sidereal_time_hours, AlpacaPierSide_t pier, bool tracking)
+{
+    SetPointingHaDec(sidereal_time_hours - ra_hours, dec_deg, pier, tracking);
+}
+
+// horizon to equatorial frame: sin(dec) = sin(lat) u + cos(lat) n, cos(dec) cos(ha) = cos(lat) u - sin(lat) n, cos(dec) sin(ha) = -e
+void AlpacaDomeSlaving::SetPointingAltAz(double alt_deg, double az_deg, AlpacaPierSide_t pier, bool tracking)
+{
+    uint16_t alt = AlpacaFixedTrig::FromDeg(alt_deg);
+    uint16_t az = AlpacaFixedTrig::FromDeg(az_deg);
+    int64_t ca = AlpacaFixedTrig::Cos(alt);
+    int64_t v_e = (ca * AlpacaFixedTrig::Sin(az)) >> 30;
+    int64_t v_n = (ca * AlpacaFixedTrig::Cos(az)) >> 30;
+    int64_t v_u = AlpacaFixedTrig::Sin(alt);
+    int64_t sd = (_sin_lat * v_u + _cos_lat * v_n) >> 30;
+    int64_t cd_ch = (_cos_lat * v_u - _sin_lat * v_n) >> 30;
+    uint16_t ha = AlpacaFixedTrig::Atan2(-v_e, cd_ch);
+    uint16_t dec = AlpacaFixedTrig::Atan2(sd, (int64_t)AlpacaFixedTrig::Sqrt((uint64_t)(v_e * v_e + cd_ch * cd_ch)));
+    _setPointing(ha, dec, pier, tracking);
+}
+
+/**
+ * Dome azimuth of the optical axis: aperture p = pivot + Dec axis offset, axis v; p + t v is on
+ * the dome sphere for t^2 + 2 b t + c = 0 with b = p.v, c = |p|^2 - r^2
+ */
+uint16_t AlpacaDomeSlaving::Solve(uint16_t ha, uint16_t dec, AlpacaPierSide_t pier) const
+{
+    int64_t sh = AlpacaFixedTrig::Sin(ha);
+    int64_t ch = AlpacaFixedTrig::Cos(ha);
+    int64_t sd = AlpacaFixedTrig::Sin(dec);
+    int64_t cd = AlpacaFixedTrig::Cos(dec);
+    int64_t cd_ch = (cd * ch) >> 30;
+
+    // optical axis, Q30
+    int64_t v_e = -((cd * sh) >> 30);
+    int64_t v_n = (_cos_lat * sd - _sin_lat * cd_ch) >> 30;
+    int64_t v_u = (_sin_lat * sd + _cos_lat * cd_ch) >> 30;
+
+    // Dec axis at ha - 90 deg (east side of the pier) or ha + 90 deg (west side)
+    if (pier == AlpacaPierSide_t::kUnknown)
+        pier = (int16_t)ha >= 0 ? AlpacaPierSide_t::kEast : AlpacaPierSide_t::kWest;
+    int64_t offset = (int64_t)(pier == AlpacaPierSide_t::kEast ? _config.dec_offset_mm : -_config.dec_offset_mm) * kPositionScale;
+    int64_t p_e = ((int64_t)_config.mount_east_mm * kPositionScale) + ((offset * ch) >> 30);
+    int64_t p_n = ((int64_t)_config.mount_north_mm * kPositionScale) - ((((offset * _sin_lat) >> 30) * sh) >> 30);
+    int64_t p_u = ((int64_t)_config.mount_up_mm * kPositionScale) + ((((offset * _cos_lat) >> 30) * sh) >> 30);
+
+    int64_t b = (p_e * v_e + p_n * v_n + p_u * v_u) >> 30;
+    int64_t c = p_e * p_e + p_n * p_n + p_u * p_u - _radius2;
+    int64_t disc = b * b - c;
+    int64_t t = -b + (int64_t)AlpacaFixedTrig::Sqrt(disc > 0 ? (uint64_t)disc : 0);
+    return AlpacaFixedTrig::Atan2(p_e + ((t * v_e) >> 30), p_n + ((t * v_n) >> 30));
+}
+
+double AlpacaDomeSlaving::SolveReference(double ha_deg, double dec_deg, AlpacaPierSide_t pier) const
+{
+    double ha = ha_deg * M_PI / 180.0;
+    double dec = dec_deg * M_PI / 180.0;
+    double lat = _config.latitude_deg * M_PI / 180.0;
+    double v_e = -cos(dec) * sin(ha);
+    double v_n = cos(lat) * sin(dec) - sin(lat) * cos(dec) * cos(ha);
+    double v_u = sin(lat) * sin(dec) + cos(lat) * cos(dec) * cos(ha);
+    if (pier == AlpacaPierSide_t::kUnknown)
+        pier = fmod(ha_deg + 360.0, 360.0) < 180.0 ? AlpacaPierSide_t::kEast : AlpacaPierSide_t::kWest;
+    double offset = pier == AlpacaPierSide_t::kEast ? _config.dec_offset_mm : -_config.dec_offset_mm;
+    double p_e = _config.mount_east_mm + offset * cos(ha);
+    double p_n = _config.mount_north_mm - offset * sin(lat) * sin(ha);
+    double p_u = _config.mount_up_mm + offset * cos(lat) * sin(ha);
+    double b = p_e * v_e + p_n * v_n + p_u * v_u;
+    double c = p_e * p_e + p_n * p_n + p_u * p_u - (double)_config.dome_radius_mm * _config.dome_radius_mm;
+    double t = -b + sqrt(max(b * b - c, 0.0));
+    double az = atan2(p_e + t * v_e, p_n + t * v_n) * 180.0 / M_PI;
+    return az < 0.0 ? az + 360.0 : az;
+}
+
+// solve the latest pointing, advanced by the sidereal rate while tracking; measures cost and, every
+// kAlpacaDomeSlavingCheckEvery updates, the deviation from the double precision solve
+bool AlpacaDomeSlaving::Update(uint16_t &azimuth)
+{
+    portENTER_CRITICAL(&_mux);
+    bool valid = _valid;
+    uint16_t ha = _ha;
+    uint16_t dec = _dec;
+    AlpacaPierSide_t pier = _pier;
+    bool tracking = _tracking;
+    uint32_t pointing_ms = _pointing_ms;
+    portEXIT_CRITICAL(&_mux);
+    if (!valid)
+        return false;
+    if (tracking)
+        ha += (uint16_t)((uint64_t)(millis() - pointing_ms) * 65536 / kAlpacaSiderealDayMs);
+
+    int64_t start_us = esp_timer_get_time();
+    azimuth = Solve(ha, dec, pier);
+    uint32_t solve_us = (uint32_t)(esp_timer_get_time() - start_us);
+
+    uint32_t error_mdeg = 0;
+    bool check = (_stats.updates % kAlpacaDomeSlavingCheckEvery) == 0;
+    if (check)
+    {
+        uint16_t reference = AlpacaFixedTrig::FromDeg(SolveReference(AlpacaFixedTrig::ToDeg(ha), AlpacaFixedTrig::ToDeg(dec), pier));
+        error_mdeg = (uint32_t)abs((int16_t)(azimuth - reference)) * 360000 / 65536;
+    }
+
+    portENTER_CRITICAL(&_mux);
+    _stats.updates++;
+    _solve_sum_us += solve_us;
+    _stats.solve_max_us = max(_stats.solve_max_us, solve_us);
+    _stats.error_max_mdeg = max(_stats.error_max_mdeg, error_mdeg);
+    portEXIT_CRITICAL(&_mux);
+    return true;
+}
+
+void AlpacaDomeSlaving::GetStats(AlpacaDomeSlavingStats_t &stats)
+{
+    portENTER_CRITICAL(&_mux);
+    stats = _stats;
+    stats.solve_mean_us = _stats.updates > 0 ? (uint32_t)(_solve_sum_us / _stats.updates) : 0;
+    portEXIT_CRITICAL(&_mux);
+}
@@ -0,0 +1,106 @@
+/**************************************************************************************************
+  Filename:       AlpacaDomeSlaving.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Dome slaving - dome azimuth of the mount pointing
+
+  The mount pushes its pointing (HA/Dec, RA/Dec with sidereal time or Alt/Az); it is kept as
+  HA/Dec and advanced at the sidereal rate while tracking. The slit azimuth is where the optical
+  axis leaves the dome sphere: the aperture sits at the mount pivot (offset from the dome center)
+  plus the Dec axis offset of a GEM, on the side of the pier. All per-update math is fixed point
+  with table trig; the geometry terms are precomputed by SetConfig().
+
+  Conventions: east, north, up [mm] relative to the dome center at the spring line; binary
+  angles 0x10000 = 360 deg; Q30 values 0x40000000 = 1.0. A telescope on the east side of the pier
+  (kEast) has its optical axis east of the RA axis when pointing at the meridian.
+**************************************************************************************************/
+#pragma once
+#include <Arduino.h>
+#include "AlpacaConfig.h"
+
+// fixed point trig with linear interpolated tables; Init() once before use
+class AlpacaFixedTrig
+{
+private:
+    static int32_t _sin[1025];  // quarter wave, Q30
+    static uint16_t _atan[257];  // atan(k/256), binary angle
+    static bool _initialized;
+
+public:
+    static const int32_t kOne = 0x40000000;
+    static void Init();
+    static int32_t Sin(uint16_t angle);
+    static int32_t Cos(uint16_t angle) { return Sin((uint16_t)(angle + 0x4000)); };
+    static uint16_t Atan2(int64_t y, int64_t x);
+    static uint64_t Sqrt(uint64_t x);
+    static uint16_t FromDeg(double deg) { return (uint16_t)(int32_t)lround(fmod(deg, 360.0) * 65536.0 / 360.0); };
+    static double ToDeg(uint16_t angle) { return (double)angle * 360.0 / 65536.0; };
+};
+
+// ASCOM PierSide
+enum struct AlpacaPierSide_t : int8_t
+{
+    kUnknown = -1, // derived from the hour angle
+    kEast = 0,
+    kWest = 1
+};
+
+// "Slaving" settings of AlpacaDome
+struct AlpacaDomeSlavingConfig_t
+{
+    double latitude_deg;
+    int32_t dome_radius_mm;
+    int32_t mount_east_mm;  // intersection of RA and Dec axis
+    int32_t mount_north_mm;
+    int32_t mount_up_mm;
+    int32_t dec_offset_mm;  // optical axis to RA axis along the Dec axis; 0 - fork or alt-az mount
+    double deadband_deg;    // no slew while the dome is closer than this to the target
+};
+
+// solver statistics for /metrics
+struct AlpacaDomeSlavingStats_t
+{
+    uint32_t updates;
+    uint32_t solve_max_us;    // cost of one fixed point solve
+    uint32_t solve_mean_us;
+    uint32_t error_max_mdeg;  // max deviation from the double precision solve [0.001 deg]
+};
+
+class AlpacaDomeSlaving
+{
+private:
+    AlpacaDomeSlavingConfig_t _config = {0.0, 2500, 0, 0, 0, 0, 3.0};
+    int32_t _sin_lat = 0;     // Q30
+    int32_t _cos_lat = AlpacaFixedTrig::kOne;
+    int64_t _radius2 = 0;     // [(mm/256)^2]
+
+    // latest pointing; set by the server task
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+    bool _valid = false;
+    uint16_t _ha = 0;
+    uint16_t _dec = 0;
+    AlpacaPierSide_t _pier = AlpacaPierSide_t::kUnknown;
+    bool _tracking = true;
+    uint32_t _pointing_ms = 0;
+
+    AlpacaDomeSlavingStats_t _stats = {0, 0, 0, 0};
+    uint64_t _solve_sum_us = 0;
+
+    void _setPointing(uint16_t ha, uint16_t dec, AlpacaPierSide_t pier, bool tracking);
+
+public:
+    AlpacaDomeSlaving();
+    void SetConfig(const AlpacaDomeSlavingConfig_t &config);
+    const AlpacaDomeSlavingConfig_t &GetConfig() const { return _config; };
+
+    void SetPointingHaDec(double ha_hours, double dec_deg, AlpacaPierSide_t pier, bool tracking);
+    void SetPointingRaDec(double ra_hours, double dec_deg, double sidereal_time_hours, AlpacaPierSide_t pier, bool tracking);
+    void SetPointingAltAz(double alt_deg, double az_deg, AlpacaPierSide_t pier, bool tracking);
+    bool HasPointing() const { return _valid; };
+
+    // dome azimuth of the current pointing; false without pointing
+    bool Update(uint16_t &azimuth);
+    uint16_t Solve(uint16_t ha, uint16_t dec, AlpacaPierSide_t pier) const;
+    double SolveReference(double ha_deg, double dec_deg, AlpacaPierSide_t pier) const; // double precision; for the error statistics
+    void GetStats(AlpacaDomeSlavingStats_t &stats);
+};
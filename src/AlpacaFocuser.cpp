@@ -8,19 +8,54 @@
 **************************************************************************************************/
 #include "AlpacaFocuser.h"
 
+// "Motion" section of focusers with a step generator
+static constexpr AlpacaSettingField_t kAlpacaFocuserMotionSettings[] = {
+    ALPACA_SETTING(AlpacaFocuserStepperConfig_t, speed, "Motion", "Speed_steps_s", kFloat, 1.0, 1000000.0 / ALPACA_FOCUSER_STEP_MIN_INTERVAL_US, false),
+    ALPACA_SETTING(AlpacaFocuserStepperConfig_t, accel, "Motion", "Accel_steps_s2", kFloat, 1.0, 1000000.0, false),
+    ALPACA_SETTING(AlpacaFocuserStepperConfig_t, backlash, "Motion", "Backlash_steps", kInt32, 0, 10000, false),
+    ALPACA_SETTING(AlpacaFocuserStepperConfig_t, s_curve, "Motion", "SCurve", kBool, 0, 1, false),
+};
+
+// "TempComp" section of focusers with the built-in temperature compensation
+static constexpr AlpacaSettingField_t kAlpacaFocuserTempCompSettings[] = {
+    ALPACA_SETTING(AlpacaFocuserTempCompConfig_t, enabled, "TempComp", "Enabled", kBool, 0, 1, false),
+    ALPACA_SETTING(AlpacaFocuserTempCompConfig_t, steps_per_degree, "TempComp", "StepsPerDegree", kDouble, -100000.0, 100000.0, false),
+    ALPACA_SETTING(AlpacaFocuserTempCompConfig_t, hysteresis_steps, "TempComp", "Hysteresis_steps", kInt32, 1, 10000, false),
+    ALPACA_SETTING(AlpacaFocuserTempCompConfig_t, min_samples, "TempComp", "MinSamples", kUInt32, 2, 1000, false),
+    // fitted model; saved and restored, not editable - PUT tempcompreset drops it
+    ALPACA_SETTING(AlpacaFocuserTempCompConfig_t, samples, "TempComp", "Samples", kUInt32, 0, 4294967295.0, true),
+    ALPACA_SETTING(AlpacaFocuserTempCompConfig_t, mean_temperature, "TempComp", "MeanTemperature", kDouble, -100.0, 100.0, true),
+    ALPACA_SETTING(AlpacaFocuserTempCompConfig_t, mean_position, "TempComp", "MeanPosition", kDouble, -1.0e9, 1.0e9, true),
+    ALPACA_SETTING(AlpacaFocuserTempCompConfig_t, m2_temperature, "TempComp", "M2Temperature", kDouble, 0.0, 1.0e12, true),
+    ALPACA_SETTING(AlpacaFocuserTempCompConfig_t, c_temperature_position, "TempComp", "CTemperaturePosition", kDouble, -1.0e18, 1.0e18, true),
+};
+
 AlpacaFocuser::AlpacaFocuser()
 {
     strlcpy(_device_type, ALPACA_FOCUSER_DEVICE_TYPE, sizeof(_device_type));
-    strlcpy(_device_description, ALPACA_FOCUSER_DESCRIPTION, sizeof(_device_description));
+    strlcpy(_general.description, ALPACA_FOCUSER_DESCRIPTION, sizeof(_general.description));
     strlcpy(_driver_info, ALPACA_FOCUSER_DRIVER_INFO, sizeof(_driver_info));
     strlcpy(_device_and_driver_version, esp32_alpaca_device_library_version, sizeof(_device_and_driver_version));
     _device_interface_version = ALPACA_FOCUSER_INTERFACE_VERSION;
+    _addCachedValue(&_is_moving_value);
+    _addCachedValue(&_position_value);
+    _addCachedValue(&_temperature_value);
 }
 
 void AlpacaFocuser::Begin()
 {
+    int32_t position = 0;
+    uint16_t flags = 0;
     snprintf(_device_and_driver_version, sizeof(_device_and_driver_version), "%s/%s", _getFirmwareVersion(), esp32_alpaca_device_library_version);
     AlpacaDevice::Begin();
+
+    // step generator position from before the reset; drivers keep their positions themselves
+    if (_stepper != nullptr && _alpaca_server != nullptr &&
+        _alpaca_server->GetPositionJournal().Read(AlpacaPositionJournal::Key(AlpacaPositionJournalKind_t::kFocuserPosition, GetDeviceNumber()), position, flags))
+    {
+        _stepper->SetPosition(position);
+        SLOG_INFO_PRINTF("focuser position %d restored\n", position);
+    }
 }
 
 void AlpacaFocuser::RegisterCallbacks()
@@ -53,6 +88,8 @@ void AlpacaFocuser::RegisterCallbacks()
     this->createCallBack(LHF(_alpacaPutTempComp), HTTP_PUT, "tempcomp");
     this->createCallBack(LHF(_alpacaPutHalt), HTTP_PUT, "halt");
     this->createCallBack(LHF(_alpacaPutMove), HTTP_PUT, "move");
+    this->createCallBack(LHF(_alpacaPutTempCompSample), HTTP_PUT, "tempcompsample"); // extension
+    this->createCallBack(LHF(_alpacaPutTempCompReset), HTTP_PUT, "tempcompreset");   // extension
 }
 
 // void AlpacaFocuser::_alpacaGetPage(AsyncWebServerRequest *request, const char *const page)
@@ -90,7 +127,7 @@ void AlpacaFocuser::_alpacaGetIsMoving(AsyncWebServerRequest *request)
     uint32_t client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kIgnoreCase);
     if (client_idx > 0)
     {
-        is_moving = _getIsMoving();
+        is_moving = _isMoving();
     }
     _alpaca_server->Respond(request, _clients[client_idx], _rsp_status, (bool)is_moving);
     DBG_END
@@ -138,7 +175,7 @@ void AlpacaFocuser::_alpacaGetPosition(AsyncWebServerRequest *request)
     uint32_t client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kIgnoreCase);
     if (client_idx > 0)
     {
-        position = _getPosition();
+        position = _currentPosition();
     }
     _alpaca_server->Respond(request, _clients[client_idx], _rsp_status, (int32_t)position);
     DBG_END
@@ -170,7 +207,7 @@ void AlpacaFocuser::_alpacaGetTempComp(AsyncWebServerRequest *request)
     uint32_t client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kIgnoreCase);
     if (client_idx > 0)
     {
-        temp_comp = _getTempComp();
+        temp_comp = _temp_comp_builtin ? _temp_comp.GetConfig().enabled : _getTempComp();
     }
     _alpaca_server->Respond(request, _clients[client_idx], _rsp_status, (bool)temp_comp);
     DBG_END
@@ -186,7 +223,7 @@ void AlpacaFocuser::_alpacaGetTempCompAvailable(AsyncWebServerRequest *request)
     uint32_t client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kIgnoreCase);
     if (client_idx > 0)
     {
-        temp_comp_available = _getTempCompAvailable();
+        temp_comp_available = _temp_comp_builtin || _getTempCompAvailable();
     }
     _alpaca_server->Respond(request, _clients[client_idx], _rsp_status, (bool)temp_comp_available);
     DBG_END
@@ -202,7 +239,7 @@ void AlpacaFocuser::_alpacaGetTemperature(AsyncWebServerRequest *request)
     uint32_t client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kIgnoreCase);
     if (client_idx > 0)
     {
-        temperature = _getTemperature();
+        temperature = _temperature_value.Get([this]() { return _getTemperature(); });
     }
     _alpaca_server->Respond(request, _clients[client_idx], _rsp_status, (double)temperature);
     DBG_END
@@ -222,7 +259,12 @@ void AlpacaFocuser::_alpacaPutTempComp(AsyncWebServerRequest *request)
     if (_alpaca_server->GetParam(request, "TempComp", temp_comp, Spelling_t::kStrict) == false)
         MYTHROW_RspStatusParameterNotFound(request, _rsp_status, "TempComp");
 
-    if (!_putTempComp(temp_comp))
+    if (_temp_comp_builtin)
+    {
+        _temp_comp.Enable(temp_comp);
+        _alpaca_server->MarkSettingsDirty(this);
+    }
+    else if (!_putTempComp(temp_comp))
         MYTHROW_RspStatusParameterInvalidBoolValue(request, _rsp_status, "TempComp", temp_comp);
 
 mycatch: // empty
@@ -241,7 +283,14 @@ void AlpacaFocuser::_alpacaPutHalt(AsyncWebServerRequest *request)
     if ((client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kStrict)) == 0)
         goto mycatch;
         
-    _putHalt();
+    if (_stepper != nullptr)
+        _stepper->Halt();
+    else
+        _putHalt();
+    _trajectory.Expire();
+    _temp_comp.Unanchor();
+    _is_moving_value.Invalidate();
+    _position_value.Invalidate();
 
 mycatch:
 
@@ -263,7 +312,19 @@ void AlpacaFocuser::_alpacaPutMove(AsyncWebServerRequest *request)
     if (_alpaca_server->GetParam(request, "Position", position, Spelling_t::kStrict) == false)
         MYTHROW_RspStatusParameterNotFound(request, _rsp_status, "Position");
 
-    _putMove(position);
+    if (_stepper != nullptr && !_getAbsolut())
+        position += _stepper->GetTarget(); // relative focuser; Position is a step count
+    else if (_getAbsolut() && (position < 0 || position > _getMaxStep()))
+        MYTHROW_RspStatusParameterInvalidInt32Value(request, _rsp_status, "Position", position);
+
+    if (_moveTo(position) == false)
+    {
+        _rsp_status.error_code = AlpacaErrorCode_t::InvalidOperationException;
+        _rsp_status.http_status = HttpStatus_t::kPassed;
+        snprintf(_rsp_status.error_msg, sizeof(_rsp_status.error_msg), "%s - Move to %d not started", request->url().c_str(), position);
+        goto mycatch;
+    }
+    _temp_comp.Unanchor(); // compensation continues from the new focus
 
 mycatch:
 
@@ -271,6 +332,57 @@ mycatch:
     DBG_END
 };
 
+// extension: logs a best focus for the fit of the temperature compensation, e.g. after an autofocus
+// run; Position and Temperature default to the current values
+void AlpacaFocuser::_alpacaPutTempCompSample(AsyncWebServerRequest *request)
+{
+    _service_counter++;
+    uint32_t client_idx = 0;
+    _alpaca_server->RspStatusClear(_rsp_status);
+    int32_t position = 0;
+    double temperature = 0.0;
+
+    if ((client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kStrict)) == 0)
+        goto mycatch;
+    if (!_temp_comp_builtin)
+        MYTHROW_RspStatusCommandNotImplemented(request, _rsp_status, "TempCompSample");
+
+    if (_alpaca_server->GetParam(request, "Position", position, Spelling_t::kStrict) == false)
+        position = _currentPosition();
+    if (_alpaca_server->GetParam(request, "Temperature", temperature, Spelling_t::kStrict) == false)
+        temperature = _temperature_value.Get([this]() { return _getTemperature(); });
+    if (position < 0 || position > _getMaxStep())
+        MYTHROW_RspStatusParameterInvalidInt32Value(request, _rsp_status, "Position", position);
+    if (!(temperature >= -100.0 && temperature <= 100.0))
+        MYTHROW_RspStatusParameterInvalidDoubleValue(request, _rsp_status, "Temperature", temperature);
+
+    _temp_comp.AddSample(temperature, position);
+    _alpaca_server->MarkSettingsDirty(this);
+
+mycatch:
+    _alpaca_server->Respond(request, _clients[client_idx], _rsp_status);
+}
+
+// extension: drops the logged samples of the temperature compensation; the slope stays until the
+// next fit
+void AlpacaFocuser::_alpacaPutTempCompReset(AsyncWebServerRequest *request)
+{
+    _service_counter++;
+    uint32_t client_idx = 0;
+    _alpaca_server->RspStatusClear(_rsp_status);
+
+    if ((client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kStrict)) == 0)
+        goto mycatch;
+    if (!_temp_comp_builtin)
+        MYTHROW_RspStatusCommandNotImplemented(request, _rsp_status, "TempCompReset");
+
+    _temp_comp.Reset();
+    _alpaca_server->MarkSettingsDirty(this);
+
+mycatch:
+    _alpaca_server->Respond(request, _clients[client_idx], _rsp_status);
+}
+
 #ifdef ALPACA_FOCUSER_PUT_ACTION_IMPLEMENTED
 void AlpacaFocuser::AlpacaPutAction(AsyncWebServerRequest *request)
 {
@@ -372,3 +484,171 @@ mycatch:
     DBG_END
 };
 #endif
+
+// state for the events of AlpacaServer
+void AlpacaFocuser::AlpacaWriteState(JsonObject &root)
+{
+    AlpacaDevice::AlpacaWriteState(root);
+    root["IsMoving"] = _isMoving();
+    root["Position"] = _currentPosition();
+}
+
+// step generator counters and published moves are read lock-free; other drivers through the cache
+bool AlpacaFocuser::_isMoving()
+{
+    int32_t position = 0;
+    bool moving = false;
+    if (_stepper != nullptr)
+        return _stepper->IsMoving();
+    if (_predict(position, moving))
+        return moving;
+    return _is_moving_value.Get([this]() { return _getIsMoving(); });
+}
+
+int32_t AlpacaFocuser::_currentPosition()
+{
+    int32_t position = 0;
+    bool moving = false;
+    if (_stepper != nullptr)
+        return _stepper->GetPosition();
+    if (_predict(position, moving))
+        return position;
+    return _position_value.Get([this]() { return _getPosition(); });
+}
+
+// prediction of the published move; past its predicted end or after a halt the driver is asked
+// until it reports the stop, and at rest always
+bool AlpacaFocuser::_predict(int32_t &position, bool &moving)
+{
+    bool overdue = false;
+    if (!_trajectory.Estimate(position, moving, overdue))
+        return false;
+    if (overdue)
+    {
+        moving = _is_moving_value.Get([this]() { return _getIsMoving(); });
+        position = _position_value.Get([this]() { return _getPosition(); });
+        if (!moving)
+            _trajectory.Correct(position, false);
+    }
+    return true;
+}
+
+// false - move not started, e.g. no step timer or rejected by the driver
+bool AlpacaFocuser::_moveTo(int32_t position)
+{
+    bool ok = _stepper != nullptr ? _stepper->MoveTo(position) : _putMove(position);
+    _is_moving_value.Invalidate();
+    _position_value.Invalidate();
+    return ok;
+}
+
+void AlpacaFocuser::Loop()
+{
+    // position at rest to the position journal; unchanged positions are not written
+    if (_stepper != nullptr && _alpaca_server != nullptr && !_stepper->IsMoving())
+        _alpaca_server->GetPositionJournal().Write(AlpacaPositionJournal::Key(AlpacaPositionJournalKind_t::kFocuserPosition, GetDeviceNumber()), _stepper->GetPosition());
+    if (_temp_comp_builtin && (millis() - _temp_comp_ms) >= kAlpacaFocuserTempCompPeriodMs)
+    {
+        _temp_comp_ms = millis();
+        _tempCompTick();
+    }
+}
+
+// temperature compensation in the loop task; a correction is a regular move
+void AlpacaFocuser::_tempCompTick()
+{
+    int32_t position = _currentPosition();
+    int32_t target = position;
+    double temperature = _temperature_value.Get([this]() { return _getTemperature(); });
+    if (!_temp_comp.Tick(temperature, position, _isMoving(), target))
+        return;
+    target = constrain(target, (int32_t)0, _getMaxStep());
+    if (target == position)
+        return;
+    SLOG_DEBUG_PRINTF("tempcomp %.2f degC: %d -> %d\n", _temp_comp.GetTemperature(), position, target);
+    if (!_moveTo(target))
+        SLOG_WARNING_PRINTF("tempcomp move to %d not started\n", target);
+}
+
+void AlpacaFocuser::AlpacaReadJson(JsonObject &root)
+{
+    AlpacaDevice::AlpacaReadJson(root);
+    if (_stepper != nullptr)
+    {
+        AlpacaFocuserStepperConfig_t config = _stepper->GetConfig();
+        AlpacaSettings::Read(kAlpacaFocuserMotionSettings, root, &config, _patch_errors);
+        _stepper->SetConfig(config);
+    }
+    if (_temp_comp_builtin)
+    {
+        AlpacaFocuserTempCompConfig_t config = _temp_comp.GetConfig();
+        AlpacaSettings::Read(kAlpacaFocuserTempCompSettings, root, &config, _patch_errors);
+        _temp_comp.SetConfig(config);
+    }
+}
+
+void AlpacaFocuser::AlpacaWriteJson(JsonObject &root)
+{
+    AlpacaDevice::AlpacaWriteJson(root);
+    if (_stepper != nullptr)
+        AlpacaSettings::Write(kAlpacaFocuserMotionSettings, &_stepper->GetConfig(), root);
+    if (_temp_comp_builtin)
+    {
+        AlpacaFocuserTempCompConfig_t config = _temp_comp.GetConfig();
+        AlpacaSettings::Write(kAlpacaFocuserTempCompSettings, &config, root);
+    }
+}
+
+void AlpacaFocuser::AlpacaRestoreJson(JsonObject &root)
+{
+    AlpacaDevice::AlpacaRestoreJson(root);
+    if (_temp_comp_builtin)
+    {
+        AlpacaFocuserTempCompConfig_t config = _temp_comp.GetConfig();
+        AlpacaSettings::Restore(kAlpacaFocuserTempCompSettings, root, &config);
+        _temp_comp.SetConfig(config);
+    }
+}
+
+void AlpacaFocuser::AlpacaSettingsFilter(JsonObject &filter)
+{
+    GeneralSettingsFilter(filter);
+    if (_stepper != nullptr)
+        AlpacaSettings::Filter(kAlpacaFocuserMotionSettings, filter);
+    if (_temp_comp_builtin)
+        AlpacaSettings::Filter(kAlpacaFocuserTempCompSettings, filter, true); // with the model for AlpacaRestoreJson()
+}
+
+void AlpacaFocuser::AlpacaWriteSchema(JsonObject &root)
+{
+    AlpacaDevice::AlpacaWriteSchema(root);
+    if (_stepper != nullptr)
+        AlpacaSettings::Schema(kAlpacaFocuserMotionSettings, root);
+    if (_temp_comp_builtin)
+        AlpacaSettings::Schema(kAlpacaFocuserTempCompSettings, root);
+}
+
+// step timer of the step generator and tick of the temperature compensation
+size_t AlpacaFocuser::AlpacaGetMetrics(AlpacaMetric_t *metrics, size_t n)
+{
+    size_t count = 0;
+    if (_stepper != nullptr && n >= count + 5)
+    {
+        AlpacaFocuserStepperStats_t stats;
+        _stepper->GetStats(stats);
+        metrics[count++] = {"focuser_steps_total", "counter", stats.steps};
+        metrics[count++] = {"focuser_steps_late_total", "counter", stats.steps_late};
+        metrics[count++] = {"focuser_step_jitter_max_us", "gauge", stats.jitter_max_us};
+        metrics[count++] = {"focuser_step_jitter_mean_us", "gauge", stats.jitter_mean_us};
+        metrics[count++] = {"focuser_step_rate_max_hz", "gauge", stats.rate_max_hz};
+    }
+    if (_temp_comp_builtin && n >= count + 3)
+    {
+        AlpacaFocuserTempCompStats_t stats;
+        _temp_comp.GetStats(stats);
+        metrics[count++] = {"focuser_tempcomp_ticks_total", "counter", stats.ticks};
+        metrics[count++] = {"focuser_tempcomp_corrections_total", "counter", stats.corrections};
+        metrics[count++] = {"focuser_tempcomp_tick_max_us", "gauge", stats.tick_max_us};
+    }
+    return count;
+}
@@ -8,6 +8,9 @@
 **************************************************************************************************/
 #pragma once
 #include "AlpacaDevice.h"
+#include "AlpacaFocuserStepper.h"
+#include "AlpacaFocuserTempComp.h"
+#include "AlpacaFocuserTrajectory.h"
 
 class AlpacaFocuser : public AlpacaDevice
 {
@@ -29,6 +32,8 @@ private:
     void _alpacaPutTempComp(AsyncWebServerRequest *request);
     void _alpacaPutHalt(AsyncWebServerRequest *request);
     void _alpacaPutMove(AsyncWebServerRequest *request);
+    void _alpacaPutTempCompSample(AsyncWebServerRequest *request);
+    void _alpacaPutTempCompReset(AsyncWebServerRequest *request);
 
 #ifdef ALPACA_FOCUSER_PUT_ACTION_IMPLEMENTED
     void AlpacaPutAction(AsyncWebServerRequest *request);
@@ -44,24 +49,54 @@ private:
 #endif
 
     virtual const char* const _getFirmwareVersion() { return "-"; };
-    virtual const bool _putTempComp(bool temp_comp) = 0;
-    virtual const bool _putHalt() = 0;
-    virtual const bool _putMove(int32_t position) = 0;
+    virtual const bool _putTempComp(bool temp_comp) { return false; }; // not called with the built-in compensation
+    virtual const bool _putHalt() { return false; };             // not called with a stepper
+    virtual const bool _putMove(int32_t position) { return false; }; // not called with a stepper
 
     virtual const bool _getAbsolut() = 0;
-    virtual const bool _getIsMoving() = 0;
+    virtual const bool _getIsMoving() { return false; };         // not called with a stepper
     virtual const int32_t _getMaxIncrement() = 0;
     virtual const int32_t _getMaxStep() = 0;
-    virtual const int32_t _getPosition() = 0;
+    virtual const int32_t _getPosition() { return 0; };          // not called with a stepper
     virtual const double _getStepSize() = 0;
-    virtual const bool _getTempComp() = 0;
+    virtual const bool _getTempComp() { return false; };         // not called with the built-in compensation
     virtual const bool _getTempCompAvailable() = 0;
     virtual const double _getTemperature() = 0;
     
 protected:
+    AlpacaCachedValue<bool> _is_moving_value{"IsMoving", ALPACA_FOCUSER_POSITION_TTL_MS};
+    AlpacaCachedValue<int32_t> _position_value{"Position", ALPACA_FOCUSER_POSITION_TTL_MS};
+    AlpacaCachedValue<double> _temperature_value{"Temperature", ALPACA_FOCUSER_TEMPERATURE_TTL_MS};
+    AlpacaFocuserStepper *_stepper = nullptr; // nullptr - driver moves the focuser itself
+    AlpacaFocuserTrajectory _trajectory;      // moves published by drivers without step generator
+    AlpacaFocuserTempComp _temp_comp;
+    bool _temp_comp_builtin = false;          // false - TempComp by the driver
+    uint32_t _temp_comp_ms = 0;
+
     AlpacaFocuser();
     void Begin();
     void RegisterCallbacks();
+    void SetStepper(AlpacaFocuserStepper *stepper) { _stepper = stepper; }; // Move, Halt, Position and IsMoving by the step generator
+    void SetTempCompEngine() { _temp_comp_builtin = true; };                 // TempComp by the built-in compensation
+
+    // drivers running their moves publish each move from _putMove() and correct at its end or by an
+    // encoder; Position and IsMoving are predicted without driver calls meanwhile
+    void PublishMove(int32_t start, int32_t target, float speed, float accel, bool s_curve = false) { _trajectory.Publish(start, target, speed, accel, s_curve); };
+    void CorrectPosition(int32_t position, bool moving) { _trajectory.Correct(position, moving); };
+
+    bool _isMoving();
+    int32_t _currentPosition();
+    bool _predict(int32_t &position, bool &moving);
+    bool _moveTo(int32_t position);
+    void _tempCompTick();
 
 public:
+    void Loop(); // derived classes overloading Loop() must call AlpacaFocuser::Loop()
+    void AlpacaReadJson(JsonObject &root);
+    void AlpacaWriteJson(JsonObject &root);
+    void AlpacaSettingsFilter(JsonObject &filter); // General, Motion and TempComp; overloads call it and add their keys
+    void AlpacaRestoreJson(JsonObject &root);      // model of the temperature compensation
+    void AlpacaWriteSchema(JsonObject &root);
+    void AlpacaWriteState(JsonObject &root);
+    size_t AlpacaGetMetrics(AlpacaMetric_t *metrics, size_t n);
 };
\ No newline at end of file
@@ -0,0 +1,245 @@
+/**************************************************************************************************
+  Filename:       AlpacaFocuserStepper.cpp
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Step generator of AlpacaFocuser - trapezoidal or S-curve motion profile
+**************************************************************************************************/
+#include "AlpacaFocuserStepper.h"
+#include "AlpacaDebug.h"
+
+void AlpacaStepDirSink::Begin()
+{
+    pinMode(_pin_step, OUTPUT);
+    pinMode(_pin_dir, OUTPUT);
+    digitalWrite(_pin_step, LOW);
+    if (_pin_enable >= 0)
+    {
+        pinMode(_pin_enable, OUTPUT);
+        digitalWrite(_pin_enable, LOW);
+    }
+}
+
+// dir setup and step pulse width of 1-2 us fit the common drivers
+void AlpacaStepDirSink::Step(int8_t dir)
+{
+    if (dir != _dir)
+    {
+        digitalWrite(_pin_dir, dir > 0 ? HIGH : LOW);
+        _dir = dir;
+        delayMicroseconds(1);
+    }
+    digitalWrite(_pin_step, HIGH);
+    delayMicroseconds(2);
+    digitalWrite(_pin_step, LOW);
+}
+
+bool AlpacaFocuserStepper::Begin(AlpacaStepSink *sink)
+{
+    _sink = sink;
+    esp_timer_create_args_t args = {};
+    args.callback = _timerCallback;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "stepper";
+    args.skip_unhandled_events = false;
+    if (_timer == nullptr && esp_timer_create(&args, &_timer) != ESP_OK)
+    {
+        _timer = nullptr;
+        SLOG_ERROR_PRINTF("stepper timer not created\n");
+        return false;
+    }
+    SLOG_INFO_PRINTF("stepper ramp %u steps, max %.0f steps/s\n", _ramp_len, GetMaxSpeed());
+    return true;
+}
+
+/**
+ * Step intervals of the acceleration from standstill. Both profiles need v^2 / 2a steps to
+ * reach the speed v: trapezoid s(t) = a t^2 / 2; S-curve v(t) = v (1 - cos(pi t / T)) / 2 with
+ * T = v / a. The speed is reduced if the ramp does not fit into the table.
+ */
+void AlpacaFocuserStepper::_buildRamp()
+{
+    double accel = max((double)_config.accel, 1.0);
+    double speed = min(max((double)_config.speed, 1.0), 1000000.0 / kAlpacaFocuserStepMinIntervalUs);
+    uint32_t len = (uint32_t)(speed * speed / (2.0 * accel));
+    len = len < 1 ? 1 : (len > kAlpacaFocuserStepRampSize ? kAlpacaFocuserStepRampSize : len);
+    speed = min(speed, sqrt(2.0 * accel * len));
+    double t_ramp = speed / accel;
+    uint32_t cruise_us = max((uint32_t)lround(1000000.0 / speed), kAlpacaFocuserStepMinIntervalUs);
+
+    double t_prev = 0.0;
+    for (uint32_t n = 1; n <= len; n++)
+    {
+        double t;
+        if (_config.s_curve)
+        {
+            // invert s(t) = v / 2 (t - T / pi sin(pi t / T)) by bisection; s is monotonic
+            double lo = t_prev;
+            double hi = t_ramp;
+            for (int i = 0; i < 40; i++)
+            {
+                t = (lo + hi) / 2.0;
+                double s = speed / 2.0 * (t - t_ramp / M_PI * sin(M_PI * t / t_ramp));
+                if (s < (double)n)
+                    lo = t;
+                else
+                    hi = t;
+            }
+            t = hi;
+        }
+        else
+        {
+            t = sqrt(2.0 * (double)n / accel);
+        }
+        _ramp_us[n - 1] = max((uint32_t)lround((t - t_prev) * 1000000.0), cruise_us);
+        t_prev = t;
+    }
+    _ramp_len = len;
+    _cruise_us = cruise_us;
+    _config_pending = false;
+}
+
+void AlpacaFocuserStepper::SetConfig(const AlpacaFocuserStepperConfig_t &config)
+{
+    _config = config;
+    if (_moving)
+        _config_pending = true;
+    else
+        _buildRamp();
+}
+
+bool AlpacaFocuserStepper::MoveTo(int32_t position)
+{
+    if (_sink == nullptr || _timer == nullptr)
+        return false;
+    if (!_moving && _config_pending)
+        _buildRamp();
+
+    bool start = false;
+    portENTER_CRITICAL(&_mux);
+    _target = position;
+    if (!_moving && position != _position)
+    {
+        int8_t dir = position > _position ? 1 : -1;
+        if (dir != _dir)
+        {
+            _dir = dir;
+            _backlash_left = _config.backlash;
+        }
+        _level = 0;
+        _moving = true;
+        start = true;
+    }
+    portEXIT_CRITICAL(&_mux);
+
+    if (start)
+    {
+        _deadline_us = esp_timer_get_time() + kAlpacaFocuserStepMinIntervalUs;
+        esp_timer_start_once(_timer, kAlpacaFocuserStepMinIntervalUs);
+    }
+    return true;
+}
+
+// new target at the stopping distance of the current speed
+void AlpacaFocuserStepper::Halt()
+{
+    portENTER_CRITICAL(&_mux);
+    if (_moving)
+        _target = _position + _dir * max(_level - _backlash_left, (int32_t)0);
+    else
+        _target = _position;
+    portEXIT_CRITICAL(&_mux);
+}
+
+bool AlpacaFocuserStepper::SetPosition(int32_t position)
+{
+    bool ok = false;
+    portENTER_CRITICAL(&_mux);
+    if (!_moving)
+    {
+        _position = position;
+        _target = position;
+        ok = true;
+    }
+    portEXIT_CRITICAL(&_mux);
+    return ok;
+}
+
+void AlpacaFocuserStepper::GetStats(AlpacaFocuserStepperStats_t &stats)
+{
+    portENTER_CRITICAL(&_mux);
+    stats = _stats;
+    stats.jitter_mean_us = _stats.steps > 0 ? (uint32_t)(_jitter_sum_us / _stats.steps) : 0;
+    portEXIT_CRITICAL(&_mux);
+}
+
+/**
+ * One step in the esp_timer task, then the interval to the next one: accelerate along the ramp,
+ * cruise, or decelerate when the remaining steps are no more than the ramp level. A target
+ * behind the current direction is reached after a decelerated stop and a reversal.
+ */
+void AlpacaFocuserStepper::_step()
+{
+    int64_t now_us = esp_timer_get_time();
+    uint32_t late_us = now_us > _deadline_us ? (uint32_t)(now_us - _deadline_us) : 0;
+    uint32_t rate_hz = 0;
+    if (_level > 0 && now_us > _last_step_us)
+        rate_hz = (uint32_t)(1000000 / (now_us - _last_step_us));
+    _last_step_us = now_us;
+
+    _sink->Step(_dir);
+
+    uint32_t next_us = 0;
+    portENTER_CRITICAL(&_mux);
+    if (_backlash_left > 0)
+        _backlash_left--;
+    else
+        _position = _position + _dir;
+    int32_t to_go = (_target - _position) * _dir + _backlash_left;
+    if (to_go <= 0 && _level <= 1)
+    {
+        _level = 0;
+        if (_target != _position)
+        {
+            _dir = -_dir;
+            _backlash_left = _config.backlash;
+            next_us = _ramp_us[0];
+            _level = 1;
+        }
+        else
+        {
+            _moving = false;
+        }
+    }
+    else if (to_go <= _level)
+    {
+        _level--;
+        next_us = _ramp_us[_level];
+    }
+    else if (_level < (int32_t)_ramp_len)
+    {
+        next_us = _ramp_us[_level];
+        _level++;
+    }
+    else
+    {
+        next_us = _cruise_us;
+    }
+
+    _stats.steps++;
+    _jitter_sum_us += late_us;
+    _stats.jitter_max_us = max(_stats.jitter_max_us, late_us);
+    _stats.rate_max_hz = max(_stats.rate_max_hz, rate_hz);
+    if (late_us > kAlpacaFocuserStepJitterBudgetUs)
+        _stats.steps_late++;
+    portEXIT_CRITICAL(&_mux);
+
+    if (next_us == 0)
+        return;
+    // keep the deadlines; resynchronize instead of a burst of steps after a long delay
+    _deadline_us += next_us;
+    now_us = esp_timer_get_time();
+    if (_deadline_us < now_us)
+        _deadline_us = now_us;
+    esp_timer_start_once(_timer, (uint64_t)(_deadline_us - now_us));
+}
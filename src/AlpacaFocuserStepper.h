@@ -0,0 +1,109 @@
+/**************************************************************************************************
+  Filename:       AlpacaFocuserStepper.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Step generator of AlpacaFocuser - trapezoidal or S-curve motion profile
+
+  Moves are executed step by step from a one-shot esp_timer, re-armed after each step on an
+  absolute deadline: a late step does not shift the following ones. The step intervals of the
+  acceleration ramp are precomputed by SetConfig(); the timer callback only looks them up. It
+  decelerates as soon as the remaining steps are no more than the steps taken on the ramp, so a
+  new target or Halt() takes effect at the next step. After a direction change the backlash is
+  taken up by extra steps which do not count in the position.
+**************************************************************************************************/
+#pragma once
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "AlpacaConfig.h"
+
+// output of the step generator; all calls from the step timer
+class AlpacaStepSink
+{
+public:
+    virtual ~AlpacaStepSink() {};
+    virtual void Step(int8_t dir) = 0; // one step; +1 outward, -1 inward
+};
+
+// step/dir driver, e.g. A4988, DRV8825 or TMC2209 in step/dir mode
+class AlpacaStepDirSink : public AlpacaStepSink
+{
+private:
+    int8_t _pin_step;
+    int8_t _pin_dir;
+    int8_t _pin_enable;
+    int8_t _dir = 0; // latest level of the dir pin
+
+public:
+    AlpacaStepDirSink(int8_t pin_step, int8_t pin_dir, int8_t pin_enable = -1)
+        : _pin_step(pin_step), _pin_dir(pin_dir), _pin_enable(pin_enable) {};
+    void Begin(); // outputs; driver enabled (active low)
+    void Step(int8_t dir);
+};
+
+// "Motion" settings of AlpacaFocuser
+struct AlpacaFocuserStepperConfig_t
+{
+    float speed;      // max speed [steps/s]
+    float accel;      // acceleration; mean acceleration of the S-curve [steps/s^2]
+    int32_t backlash; // extra steps after a direction change [steps]
+    bool s_curve;     // sine shaped acceleration instead of constant
+};
+
+// step timer statistics for /metrics
+struct AlpacaFocuserStepperStats_t
+{
+    uint32_t steps;
+    uint32_t steps_late;     // started later than the jitter budget after the deadline
+    uint32_t jitter_max_us;  // max delay behind the deadline
+    uint32_t jitter_mean_us;
+    uint32_t rate_max_hz;    // highest step rate achieved
+};
+
+class AlpacaFocuserStepper
+{
+private:
+    AlpacaStepSink *_sink = nullptr;
+    esp_timer_handle_t _timer = nullptr;
+    AlpacaFocuserStepperConfig_t _config = {1000.0f, 2000.0f, 0, false};
+    bool _config_pending = false;          // applied by the next move from standstill
+
+    // acceleration ramp; rebuilt while idle only
+    uint32_t _ramp_us[kAlpacaFocuserStepRampSize]; // interval before step n + 1 of the ramp
+    uint32_t _ramp_len = 0;
+    uint32_t _cruise_us = 1000;
+
+    // motion; _position and _level are written by the step timer only while moving
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+    volatile int32_t _position = 0;
+    volatile int32_t _target = 0;
+    volatile bool _moving = false;
+    int8_t _dir = 1;                       // current or latest direction
+    int32_t _level = 0;                    // steps on the ramp; 0 - standstill
+    int32_t _backlash_left = 0;
+    int64_t _deadline_us = 0;
+    int64_t _last_step_us = 0;
+
+    AlpacaFocuserStepperStats_t _stats = {0, 0, 0, 0, 0};
+    uint64_t _jitter_sum_us = 0;
+
+    static void _timerCallback(void *arg) { ((AlpacaFocuserStepper *)arg)->_step(); }
+    void _step();
+    void _buildRamp();
+
+public:
+    AlpacaFocuserStepper() { _buildRamp(); };
+    bool Begin(AlpacaStepSink *sink);
+
+    bool MoveTo(int32_t position);    // also while moving; reverses after a decelerated stop
+    void Halt();                      // decelerated stop
+    bool SetPosition(int32_t position); // sync; idle only
+
+    int32_t GetPosition() const { return _position; };
+    int32_t GetTarget() const { return _target; };
+    bool IsMoving() const { return _moving; };
+    float GetMaxSpeed() const { return 1000000.0f / (float)_cruise_us; }; // speed limited by timer and ramp length [steps/s]
+
+    void SetConfig(const AlpacaFocuserStepperConfig_t &config);
+    const AlpacaFocuserStepperConfig_t &GetConfig() const { return _config; };
+    void GetStats(AlpacaFocuserStepperStats_t &stats);
+};
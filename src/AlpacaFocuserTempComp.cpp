@@ -0,0 +1,115 @@
+/**************************************************************************************************
+  Filename:       AlpacaFocuserTempComp.cpp
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 02 $
+  Description:    Temperature compensation of AlpacaFocuser - fitted steps per degree
+**************************************************************************************************/
+#include "AlpacaFocuserTempComp.h"
+#include <esp_timer.h>
+#include "AlpacaDebug.h"
+
+// incremental update of means and co-moments; numerically stable for large positions
+void AlpacaFocuserTempComp::AddSample(double temperature, int32_t position)
+{
+    portENTER_CRITICAL(&_mux);
+    _config.samples++;
+    double n = (double)_config.samples;
+    double d_temperature = temperature - _config.mean_temperature;
+    _config.mean_temperature += d_temperature / n;
+    _config.mean_position += ((double)position - _config.mean_position) / n;
+    _config.m2_temperature += d_temperature * (temperature - _config.mean_temperature);
+    _config.c_temperature_position += d_temperature * ((double)position - _config.mean_position);
+    _fit();
+    uint32_t samples = _config.samples;
+    double steps_per_degree = _config.steps_per_degree;
+    portEXIT_CRITICAL(&_mux);
+    SLOG_INFO_PRINTF("tempcomp sample %.2f degC %d steps; %u samples, %.2f steps/degC\n", temperature, position, samples, steps_per_degree);
+}
+
+// with _mux held
+
+void AlpacaFocuserTempComp::_fit()
+{
+    if (_config.samples < max(_config.min_samples, (uint32_t)2))
+        return;
+    if (_config.m2_temperature < kAlpacaFocuserTempCompMinVariance * (double)_config.samples)
+        return; // temperatures too close for a slope
+    _config.steps_per_degree = _config.c_temperature_position / _config.m2_temperature;
+}
+
+void AlpacaFocuserTempComp::Reset()
+{
+    portENTER_CRITICAL(&_mux);
+    _config.samples = 0;
+    _config.mean_temperature = 0.0;
+    _config.mean_position = 0.0;
+    _config.m2_temperature = 0.0;
+    _config.c_temperature_position = 0.0;
+    portEXIT_CRITICAL(&_mux);
+}
+
+void AlpacaFocuserTempComp::SetConfig(const AlpacaFocuserTempCompConfig_t &config)
+{
+    portENTER_CRITICAL(&_mux);
+    _config = config;
+    if (_config.samples == 0)
+        _config.mean_temperature = _config.mean_position = _config.m2_temperature = _config.c_temperature_position = 0.0;
+    _fit();
+    portEXIT_CRITICAL(&_mux);
+}
+
+AlpacaFocuserTempCompConfig_t AlpacaFocuserTempComp::GetConfig() const
+{
+    portENTER_CRITICAL(&_mux);
+    AlpacaFocuserTempCompConfig_t config = _config;
+    portEXIT_CRITICAL(&_mux);
+    return config;
+}
+
+void AlpacaFocuserTempComp::Enable(bool enabled)
+{
+    portENTER_CRITICAL(&_mux);
+    if (enabled && !_config.enabled)
+        _anchored = false;
+    _config.enabled = enabled;
+    portEXIT_CRITICAL(&_mux);
+}
+
+void AlpacaFocuserTempComp::GetStats(AlpacaFocuserTempCompStats_t &stats) const
+{
+    portENTER_CRITICAL(&_mux);
+    stats = _stats;
+    portEXIT_CRITICAL(&_mux);
+}
+
+bool AlpacaFocuserTempComp::Tick(double temperature, int32_t position, bool moving, int32_t &target)
+{
+    int64_t start_us = esp_timer_get_time();
+    bool move = false;
+    portENTER_CRITICAL(&_mux);
+
+    if (_temperature_valid)
+        _temperature += kAlpacaFocuserTempCompAlpha * (temperature - _temperature);
+    else
+        _temperature = temperature;
+    _temperature_valid = true;
+
+    if (_config.enabled && !moving)
+    {
+        if (!_anchored)
+        {
+            _anchor_temperature = _temperature;
+            _anchor_position = position;
+            _anchored = true;
+        }
+        target = _anchor_position + (int32_t)lround(_config.steps_per_degree * (_temperature - _anchor_temperature));
+        move = abs(target - position) >= max(_config.hysteresis_steps, (int32_t)1);
+    }
+
+    _stats.ticks++;
+    if (move)
+        _stats.corrections++;
+    _stats.tick_max_us = max(_stats.tick_max_us, (uint32_t)(esp_timer_get_time() - start_us));
+    portEXIT_CRITICAL(&_mux);
+    return move;
+}
@@ -0,0 +1,70 @@
+/**************************************************************************************************
+  Filename:       AlpacaFocuserTempComp.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 02 $
+  Description:    Temperature compensation of AlpacaFocuser - fitted steps per degree
+
+  Best focus positions logged at different temperatures are fitted to a line by incremental least
+  squares (running means and co-moments); the model state is saved read-only with the "TempComp"
+  settings and survives restarts. Samples come from AsyncTCP, the tick and the settings from the
+  loop task; the config is copied under a mux. While compensation is on, the periodic tick moves the focuser to
+  anchor position + steps per degree * (temperature - anchor temperature) once that differs from
+  the current position by the hysteresis. The anchor is taken at standstill when compensation is
+  switched on and after each move by the client.
+**************************************************************************************************/
+#pragma once
+#include <Arduino.h>
+#include "AlpacaConfig.h"
+
+// "TempComp" settings of AlpacaFocuser
+struct AlpacaFocuserTempCompConfig_t
+{
+    bool enabled;              // TempComp of the focuser; kept over restarts
+    double steps_per_degree;   // fitted slope; manual value until min_samples are logged
+    int32_t hysteresis_steps;  // no correction below this
+    uint32_t min_samples;      // samples needed to fit the slope
+    // least squares state; read-only, restored on loading; Reset() drops it
+    uint32_t samples;
+    double mean_temperature;   // [degC]
+    double mean_position;      // [steps]
+    double m2_temperature;     // sum of squared temperature deviations [degC^2]
+    double c_temperature_position; // sum of temperature * position deviations [degC steps]
+};
+
+// compensation tick statistics for /metrics
+struct AlpacaFocuserTempCompStats_t
+{
+    uint32_t ticks;
+    uint32_t corrections;
+    uint32_t tick_max_us;
+};
+
+class AlpacaFocuserTempComp
+{
+private:
+    mutable portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+    AlpacaFocuserTempCompConfig_t _config = {false, 0.0, 10, 3, 0, 0.0, 0.0, 0.0, 0.0};
+    bool _anchored = false;
+    double _anchor_temperature = 0.0;
+    int32_t _anchor_position = 0;
+    bool _temperature_valid = false;
+    double _temperature = 0.0; // low pass of the sensor
+
+    AlpacaFocuserTempCompStats_t _stats = {0, 0, 0};
+
+    void _fit();
+
+public:
+    void AddSample(double temperature, int32_t position);
+    void Reset(); // drops the samples; the slope stays
+    void Unanchor() { _anchored = false; }; // new anchor at the next standstill
+
+    // true if the focuser has to move to target
+    bool Tick(double temperature, int32_t position, bool moving, int32_t &target);
+
+    double GetTemperature() const { return _temperature; }; // filtered
+    void SetConfig(const AlpacaFocuserTempCompConfig_t &config);
+    AlpacaFocuserTempCompConfig_t GetConfig() const;
+    void Enable(bool enabled);
+    void GetStats(AlpacaFocuserTempCompStats_t &stats) const;
+};
@@ -0,0 +1,137 @@
+/**************************************************************************************************
+  Filename:       AlpacaFocuserTrajectory.cpp
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 02 $
+  Description:    Published move of a focuser driver - position and moving state by prediction
+**************************************************************************************************/
+#include "AlpacaFocuserTrajectory.h"
+
+void AlpacaFocuserTrajectory::_write(const AlpacaFocuserMove_t &move)
+{
+    _seq = _seq + 1;
+    __sync_synchronize();
+    _move = move;
+    _published = true;
+    __sync_synchronize();
+    _seq = _seq + 1;
+}
+
+// retried while a writer is active; false if nothing is published
+bool AlpacaFocuserTrajectory::_read(AlpacaFocuserMove_t &move) const
+{
+    uint32_t seq;
+    bool published;
+    do
+    {
+        seq = _seq;
+        __sync_synchronize();
+        move = _move;
+        published = _published;
+        __sync_synchronize();
+    } while ((seq & 1) != 0 || seq != _seq);
+    return published;
+}
+
+/**
+ * Position on the profile. Acceleration and deceleration take T = v / a and v T / 2 steps each;
+ * trapezoid s(t) = v t^2 / 2T, S-curve s(t) = v / 2 (t - T / pi sin(pi t / T)). Short moves do
+ * not reach the speed: v = sqrt(a d).
+ */
+int32_t AlpacaFocuserTrajectory::_profile(const AlpacaFocuserMove_t &move, int64_t now_us, bool &overrun)
+{
+    float distance = (float)abs(move.target - move.start);
+    overrun = true;
+    if (distance == 0.0f)
+        return move.target;
+    float accel = max(move.accel, 1.0f);
+    float speed = min(max(move.speed, 1.0f), sqrtf(accel * distance));
+    float t_ramp = speed / accel;
+    float d_ramp = speed * t_ramp / 2.0f;
+    float t_cruise = (distance - 2.0f * d_ramp) / speed;
+    float t = (float)(now_us - move.start_us) / 1000000.0f;
+    float s;
+
+    overrun = t >= 2.0f * t_ramp + t_cruise;
+    if (overrun)
+        return move.target;
+    float t_phase = t <= t_ramp ? t : (t <= t_ramp + t_cruise ? 0.0f : 2.0f * t_ramp + t_cruise - t);
+    float s_phase = move.s_curve ? speed / 2.0f * (t_phase - t_ramp / (float)M_PI * sinf((float)M_PI * t_phase / t_ramp))
+                                 : speed * t_phase * t_phase / (2.0f * t_ramp);
+    if (t <= t_ramp)
+        s = s_phase;
+    else if (t <= t_ramp + t_cruise)
+        s = d_ramp + speed * (t - t_ramp);
+    else
+        s = distance - s_phase;
+    return move.start + (move.target > move.start ? 1 : -1) * (int32_t)lroundf(s);
+}
+
+void AlpacaFocuserTrajectory::Publish(int32_t start, int32_t target, float speed, float accel, bool s_curve)
+{
+    AlpacaFocuserMove_t move = {start, target, speed, accel, s_curve, esp_timer_get_time(), 0, 0, start == target, false};
+    portENTER_CRITICAL(&_mux);
+    _write(move);
+    portEXIT_CRITICAL(&_mux);
+}
+
+// at rest: the measured position ends the move; moving: offset to the profile, blended out until the target
+void AlpacaFocuserTrajectory::Correct(int32_t position, bool moving)
+{
+    int64_t now_us = esp_timer_get_time();
+    bool overrun = false;
+    portENTER_CRITICAL(&_mux);
+    AlpacaFocuserMove_t move = _move;
+    if (!_published || !moving)
+    {
+        move.start = move.target = position;
+        move.ended = true;
+        move.expired = false;
+    }
+    else
+    {
+        int32_t predicted = _profile(move, now_us, overrun);
+        move.offset = position - predicted;
+        move.offset_remaining = abs(move.target - predicted);
+        move.ended = false;
+    }
+    _write(move);
+    portEXIT_CRITICAL(&_mux);
+}
+
+void AlpacaFocuserTrajectory::Expire()
+{
+    portENTER_CRITICAL(&_mux);
+    if (_published && !_move.ended)
+    {
+        AlpacaFocuserMove_t move = _move;
+        move.expired = true;
+        _write(move);
+    }
+    portEXIT_CRITICAL(&_mux);
+}
+
+void AlpacaFocuserTrajectory::Clear()
+{
+    portENTER_CRITICAL(&_mux);
+    _seq = _seq + 1;
+    __sync_synchronize();
+    _published = false;
+    __sync_synchronize();
+    _seq = _seq + 1;
+    portEXIT_CRITICAL(&_mux);
+}
+
+bool AlpacaFocuserTrajectory::Estimate(int32_t &position, bool &moving, bool &overdue) const
+{
+    AlpacaFocuserMove_t move;
+    if (!_read(move) || move.ended)
+        return false;
+
+    bool overrun = false;
+    position = _profile(move, esp_timer_get_time(), overrun);
+    if (move.offset != 0 && move.offset_remaining > 0)
+        position += (int32_t)((int64_t)move.offset * min(abs(move.target - position), move.offset_remaining) / move.offset_remaining);
+    moving = true;
+    overdue = overrun || move.expired;
+    return true;
+}
@@ -0,0 +1,55 @@
+/**************************************************************************************************
+  Filename:       AlpacaFocuserTrajectory.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 02 $
+  Description:    Published move of a focuser driver - position and moving state by prediction
+
+  A driver that runs its moves itself publishes each move (start, target, speed, acceleration,
+  profile, start time). Position and IsMoving are then evaluated from the profile without driver
+  calls. The driver corrects the prediction with the measured position at the end of the move or
+  when an encoder reading comes in; a correction during the move is blended out until the target.
+  Once the move has ended there is nothing to predict: at rest the driver is asked again.
+  Readers are lock-free: the move is published under a sequence counter (seqlock) and copied
+  until the counter is even and unchanged. Writers are serialized by a spinlock.
+**************************************************************************************************/
+#pragma once
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "AlpacaConfig.h"
+
+struct AlpacaFocuserMove_t
+{
+    int32_t start;
+    int32_t target;
+    float speed;             // [steps/s]
+    float accel;             // [steps/s^2]; mean acceleration of the S-curve
+    bool s_curve;
+    int64_t start_us;
+    int32_t offset;          // correction at offset_remaining steps before the target
+    int32_t offset_remaining;
+    bool ended;              // confirmed at rest on target
+    bool expired;            // halted or overrun; the driver knows better than the profile
+};
+
+class AlpacaFocuserTrajectory
+{
+private:
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+    volatile uint32_t _seq = 0; // odd while the move is written
+    AlpacaFocuserMove_t _move = {0, 0, 0.0f, 0.0f, false, 0, 0, 0, true, false};
+    bool _published = false;
+
+    void _write(const AlpacaFocuserMove_t &move);
+    bool _read(AlpacaFocuserMove_t &move) const;
+    static int32_t _profile(const AlpacaFocuserMove_t &move, int64_t now_us, bool &overrun);
+
+public:
+    void Publish(int32_t start, int32_t target, float speed, float accel, bool s_curve);
+    void Correct(int32_t position, bool moving);
+    void Expire(); // e.g. halted: predicted end is now
+    void Clear();  // no prediction; position and moving state come from the driver again
+
+    // false if nothing is published or the move has ended; overdue: profile ended or expired
+    // without the driver's end correction
+    bool Estimate(int32_t &position, bool &moving, bool &overdue) const;
+};
@@ -0,0 +1,72 @@
+/**************************************************************************************************
+  Filename:       AlpacaJsonAllocator.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    ArduinoJson allocator that counts the heap in use and its peak
+
+  Used by LoadSettings()/SaveSettings() for the settings metrics and by the host benchmark of
+  the settings file format (test/test_settings_format). Not thread safe; the server uses it
+  under its settings lock.
+**************************************************************************************************/
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+class AlpacaJsonPeakAllocator : public ArduinoJson::Allocator
+{
+private:
+    // every block starts with its size, so deallocate() knows what is returned
+    static const size_t kHeader = sizeof(max_align_t);
+    size_t _used = 0;
+    size_t _peak = 0;
+
+    void _add(size_t size)
+    {
+        _used += size;
+        if (_used > _peak)
+            _peak = _used;
+    }
+
+public:
+    void *allocate(size_t size) override
+    {
+        uint8_t *block = (uint8_t *)malloc(kHeader + size);
+        if (block == nullptr)
+            return nullptr;
+        *(size_t *)block = size;
+        _add(size);
+        return block + kHeader;
+    }
+
+    void deallocate(void *ptr) override
+    {
+        if (ptr == nullptr)
+            return;
+        uint8_t *block = (uint8_t *)ptr - kHeader;
+        _used -= *(size_t *)block;
+        free(block);
+    }
+
+    void *reallocate(void *ptr, size_t new_size) override
+    {
+        if (ptr == nullptr)
+            return allocate(new_size);
+        uint8_t *block = (uint8_t *)ptr - kHeader;
+        size_t old_size = *(size_t *)block;
+        block = (uint8_t *)realloc(block, kHeader + new_size);
+        if (block == nullptr)
+            return nullptr;
+        *(size_t *)block = new_size;
+        _used -= old_size;
+        _add(new_size);
+        return block + kHeader;
+    }
+
+    // count an allocation outside of ArduinoJson, e.g. the serialization buffer, while it is held
+    void Hold(size_t size) { _add(size); }
+    void Release(size_t size) { _used -= size; }
+
+    const size_t GetUsed() { return _used; }
+    const size_t GetPeak() { return _peak; }
+    void ResetPeak() { _peak = _used; }
+};
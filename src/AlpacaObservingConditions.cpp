@@ -11,7 +11,7 @@
 AlpacaObservingConditions::AlpacaObservingConditions()
 {
     strlcpy(_device_type, ALPACA_OBSERVING_CONDITIONS_DEVICE_TYPE, sizeof(_device_type));
-    strlcpy(_device_description, ALPACA_OBSERVING_CONDITIONS_DESCRIPTION, sizeof(_device_description));
+    strlcpy(_general.description, ALPACA_OBSERVING_CONDITIONS_DESCRIPTION, sizeof(_general.description));
     strlcpy(_driver_info, ALPACA_OBSERVING_CONDITIONS_DRIVER_INFO, sizeof(_driver_info));
     strlcpy(_device_and_driver_version, esp32_alpaca_device_library_version, sizeof(_device_and_driver_version));
     _device_interface_version = ALPACA_OBSERVING_CONDITIONS_INTERFACE_VERSION;
@@ -21,7 +21,9 @@ AlpacaObservingConditions::AlpacaObservingConditions()
         _sensors[i].value = 0.0;
         _sensors[i].update_time_ms = 0.0;
         _sensors[i].is_implemented = false;
+        _sensors[i].history_ms = 0;
     }
+    _sensors[kOcWindDirectionSensorIdx].series.SetCircular(true);
 
     // Don't change the sensor names
     strlcpy(_sensors[kOcCloudCoverSensorIdx].sensor_name, "CloudCover", kMaxSensorName);
@@ -82,6 +84,7 @@ void AlpacaObservingConditions::RegisterCallbacks()
     this->createCallBack(LHF(_alpacaGetTimeSinceLastUpdate), HTTP_GET, "timesincelastupdate");
     this->createCallBack(LHF(_alpacaPutAveragePeriod), HTTP_PUT, "averageperiod");
     this->createCallBack(LHF(_alpacaPutRefresh), HTTP_PUT, "refresh");
+    this->createCallBack(LHF(_alpacaGetHistory), HTTP_GET, "history"); // extension
 };
 
 
@@ -101,7 +104,7 @@ void AlpacaObservingConditions::_alpacaGetAveragePeriod(AsyncWebServerRequest *r
         _service_counter++;                                                                                                                            \
         uint32_t client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kIgnoreCase);                                              \
         if (_sensors[_IDX_].is_implemented)                                                                                                            \
-            _alpaca_server->Respond(request, _clients[client_idx], _rsp_status, _sensors[_IDX_].value);                                                \
+            _alpaca_server->Respond(request, _clients[client_idx], _rsp_status, _sensors[_IDX_].series.Mean());                                        \
         else if (_rsp_status.error_code == AlpacaErrorCode_t::Ok)                                                                                      \
             _alpaca_server->Respond(request, _clients[client_idx], _rspStatusSensorNotImplemented(request, _rsp_status, _sensors[_IDX_].sensor_name)); \
         else                                                                                                                                           \
@@ -185,6 +188,96 @@ mycatch: // empty
     DBG_END
 }
 
+// state of a history stream; one sample formatted ahead
+struct OCHistoryStream_t
+{
+    AlpacaSensorHistoryReader reader;
+    char pending[96];
+    size_t len;
+    size_t pos;
+    bool first;
+    bool done;
+};
+
+// extension: samples of sensor SensorName after Since [ms of device uptime], streamed as
+// {"Sensor": <name>, "Now": <uptime ms>, "PeriodMs": <sample period>, "Samples": [[<ms>, <value>], ...]}
+// Clients poll with Since = time of the latest sample they have.
+void AlpacaObservingConditions::_alpacaGetHistory(AsyncWebServerRequest *request)
+{
+    _service_counter++;
+    char sensor_name[kMaxSensorName] = "";
+    uint32_t since = 0;
+    uint32_t client_idx = 0;
+    OCSensorIdx_t sensor_idx;
+    std::shared_ptr<OCHistoryStream_t> stream;
+
+    if ((client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kIgnoreCase)) == 0)
+        goto mycatch;
+
+    if (_alpaca_server->GetParam(request, "SensorName", sensor_name, sizeof(sensor_name), Spelling_t::kIgnoreCase) == false &&
+        _alpaca_server->GetParam(request, "Sensor", sensor_name, sizeof(sensor_name), Spelling_t::kIgnoreCase) == false)
+        MYTHROW_RspStatusParameterNotFound(request, _rsp_status, "SensorName");
+
+    if (_getSensorIdxByName(sensor_name, sensor_idx) == false)
+    {
+        _rsp_status.error_code = AlpacaErrorCode_t::InvalidValue;
+        _rsp_status.http_status = HttpStatus_t::kPassed;
+        snprintf(_rsp_status.error_msg, sizeof(_rsp_status.error_msg), "%s - Sensor '%s' invalid", request->url().c_str(), sensor_name);
+        goto mycatch;
+    }
+    if (!_sensors[sensor_idx].is_implemented)
+    {
+        _rspStatusSensorNotImplemented(request, _rsp_status, sensor_name);
+        goto mycatch;
+    }
+    if (!_alpaca_server->GetParam(request, "Since", since, Spelling_t::kIgnoreCase))
+        since = 0;
+
+    stream = std::make_shared<OCHistoryStream_t>();
+    stream->reader.Begin(&_sensors[sensor_idx].history, since);
+    stream->len = snprintf(stream->pending, sizeof(stream->pending), "{\"Sensor\": \"%s\", \"Now\": %u, \"PeriodMs\": %u, \"Samples\": [",
+                           _sensors[sensor_idx].sensor_name, (uint32_t)millis(), kAlpacaOcHistoryPeriodMs);
+    stream->pos = 0;
+    stream->first = true;
+    stream->done = false;
+    _alpaca_server->RespondChunked(request, _clients[client_idx], _rsp_status, [stream](char *buffer, size_t max_len) -> size_t
+                                   {
+        size_t n = 0;
+        while (n < max_len)
+        {
+            if (stream->pos == stream->len)
+            {
+                uint32_t time_ms;
+                float value;
+                if (stream->done)
+                    break;
+                if (stream->reader.Next(time_ms, value))
+                {
+                    char value_str[24] = "null";
+                    if (isfinite(value))
+                        snprintf(value_str, sizeof(value_str), "%.7g", value);
+                    stream->len = snprintf(stream->pending, sizeof(stream->pending), "%s[%u, %s]", stream->first ? "" : ", ", time_ms, value_str);
+                    stream->first = false;
+                }
+                else
+                {
+                    stream->len = snprintf(stream->pending, sizeof(stream->pending), "]}");
+                    stream->done = true;
+                }
+                stream->pos = 0;
+            }
+            size_t len = min(max_len - n, stream->len - stream->pos);
+            memcpy(buffer + n, stream->pending + stream->pos, len);
+            n += len;
+            stream->pos += len;
+        }
+        return n; });
+    return;
+
+mycatch:
+    _alpaca_server->Respond(request, _clients[client_idx], _rsp_status);
+}
+
 void AlpacaObservingConditions::_alpacaPutAveragePeriod(AsyncWebServerRequest *request)
 {
     DBG_OBSERVING_CONDITIONS_GET_PUT_AVERAGE_PERIOD
@@ -199,8 +292,10 @@ void AlpacaObservingConditions::_alpacaPutAveragePeriod(AsyncWebServerRequest *r
         if (_alpaca_server->GetParam(request, "AveragePeriod", average_period, Spelling_t::kStrict) == false)
             MYTHROW_RspStatusParameterNotFound(request, _rsp_status, "AvaragePeriod");
 
-        if (_putAveragePeriodRequest(average_period) == false)
+        if (average_period < 0.0 || average_period > kAlpacaOcMaxAveragePeriodH || _putAveragePeriodRequest(average_period) == false)
             MYTHROW_RspStatusParameterInvalidDoubleValue(request, _rsp_status, "AvaragePeriod", average_period);
+
+        SetAveragePeriod(average_period);
     
     mycatch: // empty
  
@@ -249,11 +344,25 @@ const bool AlpacaObservingConditions::SetSensorValueByIdx(OCSensorIdx_t idx, dou
     {
         _sensors[idx].value = value;
         _sensors[idx].update_time_ms = update_time_ms;
+        _sensors[idx].series.Add(value, update_time_ms);
+        if (_sensors[idx].is_implemented && (_sensors[idx].history_ms == 0 || update_time_ms - _sensors[idx].history_ms >= kAlpacaOcHistoryPeriodMs))
+        {
+            _sensors[idx].history.Add(update_time_ms, (float)value);
+            _sensors[idx].history_ms = update_time_ms;
+        }
         return true;
     }
     return false;
 }
 
+// AveragePeriod [h]; sensor getters return the mean over this period, 0 the latest value
+void AlpacaObservingConditions::SetAveragePeriod(double average_period)
+{
+    _average_period = average_period;
+    for (int i = 0; i < (int)OCSensorIdx_t::kOcMaxSensorIdx; i++)
+        _sensors[i].series.SetWindow((uint32_t)(average_period * 3600000.0));
+}
+
 const bool AlpacaObservingConditions::SetSensorDescriptionByIdx(OCSensorIdx_t idx, const char *description)
 {
     if (idx < kOcMaxSensorIdx)
@@ -269,7 +378,28 @@ const bool AlpacaObservingConditions::SetSensorImplementedByIdx(OCSensorIdx_t id
     if (idx < kOcMaxSensorIdx)
     {
         _sensors[idx].is_implemented = is_implemented;
+        if (is_implemented)
+            _sensors[idx].history.Begin();
         return true;
     }
     return false;
 }
+
+size_t AlpacaObservingConditions::AlpacaGetMetrics(AlpacaMetric_t *metrics, size_t n)
+{
+    AlpacaSensorHistoryStats_t total = {0, 0, 0};
+    for (int i = 0; i < (int)OCSensorIdx_t::kOcMaxSensorIdx; i++)
+    {
+        AlpacaSensorHistoryStats_t stats;
+        _sensors[i].history.GetStats(stats);
+        total.samples += stats.samples;
+        total.bytes += stats.bytes;
+        total.bits += stats.bits;
+    }
+    if (n < 3)
+        return 0;
+    metrics[0] = {"observingconditions_history_samples", "gauge", total.samples};
+    metrics[1] = {"observingconditions_history_bytes", "gauge", total.bytes};
+    metrics[2] = {"observingconditions_history_encoded_bytes", "gauge", (total.bits + 7) / 8};
+    return 3;
+}
@@ -8,6 +8,8 @@
 **************************************************************************************************/
 #pragma once
 #include "AlpacaDevice.h"
+#include "AlpacaSensorSeries.h"
+#include "AlpacaSensorHistory.h"
 
 const uint32_t kMaxSensorName = 32;
 const uint32_t kMaxSensorDescription = 128;
@@ -17,6 +19,9 @@ struct OCSensor_t                             // Sensor description
   char sensor_name[kMaxSensorName];        // sensor name as defined by Alpaca
   char description[kMaxSensorDescription]; // sensor description from user
   double value;                               // latest sensor value
+  AlpacaSensorSeries series;                  // samples of the AveragePeriod
+  AlpacaSensorHistory history;                // compressed samples every kAlpacaOcHistoryPeriodMs
+  uint32_t history_ms;                        // latest history sample
   uint32_t update_time_ms;                    // latest sensor update time using system time/ [ms]
   bool is_implemented;                        //
 };
@@ -61,6 +66,7 @@ private:
   void _alpacaGetWindSpeed(AsyncWebServerRequest *request);
   void _alpacaGetSensordescription(AsyncWebServerRequest *request);
   void _alpacaGetTimeSinceLastUpdate(AsyncWebServerRequest *request);
+  void _alpacaGetHistory(AsyncWebServerRequest *request);
 
   void _alpacaPutAveragePeriod(AsyncWebServerRequest *request);
   void _alpacaPutRefresh(AsyncWebServerRequest *request);
@@ -84,12 +90,14 @@ protected:
   const bool SetSensorValueByIdx(OCSensorIdx_t idx, double value, uint32_t update_time_ms);
   const bool SetSensorDescriptionByIdx(OCSensorIdx_t idx, const char *description);
   const bool SetSensorImplementedByIdx(OCSensorIdx_t idx, bool is_implemented);
-  void SetAveragePeriod(bool average_period) { _average_period = average_period; };
+  void SetAveragePeriod(double average_period);
 
   const double GetSensorValueByIdx(OCSensorIdx_t idx) { return _sensors[idx<kOcMaxSensorIdx?idx : kOcCloudCoverSensorIdx].value;};
+  const double GetSensorMeanByIdx(OCSensorIdx_t idx) { return _sensors[idx<kOcMaxSensorIdx?idx : kOcCloudCoverSensorIdx].series.Mean();};
   const bool GetSensorImplementedByIdx(OCSensorIdx_t idx) { return _sensors[idx<kOcMaxSensorIdx?idx : kOcCloudCoverSensorIdx].is_implemented;};
   const char* GetSensorNameByIdx(OCSensorIdx_t idx) { return _sensors[idx<kOcMaxSensorIdx?idx : kOcCloudCoverSensorIdx].sensor_name;};
   const char* GetSensorDescriptionByIdx(OCSensorIdx_t idx) { return _sensors[idx<kOcMaxSensorIdx?idx : kOcCloudCoverSensorIdx].description;};
 
 public:
+  size_t AlpacaGetMetrics(AlpacaMetric_t *metrics, size_t n);
 };
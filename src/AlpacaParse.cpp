@@ -0,0 +1,77 @@
+/**************************************************************************************************
+  Filename:       AlpacaParse.cpp
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Parsers of network input - query parameter values, JSON request bodies and
+                  discovery packets
+**************************************************************************************************/
+#include "AlpacaParse.h"
+#include <errno.h>
+#include <float.h>
+
+static bool _parseTail(const char *end)
+{
+    while (*end == ' ' || *end == '\t')
+        end++;
+    return *end == '\0';
+}
+
+bool AlpacaParse::Double(const char *str, double &value)
+{
+    char *end = nullptr;
+    errno = 0;
+    double v = strtod(str, &end);
+    if (end == str || errno == ERANGE || !isfinite(v) || !_parseTail(end))
+        return false;
+    value = v;
+    return true;
+}
+
+bool AlpacaParse::Float(const char *str, float &value)
+{
+    double v = 0.0;
+    if (!Double(str, v) || fabs(v) > FLT_MAX)
+        return false;
+    value = (float)v;
+    return true;
+}
+
+bool AlpacaParse::Int32(const char *str, int32_t &value)
+{
+    char *end = nullptr;
+    errno = 0;
+    long long v = strtoll(str, &end, 10);
+    if (end == str || errno == ERANGE || v < INT32_MIN || v > INT32_MAX || !_parseTail(end))
+        return false;
+    value = (int32_t)v;
+    return true;
+}
+
+bool AlpacaParse::UInt32(const char *str, uint32_t &value)
+{
+    while (*str == ' ' || *str == '\t')
+        str++;
+    if (*str == '-') // strtoull silently negates
+        return false;
+    char *end = nullptr;
+    errno = 0;
+    unsigned long long v = strtoull(str, &end, 10);
+    if (end == str || errno == ERANGE || v > UINT32_MAX || !_parseTail(end))
+        return false;
+    value = (uint32_t)v;
+    return true;
+}
+
+DeserializationError AlpacaParse::Json(JsonDocument &doc, const uint8_t *data, size_t len)
+{
+    return deserializeJson(doc, (const char *)data, len, DeserializationOption::NestingLimit(kAlpacaJsonNestingLimit));
+}
+
+bool AlpacaParse::Discovery(const uint8_t *data, size_t len, uint8_t &version)
+{
+    const size_t header_len = sizeof(kAlpacaDiscoveryHeader) - 1;
+    if (data == nullptr || len < header_len + 1 || memcmp(data, kAlpacaDiscoveryHeader, header_len) != 0)
+        return false;
+    version = data[header_len];
+    return true;
+}
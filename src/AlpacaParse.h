@@ -0,0 +1,33 @@
+/**************************************************************************************************
+  Filename:       AlpacaParse.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Parsers of network input - query parameter values, JSON request bodies and
+                  discovery packets
+
+  Free of the web server, so they are built on the host as well: see test/fuzz.
+**************************************************************************************************/
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+const uint8_t kAlpacaJsonNestingLimit = 8; // max nesting of setup/settings JSON
+const char kAlpacaDiscoveryHeader[] = "alpacadiscovery";
+
+class AlpacaParse
+{
+public:
+    // numeric parameters; the whole string has to be consumed (trailing blanks allowed) and the
+    // value has to fit into the target type. Decimal only - no octal or hex.
+    static bool Double(const char *str, double &value);
+    static bool Float(const char *str, float &value);
+    static bool Int32(const char *str, int32_t &value);
+    static bool UInt32(const char *str, uint32_t &value);
+
+    // JSON body of a request; nesting deeper than kAlpacaJsonNestingLimit is rejected
+    static DeserializationError Json(JsonDocument &doc, const uint8_t *data, size_t len);
+
+    // UDP discovery request: header "alpacadiscovery" and the version byte are mandatory, the
+    // reserved bytes after them are ignored; false for anything else
+    static bool Discovery(const uint8_t *data, size_t len, uint8_t &version);
+};
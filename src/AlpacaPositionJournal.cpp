@@ -0,0 +1,176 @@
+/**************************************************************************************************
+  Filename:       AlpacaPositionJournal.cpp
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Position journal - latest value of a few keys over resets in a flash partition
+**************************************************************************************************/
+#include "AlpacaPositionJournal.h"
+#include <esp_crc.h>
+#include <esp_timer.h>
+#include "AlpacaDebug.h"
+
+uint32_t AlpacaPositionJournal::_crc(const AlpacaPositionJournalRecord_t &record)
+{
+    return esp_crc32_le(0, (const uint8_t *)&record, offsetof(AlpacaPositionJournalRecord_t, crc));
+}
+
+bool AlpacaPositionJournal::_erased(const AlpacaPositionJournalRecord_t &record)
+{
+    const uint32_t *words = (const uint32_t *)&record;
+    for (size_t i = 0; i < sizeof(record) / sizeof(uint32_t); i++)
+        if (words[i] != 0xffffffff)
+            return false;
+    return true;
+}
+
+const AlpacaPositionJournalRecord_t *AlpacaPositionJournal::_find(uint16_t key) const
+{
+    for (uint32_t i = 0; i < _n_latest; i++)
+        if (_latest[i].key == key)
+            return &_latest[i];
+    return nullptr;
+}
+
+/**
+ * Latest record of every key and the append position: the slot after the last programmed one in
+ * the sector holding the highest sequence number. Nothing valid found - the first write erases
+ * sector 0.
+ */
+bool AlpacaPositionJournal::Begin()
+{
+    int64_t start_us = esp_timer_get_time();
+    AlpacaPositionJournalRecord_t buffer[16];
+    bool found = false;
+
+    _partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)kAlpacaJournalPartitionSubtype, kAlpacaJournalPartitionLabel);
+    if (_partition == nullptr || _partition->size / kSectorSize < 2)
+    {
+        _partition = nullptr;
+        SLOG_WARNING_PRINTF("journal partition '%s' not found; positions are lost on reset\n", kAlpacaJournalPartitionLabel);
+        return false;
+    }
+    _sectors = _partition->size / kSectorSize;
+    _n_latest = 0;
+
+    for (uint32_t sector = 0; sector < _sectors; sector++)
+    {
+        uint32_t used = 0;
+        bool sector_valid = false;
+        uint32_t sector_seq = 0;
+        for (uint32_t slot = 0; slot < kSlots; slot += 16)
+        {
+            if (esp_partition_read(_partition, sector * kSectorSize + slot * sizeof(AlpacaPositionJournalRecord_t), buffer, sizeof(buffer)) != ESP_OK)
+            {
+                _partition = nullptr;
+                SLOG_ERROR_PRINTF("journal read error\n");
+                return false;
+            }
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                const AlpacaPositionJournalRecord_t &record = buffer[i];
+                if (_erased(record))
+                    continue;
+                used = slot + i + 1;
+                if (record.crc != _crc(record))
+                {
+                    _stats.torn++;
+                    continue;
+                }
+                if (!sector_valid || record.seq > sector_seq)
+                    sector_seq = record.seq;
+                sector_valid = true;
+
+                AlpacaPositionJournalRecord_t *latest = (AlpacaPositionJournalRecord_t *)_find(record.key);
+                if (latest == nullptr && _n_latest < kAlpacaJournalMaxKeys)
+                    _latest[_n_latest++] = record;
+                else if (latest != nullptr && record.seq > latest->seq)
+                    *latest = record;
+            }
+        }
+        if (sector_valid && (!found || sector_seq > _seq))
+        {
+            found = true;
+            _seq = sector_seq;
+            _sector = sector;
+            _slot = used;
+        }
+    }
+    if (!found)
+    {
+        _seq = 0;
+        _sector = _sectors - 1;
+        _slot = kSlots;
+    }
+
+    _stats.recover_us = (uint32_t)(esp_timer_get_time() - start_us);
+    SLOG_INFO_PRINTF("journal %u sectors, %u keys, seq %u, %u torn, %u us\n", _sectors, _n_latest, _seq, _stats.torn, _stats.recover_us);
+    return true;
+}
+
+bool AlpacaPositionJournal::_program(AlpacaPositionJournalRecord_t &record)
+{
+    record.seq = _seq + 1;
+    record.crc = _crc(record);
+    size_t offset = _sector * kSectorSize + _slot * sizeof(AlpacaPositionJournalRecord_t);
+    _slot++; // a failed write may have programmed some bits; never reuse the slot
+    if (esp_partition_write(_partition, offset, &record, sizeof(record)) != ESP_OK)
+        return false;
+    _seq = record.seq;
+    _stats.records++;
+    return true;
+}
+
+// erase the next sector and carry the latest record of every key over
+bool AlpacaPositionJournal::_nextSector()
+{
+    uint32_t sector = (_sector + 1) % _sectors;
+    if (esp_partition_erase_range(_partition, sector * kSectorSize, kSectorSize) != ESP_OK)
+    {
+        SLOG_ERROR_PRINTF("journal erase error, sector %u\n", sector);
+        return false;
+    }
+    _stats.erases++;
+    _sector = sector;
+    _slot = 0;
+    for (uint32_t i = 0; i < _n_latest; i++)
+        if (!_program(_latest[i]))
+            return false;
+    return true;
+}
+
+bool AlpacaPositionJournal::Write(uint16_t key, int32_t value, uint16_t flags)
+{
+    if (_partition == nullptr)
+        return false;
+    AlpacaPositionJournalRecord_t *latest = (AlpacaPositionJournalRecord_t *)_find(key);
+    if (latest != nullptr && latest->value == value && latest->flags == flags)
+        return true;
+    if (latest == nullptr && _n_latest >= kAlpacaJournalMaxKeys)
+    {
+        SLOG_ERROR_PRINTF("journal full, key %04x not written\n", key);
+        return false;
+    }
+
+    AlpacaPositionJournalRecord_t record = {0, key, flags, value, 0};
+    if (_slot >= kSlots && !_nextSector())
+        return false;
+    if (!_program(record))
+    {
+        SLOG_ERROR_PRINTF("journal write error, key %04x\n", key);
+        return false;
+    }
+    if (latest == nullptr)
+        latest = &_latest[_n_latest++];
+    *latest = record;
+    return true;
+}
+
+bool AlpacaPositionJournal::Read(uint16_t key, int32_t &value, uint16_t &flags) const
+{
+    const AlpacaPositionJournalRecord_t *latest = _find(key);
+    if (latest == nullptr)
+        return false;
+    value = latest->value;
+    flags = latest->flags;
+    return true;
+}
@@ -0,0 +1,75 @@
+/**************************************************************************************************
+  Filename:       AlpacaPositionJournal.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Position journal - latest value of a few keys over resets in a flash partition
+
+  Fixed size records (sequence number, key, flags, value, CRC32) are appended to the data
+  partition kAlpacaJournalPartitionLabel, sector after sector. A sector is erased right before
+  use and starts with the latest record of every key, so the next sector can always be reused:
+  the wear is spread over all sectors and no key is lost. A record torn by a reset fails the CRC
+  and is skipped; the previous record of its key stays valid. Begin() scans the partition once
+  and keeps the latest record of every key in RAM. Without the partition, e.g. with the default
+  partition table, the journal is disabled. Write() from the loop task only.
+**************************************************************************************************/
+#pragma once
+#include <Arduino.h>
+#include <esp_partition.h>
+#include "AlpacaConfig.h"
+
+// owner of a journal key; key = kind << 8 | device number
+enum struct AlpacaPositionJournalKind_t : uint8_t
+{
+    kFocuserPosition = 1, // [steps]
+    kDomeAzimuth = 2      // [0.01 deg]; flags bit 0 - homed
+};
+
+struct AlpacaPositionJournalRecord_t
+{
+    uint32_t seq;   // increasing over the partition
+    uint16_t key;
+    uint16_t flags;
+    int32_t value;
+    uint32_t crc;   // CRC32 of the fields above
+};
+
+// journal statistics for /metrics
+struct AlpacaPositionJournalStats_t
+{
+    uint32_t records;    // written since boot
+    uint32_t erases;     // sector erases since boot
+    uint32_t torn;       // records failing the CRC at boot
+    uint32_t recover_us; // scan time at boot
+};
+
+class AlpacaPositionJournal
+{
+private:
+    static const uint32_t kSectorSize = 4096;
+    static const uint32_t kSlots = kSectorSize / sizeof(AlpacaPositionJournalRecord_t);
+
+    const esp_partition_t *_partition = nullptr;
+    uint32_t _sectors = 0;
+    uint32_t _sector = 0; // sector of the next record
+    uint32_t _slot = 0;   // slot of the next record in _sector
+    uint32_t _seq = 0;    // of the latest record
+    AlpacaPositionJournalRecord_t _latest[kAlpacaJournalMaxKeys];
+    uint32_t _n_latest = 0;
+    AlpacaPositionJournalStats_t _stats = {0, 0, 0, 0};
+
+    static uint32_t _crc(const AlpacaPositionJournalRecord_t &record);
+    static bool _erased(const AlpacaPositionJournalRecord_t &record);
+    const AlpacaPositionJournalRecord_t *_find(uint16_t key) const;
+    bool _program(AlpacaPositionJournalRecord_t &record); // at _sector/_slot with the next seq
+    bool _nextSector();
+
+public:
+    static uint16_t Key(AlpacaPositionJournalKind_t kind, int32_t device_number) { return (uint16_t)(((uint8_t)kind << 8) | (device_number & 0xff)); };
+
+    bool Begin(); // finds and scans the partition; false - journal disabled
+    bool IsOpen() const { return _partition != nullptr; };
+
+    bool Write(uint16_t key, int32_t value, uint16_t flags = 0); // no flash write if unchanged
+    bool Read(uint16_t key, int32_t &value, uint16_t &flags) const;
+    void GetStats(AlpacaPositionJournalStats_t &stats) const { stats = _stats; };
+};
@@ -9,10 +9,11 @@
 AlpacaSafetyMonitor::AlpacaSafetyMonitor()
 {
     strlcpy(_device_type, ALPACA_SAFETYMONITOR_DEVICE_TYPE, sizeof(_device_type));
-    strlcpy(_device_description, ALPACA_SAFETYMONITOR_DESCRIPTION, sizeof(_device_description));
+    strlcpy(_general.description, ALPACA_SAFETYMONITOR_DESCRIPTION, sizeof(_general.description));
     strlcpy(_driver_info, ALPACA_SAFETYMONITOR_DRIVER_INFO, sizeof(_driver_info));
     strlcpy(_device_and_driver_version, esp32_alpaca_device_library_version, sizeof(_device_and_driver_version));
     _device_interface_version = ALPACA_SAFETYMONITOR_INTERFACE_VERSION;
+    _addCachedValue(&_is_safe_value);
 
 }
 
@@ -39,10 +40,15 @@ void AlpacaSafetyMonitor::_alpacaGetIsSafe(AsyncWebServerRequest *request)
 	
     uint32_t client_idx = checkClientDataAndConnection(request, client_idx, Spelling_t::kIgnoreCase);
 	if (client_idx > 0)
-		_is_safe = _getIsSafe();
+		_is_safe = _is_safe_value.Get([this]() { return _getIsSafe(); });
 	
     _alpaca_server->Respond(request, _clients[client_idx], _rsp_status, _is_safe);
     //DBG_END
 }
 
-
+// state for the events of AlpacaServer
+void AlpacaSafetyMonitor::AlpacaWriteState(JsonObject &root)
+{
+    AlpacaDevice::AlpacaWriteState(root);
+    root["IsSafe"] = _is_safe_value.Get([this]() { return _getIsSafe(); });
+}
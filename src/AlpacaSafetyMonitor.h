@@ -19,10 +19,13 @@ private:
   virtual const bool _getIsSafe() = 0;
 
 protected:
+  AlpacaCachedValue<bool> _is_safe_value{"IsSafe", ALPACA_SAFETYMONITOR_IS_SAFE_TTL_MS};
+
   // Interface for specific implementation
   AlpacaSafetyMonitor();
   void Begin();
   void RegisterCallbacks();
 
 public:
+    void AlpacaWriteState(JsonObject &root);
 };
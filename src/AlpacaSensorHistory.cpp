@@ -0,0 +1,294 @@
+/**************************************************************************************************
+  Filename:       AlpacaSensorHistory.cpp
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 02 $
+  Description:    Compressed history of an ObservingConditions sensor - Gorilla encoded blocks
+**************************************************************************************************/
+#include "AlpacaSensorHistory.h"
+#include <esp_heap_caps.h>
+#include "AlpacaDebug.h"
+
+// bits MSB first; data must be zeroed beyond pos
+static void _putBits(uint8_t *data, uint32_t &pos, uint32_t value, uint8_t n)
+{
+    for (int i = n - 1; i >= 0; i--, pos++)
+    {
+        if ((value >> i) & 1)
+            data[pos >> 3] |= (uint8_t)(0x80 >> (pos & 7));
+    }
+}
+
+static uint32_t _getBits(const uint8_t *data, uint32_t &pos, uint8_t n)
+{
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < n; i++, pos++)
+        value = (value << 1) | ((data[pos >> 3] >> (7 - (pos & 7))) & 1);
+    return value;
+}
+
+static uint32_t _floatBits(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+bool AlpacaSensorHistory::Begin()
+{
+    if (_blocks != nullptr)
+        return true;
+    uint32_t bytes = psramFound() ? kAlpacaOcHistoryPsramBytes : kAlpacaOcHistoryBytes;
+    uint32_t caps = psramFound() ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT;
+    _n_blocks = bytes / sizeof(AlpacaSensorHistoryBlock_t);
+    _blocks = (AlpacaSensorHistoryBlock_t *)heap_caps_malloc(_n_blocks * sizeof(AlpacaSensorHistoryBlock_t), caps);
+    if (_blocks == nullptr)
+    {
+        SLOG_ERROR_PRINTF("sensor history of %u bytes not allocated\n", bytes);
+        _n_blocks = 0;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Encoded into a scratch buffer first; the block is only changed if the sample fits.
+ * Worst case 4 + 32 bits time, 2 + 10 + 32 bits value.
+ */
+uint32_t AlpacaSensorHistory::Encode(uint8_t *data, uint32_t bit_pos, uint32_t bit_len, AlpacaSensorHistoryCodec_t &codec, uint32_t time_ms, float value)
+{
+    uint8_t scratch[12] = {0};
+    uint32_t n = 0;
+    AlpacaSensorHistoryCodec_t next = codec;
+
+    next.time_ms = time_ms;
+    next.delta_ms = (int32_t)(time_ms - codec.time_ms);
+    int32_t dod = next.delta_ms - codec.delta_ms;
+    if (dod == 0)
+        _putBits(scratch, n, 0b0, 1);
+    else if (dod >= -63 && dod <= 64)
+    {
+        _putBits(scratch, n, 0b10, 2);
+        _putBits(scratch, n, (uint32_t)(dod + 63), 7);
+    }
+    else if (dod >= -255 && dod <= 256)
+    {
+        _putBits(scratch, n, 0b110, 3);
+        _putBits(scratch, n, (uint32_t)(dod + 255), 9);
+    }
+    else if (dod >= -2047 && dod <= 2048)
+    {
+        _putBits(scratch, n, 0b1110, 4);
+        _putBits(scratch, n, (uint32_t)(dod + 2047), 12);
+    }
+    else
+    {
+        _putBits(scratch, n, 0b1111, 4);
+        _putBits(scratch, n, (uint32_t)dod, 32);
+    }
+
+    next.value = _floatBits(value);
+    uint32_t x = next.value ^ codec.value;
+    if (x == 0)
+    {
+        _putBits(scratch, n, 0b0, 1);
+    }
+    else
+    {
+        uint8_t leading = (uint8_t)__builtin_clz(x);
+        uint8_t trailing = (uint8_t)__builtin_ctz(x);
+        if (codec.leading != 0xFF && leading >= codec.leading && trailing >= codec.trailing)
+        {
+            _putBits(scratch, n, 0b10, 2);
+            _putBits(scratch, n, x >> codec.trailing, 32 - codec.leading - codec.trailing);
+        }
+        else
+        {
+            uint8_t len = 32 - leading - trailing;
+            _putBits(scratch, n, 0b11, 2);
+            _putBits(scratch, n, leading, 5);
+            _putBits(scratch, n, len - 1, 5);
+            _putBits(scratch, n, x >> trailing, len);
+            next.leading = leading;
+            next.trailing = trailing;
+        }
+    }
+
+    if (bit_pos + n > bit_len)
+        return 0;
+    for (uint32_t pos = 0; pos < n;)
+    {
+        uint8_t chunk = (uint8_t)min(n - pos, (uint32_t)32);
+        _putBits(data, bit_pos, _getBits(scratch, pos, chunk), chunk);
+    }
+    codec = next;
+    return n;
+}
+
+uint32_t AlpacaSensorHistory::Decode(const uint8_t *data, uint32_t bit_pos, AlpacaSensorHistoryCodec_t &codec, uint32_t &time_ms, float &value)
+{
+    uint32_t pos = bit_pos;
+    int32_t dod = 0;
+
+    if (_getBits(data, pos, 1) == 0)
+        dod = 0;
+    else if (_getBits(data, pos, 1) == 0)
+        dod = (int32_t)_getBits(data, pos, 7) - 63;
+    else if (_getBits(data, pos, 1) == 0)
+        dod = (int32_t)_getBits(data, pos, 9) - 255;
+    else if (_getBits(data, pos, 1) == 0)
+        dod = (int32_t)_getBits(data, pos, 12) - 2047;
+    else
+        dod = (int32_t)_getBits(data, pos, 32);
+    codec.delta_ms += dod;
+    codec.time_ms += (uint32_t)codec.delta_ms;
+
+    if (_getBits(data, pos, 1) == 1)
+    {
+        if (_getBits(data, pos, 1) == 1)
+        {
+            codec.leading = (uint8_t)_getBits(data, pos, 5);
+            uint8_t len = (uint8_t)_getBits(data, pos, 5) + 1;
+            codec.trailing = 32 - codec.leading - len;
+        }
+        codec.value ^= _getBits(data, pos, 32 - codec.leading - codec.trailing) << codec.trailing;
+    }
+
+    time_ms = codec.time_ms;
+    memcpy(&value, &codec.value, sizeof(value));
+    return pos - bit_pos;
+}
+
+void AlpacaSensorHistory::Add(uint32_t time_ms, float value)
+{
+    if (_blocks == nullptr)
+        return;
+
+    portENTER_CRITICAL(&_mux);
+    uint32_t n = 0;
+    if (_next_id > _first_id)
+    {
+        AlpacaSensorHistoryBlock_t &block = _block(_next_id - 1);
+        n = Encode(block.data, block.bits, sizeof(block.data) * 8, _encoder, time_ms, value);
+        if (n > 0)
+        {
+            block.bits += n;
+            block.count++;
+        }
+    }
+    if (n == 0)
+    {
+        if (_next_id - _first_id == _n_blocks)
+        {
+            _samples -= _block(_first_id).count;
+            _bits -= _block(_first_id).bits;
+            _first_id++;
+        }
+        AlpacaSensorHistoryBlock_t &block = _block(_next_id);
+        block.id = _next_id++;
+        block.first_ms = time_ms;
+        block.first_value = value;
+        block.count = 1;
+        block.bits = 0;
+        memset(block.data, 0, sizeof(block.data));
+        _encoder = {time_ms, 0, _floatBits(value), 0xFF, 0};
+    }
+    _samples++;
+    _bits += n;
+    portEXIT_CRITICAL(&_mux);
+}
+
+bool AlpacaSensorHistory::ReadBlock(uint32_t &id, AlpacaSensorHistoryBlock_t &block, bool &newest)
+{
+    bool ok = false;
+    portENTER_CRITICAL(&_mux);
+    if (id < _first_id)
+        id = _first_id;
+    if (id < _next_id)
+    {
+        block = _block(id);
+        newest = id == _next_id - 1;
+        ok = true;
+    }
+    portEXIT_CRITICAL(&_mux);
+    return ok;
+}
+
+uint32_t AlpacaSensorHistory::FindBlock(uint32_t since_ms)
+{
+    portENTER_CRITICAL(&_mux);
+    uint32_t lo = _first_id; // binary search; blocks are in time order
+    uint32_t hi = _next_id;
+    while (hi - lo > 1)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if ((int32_t)(_block(mid).first_ms - since_ms) <= 0)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    portEXIT_CRITICAL(&_mux);
+    return lo;
+}
+
+void AlpacaSensorHistory::GetStats(AlpacaSensorHistoryStats_t &stats)
+{
+    portENTER_CRITICAL(&_mux);
+    stats.samples = _samples;
+    stats.bytes = _n_blocks * sizeof(AlpacaSensorHistoryBlock_t);
+    stats.bits = _bits;
+    portEXIT_CRITICAL(&_mux);
+}
+
+// since_ms = 0: whole history
+void AlpacaSensorHistoryReader::Begin(AlpacaSensorHistory *history, uint32_t since_ms)
+{
+    _history = history;
+    _since_ms = since_ms;
+    _id = since_ms == 0 ? 0 : history->FindBlock(since_ms);
+    _loaded = false;
+}
+
+/**
+ * A block with unread samples: the refreshed copy of the newest block, which continues at _index
+ * since the writer only appends, or the next block. False if there is no new sample yet.
+ */
+bool AlpacaSensorHistoryReader::_load()
+{
+    while (!_loaded || _index >= _block.count)
+    {
+        uint32_t id = !_loaded ? _id : (_newest ? _block.id : _block.id + 1);
+        uint32_t copied = _loaded ? _block.id : 0;
+        bool loaded = _loaded;
+        if (!_history->ReadBlock(id, _block, _newest))
+            return false;
+        if (!loaded || _block.id != copied)
+            _index = 0; // next block; or the copied one was dropped meanwhile
+        else if (_index >= _block.count && _newest)
+            return false;
+        _loaded = true;
+    }
+    return true;
+}
+
+bool AlpacaSensorHistoryReader::Next(uint32_t &time_ms, float &value)
+{
+    do
+    {
+        if (!_load())
+            return false;
+        if (_index == 0)
+        {
+            time_ms = _block.first_ms;
+            value = _block.first_value;
+            _codec = {time_ms, 0, 0, 0xFF, 0};
+            memcpy(&_codec.value, &value, sizeof(value));
+            _bit_pos = 0;
+        }
+        else
+        {
+            _bit_pos += AlpacaSensorHistory::Decode(_block.data, _bit_pos, _codec, time_ms, value);
+        }
+        _index++;
+    } while (_since_ms != 0 && (int32_t)(time_ms - _since_ms) <= 0);
+    return true;
+}
@@ -0,0 +1,99 @@
+/**************************************************************************************************
+  Filename:       AlpacaSensorHistory.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 02 $
+  Description:    Compressed history of an ObservingConditions sensor - Gorilla encoded blocks
+
+  Samples are appended to fixed-size blocks of a ring allocated once (PSRAM when present); the
+  oldest block is dropped when the ring is full. Each block holds its first sample in the header
+  and encodes the following ones as bit stream:
+  - time: delta of the delta to the previous sample [ms]; '0' for 0, '10' + 7 bits,
+    '110' + 9 bits, '1110' + 12 bits, '1111' + 32 bits
+  - value: XOR with the previous value (IEEE float); '0' for equal, '10' + the meaningful bits
+    within the leading/trailing zeros of the previous XOR, '11' + 5 bits leading zeros +
+    5 bits length - 1 + the meaningful bits
+  Regular samples of a slowly changing sensor take 1 bit for the time and a few bits for the
+  value. Readers copy one block at a time, so a stream is never blocked by the writer. The copy of
+  the newest block is refreshed when its samples are read: the writer may have appended more.
+**************************************************************************************************/
+#pragma once
+#include <Arduino.h>
+#include "AlpacaConfig.h"
+
+struct AlpacaSensorHistoryBlock_t
+{
+    uint32_t id;        // sequence number of the block
+    uint32_t first_ms;  // first sample
+    float first_value;
+    uint16_t count;     // samples incl. the first
+    uint16_t bits;      // used bits of data
+    uint8_t data[kAlpacaOcHistoryBlockSize - 16];
+};
+
+struct AlpacaSensorHistoryStats_t
+{
+    uint32_t samples;   // stored
+    uint32_t bytes;     // allocated
+    uint32_t bits;      // encoded bits of the stored samples; block headers excluded
+};
+
+// encoder and decoder state of one block
+struct AlpacaSensorHistoryCodec_t
+{
+    uint32_t time_ms;
+    int32_t delta_ms;
+    uint32_t value;     // float bits
+    uint8_t leading;    // window of the previous XOR; leading = 0xFF if none
+    uint8_t trailing;
+};
+
+class AlpacaSensorHistory
+{
+private:
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+    AlpacaSensorHistoryBlock_t *_blocks = nullptr;
+    uint32_t _n_blocks = 0;
+    uint32_t _first_id = 0; // oldest block
+    uint32_t _next_id = 0;  // block after the one written
+    AlpacaSensorHistoryCodec_t _encoder = {0, 0, 0, 0xFF, 0};
+    uint32_t _samples = 0;  // in the ring
+    uint32_t _bits = 0;
+
+    AlpacaSensorHistoryBlock_t &_block(uint32_t id) { return _blocks[id % _n_blocks]; };
+
+public:
+    bool Begin(); // allocates the ring; PSRAM when present
+    void Add(uint32_t time_ms, float value);
+
+    // block copies for readers; false if id is not (yet) written. Older ids are moved to the oldest block.
+    // newest: the writer may still append to the block
+    bool ReadBlock(uint32_t &id, AlpacaSensorHistoryBlock_t &block, bool &newest);
+    uint32_t FindBlock(uint32_t since_ms); // last block starting at or before since_ms
+
+    void GetStats(AlpacaSensorHistoryStats_t &stats);
+
+    // codec of a block; returns the encoded bits, 0 if they do not fit
+    static uint32_t Encode(uint8_t *data, uint32_t bit_pos, uint32_t bit_len, AlpacaSensorHistoryCodec_t &codec, uint32_t time_ms, float value);
+    static uint32_t Decode(const uint8_t *data, uint32_t bit_pos, AlpacaSensorHistoryCodec_t &codec, uint32_t &time_ms, float &value);
+};
+
+// streams the samples after since_ms; one block copy per Next() of a new block
+class AlpacaSensorHistoryReader
+{
+private:
+    AlpacaSensorHistory *_history = nullptr;
+    uint32_t _since_ms = 0;
+    uint32_t _id = 0;
+    AlpacaSensorHistoryBlock_t _block;
+    AlpacaSensorHistoryCodec_t _codec;
+    uint32_t _index = 0;    // next sample of _block
+    uint32_t _bit_pos = 0;
+    bool _loaded = false;
+    bool _newest = false;   // _block was the newest block when copied
+
+    bool _load();
+
+public:
+    void Begin(AlpacaSensorHistory *history, uint32_t since_ms);
+    bool Next(uint32_t &time_ms, float &value); // false at the end
+};
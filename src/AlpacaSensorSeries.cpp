@@ -0,0 +1,115 @@
+/**************************************************************************************************
+  Filename:       AlpacaSensorSeries.cpp
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 02 $
+  Description:    Time series of an ObservingConditions sensor - sliding mean over AveragePeriod
+**************************************************************************************************/
+#include "AlpacaSensorSeries.h"
+
+// buckets are not re-binned; after a longer window the ring fills up with the new bucket length
+void AlpacaSensorSeries::SetWindow(uint32_t window_ms)
+{
+    portENTER_CRITICAL(&_mux);
+    _window_ms = window_ms;
+    _bucket_ms = window_ms / (kAlpacaOcSeriesSize - 1);
+    _evictBefore(millis());
+    portEXIT_CRITICAL(&_mux);
+}
+
+void AlpacaSensorSeries::Clear()
+{
+    portENTER_CRITICAL(&_mux);
+    _oldest = 0;
+    _len = 0;
+    _resum();
+    portEXIT_CRITICAL(&_mux);
+}
+
+void AlpacaSensorSeries::Add(double value, uint32_t time_ms)
+{
+    float x = (float)value;
+    float y = 0.0f;
+    if (_circular)
+    {
+        x = cosf((float)(value * DEG_TO_RAD));
+        y = sinf((float)(value * DEG_TO_RAD));
+    }
+
+    portENTER_CRITICAL(&_mux);
+    _latest = value;
+    AlpacaSensorBucket_t *newest = _len > 0 ? &_buckets[(_oldest + _len - 1) % kAlpacaOcSeriesSize] : nullptr;
+    if (newest == nullptr || time_ms - newest->time_ms >= _bucket_ms)
+    {
+        if (_len == kAlpacaOcSeriesSize)
+            _evict();
+        newest = &_buckets[(_oldest + _len) % kAlpacaOcSeriesSize];
+        *newest = {time_ms, 0, 0.0f, 0.0f};
+        _len++;
+    }
+    newest->count++;
+    newest->x += x;
+    newest->y += y;
+    _count++;
+    _sum_x += x;
+    _sum_y += y;
+
+    _evictBefore(time_ms);
+    portEXIT_CRITICAL(&_mux);
+}
+
+// the window ends now, also when the sensor stopped sending samples; the math is done outside the mux
+double AlpacaSensorSeries::Mean()
+{
+    uint32_t now_ms = millis();
+    portENTER_CRITICAL(&_mux);
+    _evictBefore(now_ms);
+    bool window = _window_ms > 0;
+    double sum_x = _sum_x;
+    double sum_y = _sum_y;
+    uint32_t count = _count;
+    double latest = _latest;
+    portEXIT_CRITICAL(&_mux);
+
+    if (!window || count == 0)
+        return latest;
+    if (!_circular)
+        return sum_x / (double)count;
+    if (fabs(sum_x) + fabs(sum_y) < 1e-6 * (double)count)
+        return latest; // opposite directions cancel out
+    return fmod(atan2(sum_y, sum_x) * RAD_TO_DEG + 360.0, 360.0);
+}
+
+// drop the buckets that started more than the window before now_ms; the newest one stays
+void AlpacaSensorSeries::_evictBefore(uint32_t now_ms)
+{
+    while (_len > 1 && now_ms - _buckets[_oldest].time_ms > _window_ms)
+        _evict();
+    if (_evictions >= kAlpacaOcSeriesSize)
+        _resum();
+}
+
+void AlpacaSensorSeries::_evict()
+{
+    AlpacaSensorBucket_t &bucket = _buckets[_oldest];
+    _count -= bucket.count;
+    _sum_x -= bucket.x;
+    _sum_y -= bucket.y;
+    _oldest = (_oldest + 1) % kAlpacaOcSeriesSize;
+    _len--;
+    _evictions++;
+}
+
+void AlpacaSensorSeries::_resum()
+{
+    _count = 0;
+    _sum_x = 0.0;
+    _sum_y = 0.0;
+    for (uint32_t i = 0; i < _len; i++)
+    {
+        const AlpacaSensorBucket_t &bucket = _buckets[(_oldest + i) % kAlpacaOcSeriesSize];
+        _count += bucket.count;
+        _sum_x += bucket.x;
+        _sum_y += bucket.y;
+    }
+    _evictions = 0;
+}
@@ -0,0 +1,55 @@
+/**************************************************************************************************
+  Filename:       AlpacaSensorSeries.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 02 $
+  Description:    Time series of an ObservingConditions sensor - sliding mean over AveragePeriod
+
+  Samples are collected in a fixed ring of time buckets; a bucket spans window / (size - 1), so
+  the ring covers the whole AveragePeriod at any sample rate. Running totals of all buckets are
+  updated when a sample is added and when the oldest bucket leaves the window, also on a read
+  after the sensor stopped; the mean is O(1) per sample and per read. Angles (wind direction)
+  are averaged as unit vectors. The totals are summed anew from the buckets once per ring length
+  to drop rounding drift.
+**************************************************************************************************/
+#pragma once
+#include <Arduino.h>
+#include "AlpacaConfig.h"
+
+struct AlpacaSensorBucket_t
+{
+    uint32_t time_ms; // first sample
+    uint32_t count;
+    float x;          // sum of values; cos of angles
+    float y;          // sum of sin of angles
+};
+
+class AlpacaSensorSeries
+{
+private:
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+    AlpacaSensorBucket_t _buckets[kAlpacaOcSeriesSize];
+    uint32_t _oldest = 0;
+    uint32_t _len = 0;
+    bool _circular = false;
+    uint32_t _window_ms = 0;
+    uint32_t _bucket_ms = 0;
+    double _sum_x = 0.0;
+    double _sum_y = 0.0;
+    uint32_t _count = 0;
+    uint32_t _evictions = 0;
+    double _latest = 0.0;
+
+    void _evict();
+    void _evictBefore(uint32_t now_ms); // call under _mux
+    void _resum();
+
+public:
+    void SetCircular(bool circular) { _circular = circular; }; // angles in deg
+    void SetWindow(uint32_t window_ms);
+    void Add(double value, uint32_t time_ms);
+    void Clear();
+
+    // mean over the window before millis(); the latest sample for a window of 0
+    double Mean();
+    double Latest() const { return _latest; };
+};
@@ -14,40 +14,30 @@
 #include <esp_wifi.h>
 #include "AlpacaServer.h"
 #include "AlpacaDevice.h"
+#ifdef ALPACA_EMBEDDED_WEB_ASSETS
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include "AlpacaWebAssets.h"
+#endif
 #ifdef ALPACA_ENABLE_OTA_UPDATE
 //#include "ElegantOTA.h"
 #endif
 
-// discovery package
-typedef struct
-{
-private:
-    char _header[15];
-    char _version;
-    char _reserved[48];
-
-public:
-    bool valid() { return strncmp(_header, "alpacadiscovery", sizeof("alpacadiscovery") - 1) == 0; }
-    char version() { return _version; }
-} AlpacaDiscoveryPacket;
-
-static_assert(sizeof(AlpacaDiscoveryPacket) == kAlpacaDiscoveryLength, "Wrong size of struct");
-
-typedef union
-{
-    AlpacaDiscoveryPacket data;
-    char buffer[kAlpacaDiscoveryLength];
-} AlpacaDiscoveryBuffer;
+static bool _loadSettingsPart(const char *path, bool msgpack, JsonDocument &filter, JsonDocument &doc);
 
 AlpacaServer::AlpacaServer(const String mng_server_name,
                            const String mng_manufacture,
                            const String mng_manufacture_version,
                            const String mng_location)
 {
-    _mng_server_name = mng_server_name;
+    strlcpy(_settings.name, mng_server_name.c_str(), sizeof(_settings.name));
     _mng_manufacture = mng_manufacture;
     _mng_manufacture_version = mng_manufacture_version;
     _mng_location = mng_location;
+    _settings_mutex = xSemaphoreCreateRecursiveMutex();
+    _events_mutex = xSemaphoreCreateMutex();
+    _settings_epoch = esp_random();
 }
 
 // initialize alpaca server
@@ -59,8 +49,8 @@ void AlpacaServer::Begin(uint16_t udp_port, uint16_t tcp_port, bool mount_little
     // Get unique ID from wifi macadr. Default 000000000000
     uint8_t mac_adr[6] = {0};
     esp_wifi_get_mac(WIFI_IF_STA, mac_adr);
-    snprintf(_uid, sizeof(_uid), "%02X%02X%02X%02X%02X%02X", mac_adr[0], mac_adr[1], mac_adr[2], mac_adr[3], mac_adr[4], mac_adr[5]);
-    SLOG_PRINTF(SLOG_DEBUG, "_uid=%s\n", _uid);
+    snprintf(_settings.uid, sizeof(_settings.uid), "%02X%02X%02X%02X%02X%02X", mac_adr[0], mac_adr[1], mac_adr[2], mac_adr[3], mac_adr[4], mac_adr[5]);
+    SLOG_PRINTF(SLOG_DEBUG, "_uid=%s\n", _settings.uid);
 
     RspStatusClear(_mng_rsp_status);
     // Setup filesystem
@@ -71,19 +61,42 @@ void AlpacaServer::Begin(uint16_t udp_port, uint16_t tcp_port, bool mount_little
             SLOG_ERROR_PRINTF("LittleFS mounting error\n");
         }
     }
+    _position_journal.Begin();
 
-    // setup ports
-    _port_udp = udp_port;
-    _port_tcp = tcp_port;
+    // setup ports; saved ports take precedence
+    _settings.port_udp = udp_port;
+    _settings.port_tcp = tcp_port;
+    _loadPorts();
 
-    SLOG_INFO_PRINTF("Ascom Alpaca discovery UDP port %d\n", _port_udp);
+    SLOG_INFO_PRINTF("Ascom Alpaca discovery UDP port %d\n", _settings.port_udp);
 
-    _server_udp.listen(_port_udp);
+    _server_udp.listen(_settings.port_udp);
     _server_udp.onPacket([this](AsyncUDPPacket &udpPacket)
                          { this->OnAlpacaDiscovery(udpPacket); });
 
-    SLOG_INFO_PRINTF("Ascom Alpaca server TCP port %d\n", _port_tcp)
+    _beginTCP();
+}
 
+// ports of the settings file, so the servers start on the saved ports; the other settings are read by LoadSettings()
+void AlpacaServer::_loadPorts()
+{
+    const char *path = LittleFS.exists(kAlpacaSettingsPath) ? kAlpacaSettingsPath : kAlpacaSettingsJsonPath;
+    JsonDocument filter;
+    filter["TCP_port"] = true;
+    filter["UDP_port"] = true;
+    JsonDocument doc;
+    if (!LittleFS.exists(path) || !_loadSettingsPart(path, path == kAlpacaSettingsPath, filter, doc))
+        return;
+    JsonObject root = doc.as<JsonObject>();
+    AlpacaSettings::Read(kAlpacaServerSettings, root, &_settings);
+}
+
+// create and start the TCP server on _settings.port_tcp
+void AlpacaServer::_beginTCP()
+{
+    SLOG_INFO_PRINTF("Ascom Alpaca server TCP port %d\n", _settings.port_tcp)
+
+    _port_tcp = _settings.port_tcp;
     _server_tcp = new AsyncWebServer(_port_tcp);
     _server_tcp->begin();
 
@@ -98,12 +111,37 @@ void AlpacaServer::Begin(uint16_t udp_port, uint16_t tcp_port, bool mount_little
 #endif
 }
 
+/*
+ * Rebind discovery to a changed UDP port; called from Loop()
+ * The TCP server keeps its port until the next start: AsyncWebServer can not tell when the connections of a
+ * replaced server are gone, and handlers added by the sketch and event subscribers would be lost with it.
+ */
+void AlpacaServer::_rebind()
+{
+    if (!_rebind_udp)
+        return;
+    if ((millis() - _rebind_request_ms) < kAlpacaRebindDelayMs) // let the response of the setup POST go out first
+        return;
+
+    _rebind_udp = false;
+    SLOG_PRINTF(SLOG_NOTICE, "rebind discovery to UDP port %d\n", _settings.port_udp);
+    _server_udp.close();
+    if (!_server_udp.listen(_settings.port_udp))
+        SLOG_ERROR_PRINTF("discovery could not listen on UDP port %d\n", _settings.port_udp);
+}
+
 void AlpacaServer::Loop()
 {
     for (int32_t i = 0; i < _n_devices; i++)
     {
         _device[i]->CheckClientConnectionTimeout();
+        _device[i]->LockDriver();
+        _device[i]->Loop();
+        _device[i]->UnlockDriver();
     }
+    _flushSettings();
+    _rebind();
+    _pollState();
 #ifdef ALPACA_ENABLE_OTA_UPDATE
     ElegantOTA.loop();
 #endif
@@ -137,14 +175,97 @@ void AlpacaServer::AddDevice(AlpacaDevice *device)
     SLOG_INFO_PRINTF("ADD deviceType=%s deviceNumber=%d\n", deviceType, deviceNumber);
 }
 
+/*
+ * Register handler for JSON request bodies of up to max_length bytes on url
+ * The body is collected in the request and parsed by AlpacaParse::Json() with the nesting limit; bodies that
+ * are too long or no valid JSON are answered here. Replaces AsyncCallbackJsonWebHandler, which has no
+ * nesting limit.
+ */
+void AlpacaServer::OnJson(const char *url, WebRequestMethodComposite method, size_t max_length, AlpacaJsonHandler_t handler)
+{
+    _server_tcp->on(
+        url, method,
+        [handler, max_length](AsyncWebServerRequest *request)
+        {
+            JsonDocument doc;
+            const uint8_t *body = (const uint8_t *)request->_tempObject;
+            if (request->contentLength() > max_length)
+            {
+                request->send(413, "text/plain", "Request body too large");
+                return;
+            }
+            DeserializationError error = AlpacaParse::Json(doc, body, body != nullptr ? request->contentLength() : 0);
+            if (error)
+            {
+                SLOG_WARNING_PRINTF("%s %s: %s\n", WebRequestMethod2Str(request->method()), request->url().c_str(), error.c_str());
+                request->send(400, "text/plain", error.c_str());
+                return;
+            }
+            JsonObject root = doc.as<JsonObject>();
+            handler(request, root);
+        },
+        nullptr,
+        [max_length](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)
+        {
+            // freed with the request
+            if (index == 0 && total <= max_length && request->_tempObject == nullptr)
+                request->_tempObject = malloc(total);
+            if (request->_tempObject != nullptr && index + len <= total)
+                memcpy((uint8_t *)request->_tempObject + index, data, len);
+        });
+}
+
 /*
  * Setup Server REST API
  */
 void AlpacaServer::RegisterCallbacks()
 {
-    // ServeStatic settings
-    SLOG_INFO_PRINTF("REGISTER serveStatic url=%s fs=LittleFS path=%s\n", kAlpacaSettingsPath, kAlpacaSettingsPath);
-    _server_tcp->serveStatic(kAlpacaSettingsPath, LittleFS, kAlpacaSettingsPath);
+    // server-sent events of device state changes; a new subscriber gets the full state with the next event
+    SLOG_INFO_PRINTF("REGISTER handler for \"%s\" to _pollState\n", kAlpacaEventsPath);
+    _events = new AsyncEventSource(kAlpacaEventsPath);
+    _events->onConnect([this](AsyncEventSourceClient *client)
+                       {
+                           xSemaphoreTake(_events_mutex, portMAX_DELAY);
+                           bool added = _n_subscribers < kAlpacaEventsMaxSubscribers;
+                           if (added)
+                               _subscribers[_n_subscribers++] = {client, true};
+                           xSemaphoreGive(_events_mutex);
+                           if (!added)
+                               SLOG_WARNING_PRINTF("more than %u event subscribers; no events for the new one\n", kAlpacaEventsMaxSubscribers); });
+    _events->onDisconnect([this](AsyncEventSourceClient *client)
+                          {
+                              xSemaphoreTake(_events_mutex, portMAX_DELAY);
+                              for (size_t i = 0; i < _n_subscribers; i++)
+                              {
+                                  if (_subscribers[i].client == client)
+                                  {
+                                      _subscribers[i] = _subscribers[--_n_subscribers];
+                                      break;
+                                  }
+                              }
+                              xSemaphoreGive(_events_mutex); });
+    _server_tcp->addHandler(_events);
+
+    // HTTP_GET /settings.json - export of all settings as JSON
+    SLOG_INFO_PRINTF("REGISTER handler for \"%s\" to _getSettingsJson\n", kAlpacaSettingsJsonPath);
+    _server_tcp->on(kAlpacaSettingsJsonPath, HTTP_GET, LHF(_getSettingsJson));
+
+    // handler for HTTP_POST /settings.json - import of all settings as JSON
+    SLOG_INFO_PRINTF("REGISTER handler for \"%s\" to _readSettings\n", kAlpacaSettingsJsonPath);
+    OnJson(kAlpacaSettingsJsonPath, HTTP_POST, kAlpacaMaxSettingsContentLength, [this](AsyncWebServerRequest *request, JsonObject &root)
+           {
+        SLOG_PRINTF(SLOG_INFO, "BEGIN REQ (%s %s) ...\n", WebRequestMethod2Str(request->method()), request->url().c_str());
+        DBG_REQ
+        if (root)
+        {
+            this->LockSettings();
+            this->_readSettings(root);
+            this->UnlockSettings();
+            this->_markSettingsDirty(0xFFFFFFFF);
+        }
+        request->send(200, F("application/json"), "{\"recieved\":\"true\"}");
+        SLOG_PRINTF(SLOG_INFO, "... END REQ AlpacaServer::*jsonhandler(%s)\n", request->url().c_str());
+        DBG_END });
 
     // HTTP_GET /management/*
     SLOG_INFO_PRINTF("REGISTER handler for \"/management/apiversions\" to _getApiVersions\n");
@@ -158,6 +279,14 @@ void AlpacaServer::RegisterCallbacks()
     SLOG_INFO_PRINTF("REGISTER handler for \"/jsondata\" to _getJsondata\n");
     _server_tcp->on("/jsondata", HTTP_GET, LHF(_getJsondata));
 
+    // HTTP_GET /schema
+    SLOG_INFO_PRINTF("REGISTER handler for \"/schema\" to _getSchema\n");
+    _server_tcp->on("/schema", HTTP_GET, LHF(_getSchema));
+
+    // HTTP_GET /metrics
+    SLOG_INFO_PRINTF("REGISTER handler for \"/metrics\" to _getMetrics\n");
+    _server_tcp->on("/metrics", HTTP_GET, LHF(_getMetrics));
+
     // HTTP_GET /links
     SLOG_INFO_PRINTF("REGISTER handler for \"/links\" to _getLinks\n");
     _server_tcp->on("/links", HTTP_GET, LHF(_getLinks));
@@ -166,27 +295,52 @@ void AlpacaServer::RegisterCallbacks()
     SLOG_INFO_PRINTF("REGISTER handler for \"/setup\" to _getLinks\n");
     _server_tcp->on("/setup", HTTP_GET, LHF(_getSetupPage));
 
-    // handler for HTTP_POST /jsondata
-    {
-        const char url[] = "/jsondata";
-        AsyncCallbackJsonWebHandler *jsonhandler = new AsyncCallbackJsonWebHandler(url, [this](AsyncWebServerRequest *request, JsonVariant &json)
-                                                                                   {
-            SLOG_PRINTF(SLOG_INFO, "BEGIN REQ (%s %s) ...\n", WebRequestMethod2Str(request->method()), request->url().c_str());
-            DBG_REQ
-            JsonObject jsonObj = json.as<JsonObject>();
-            this->_readJson(jsonObj);
-            request->send(200, F("application/json"), "{\"recieved\":\"true\"}"); 
-                SLOG_PRINTF(SLOG_INFO, "... END REQ AlpacaServer::*jsonhandler(%s)\n", request->url().c_str());    
-                DBG_END });
-
-        SLOG_PRINTF(SLOG_INFO, "ADD HANDLER jsonhandler for %s\n", url);
-        _server_tcp->addHandler(jsonhandler);
-    }
+    // handler for HTTP_POST and HTTP_PATCH /jsondata
+    // POST: whole form; PATCH: only the changed keys, response with per-field errors
+    SLOG_INFO_PRINTF("REGISTER handler for \"/jsondata\" to _readJson\n");
+    OnJson("/jsondata", HTTP_POST | HTTP_PATCH, kAlpacaMaxJsonContentLength, [this](AsyncWebServerRequest *request, JsonObject &root)
+           {
+        SLOG_PRINTF(SLOG_INFO, "BEGIN REQ (%s %s) ...\n", WebRequestMethod2Str(request->method()), request->url().c_str());
+        DBG_REQ
+        if (request->method() == HTTP_PATCH)
+        {
+            JsonDocument rsp;
+            JsonObject errors = rsp["errors"].to<JsonObject>();
+            if (root && root.size() > 0)
+            {
+                JsonDocument known_doc;
+                JsonObject known = known_doc.to<JsonObject>();
+                this->LockSettings();
+                this->_writeJson(known);
+                AlpacaSettings::Unknown(root, known, errors);
+                this->_readJson(root, errors);
+                this->UnlockSettings();
+                if (AlpacaSettings::Count(root) > AlpacaSettings::Count(errors)) // at least one value applied
+                    this->MarkSettingsDirty();
+            }
+            String ser_json = "";
+            serializeJson(rsp, ser_json);
+            request->send(errors.size() == 0 ? 200 : 400, kAlpacaJsonType, ser_json);
+        }
+        else
+        {
+            if (root)
+            {
+                this->LockSettings();
+                this->_readJson(root);
+                this->UnlockSettings();
+                this->MarkSettingsDirty();
+            }
+            request->send(200, F("application/json"), "{\"recieved\":\"true\"}");
+        }
+        SLOG_PRINTF(SLOG_INFO, "... END REQ AlpacaServer::*jsonhandler(%s)\n", request->url().c_str());
+        DBG_END });
 
     // HTTP_GET /save_settings
     _server_tcp->on("/save_settings", HTTP_GET, [this](AsyncWebServerRequest *request)
                     {
         SLOG_PRINTF(SLOG_INFO, "BEGIN REQ (%s) ...\n", request->url().c_str());               
+        this->_markSettingsDirty(0xFFFFFFFF, false); // whole file, also the sections merged from flash
         if (this->SaveSettings())
             request->send(200,"application/json","{\"saved\":true}");
         else
@@ -203,10 +357,20 @@ void AlpacaServer::RegisterCallbacks()
         request->send(200,"application/json","{\"activated\":true}");
         DBG_END; });
 
+#ifdef ALPACA_EMBEDDED_WEB_ASSETS
+    // static assets from flash
+    for (size_t i = 0; i < kAlpacaWebAssetsCount; i++)
+    {
+        const char *url = kAlpacaWebAssets[i].url;
+        SLOG_INFO_PRINTF("REGISTER embedded url=%s len=%d etag=%s\n", url, kAlpacaWebAssets[i].len, kAlpacaWebAssets[i].etag);
+        _server_tcp->on(url, HTTP_GET, [this, url](AsyncWebServerRequest *request)
+                        { this->_sendEmbedded(request, url); });
+    }
+#else
     // ServeStatic settings
     {
         const char url[] = "/favicon.ico";
-        const char path[] = "/favicon.ico";
+        const char path[] = "/www/TSS.ico";
         SLOG_INFO_PRINTF("REGISTER serveStatic url=%s fs=LittleFS path=%s\n", url, path);
         getServerTCP()->serveStatic(url, LittleFS, path).setCacheControl("max-age=600");
     }    
@@ -222,6 +386,7 @@ void AlpacaServer::RegisterCallbacks()
         SLOG_INFO_PRINTF("REGISTER serveStatic url=%s fs=LittleFS path=%s\n", url, path);
         getServerTCP()->serveStatic(url, LittleFS, path).setCacheControl("max-age=600");
     }
+#endif
 }
 
 void AlpacaServer::_getApiVersions(AsyncWebServerRequest *request)
@@ -246,7 +411,7 @@ void AlpacaServer::_getDescription(AsyncWebServerRequest *request)
     char mng_description[1024] = {0};
     snprintf(mng_description, sizeof(mng_description),
              "{\"ServerName\":\"%s\",\"Manufacturer\":\"%s\",\"ManufacturerVersion\":\"%s\",\"Location\":\"%s\"}",
-             _mng_server_name.c_str(), _mng_manufacture.c_str(), _mng_manufacture_version.c_str(), _mng_location.c_str());
+             _settings.name, _mng_manufacture.c_str(), _mng_manufacture_version.c_str(), _mng_location.c_str());
     Respond(request, _mng_client_id, _mng_rsp_status, mng_description, JsonValue_t::kAsPlainStringValue);
     DBG_END
 }
@@ -330,36 +495,35 @@ bool AlpacaServer::GetParam(AsyncWebServerRequest *request, const char *name, bo
     return result;
 }
 
-// get value of parameter 'name' in PUT request and return true, return false if not found
+// get value of parameter 'name' in PUT request and return true, return false if not found or invalid
 bool AlpacaServer::GetParam(AsyncWebServerRequest *request, const char *name, double &value, Spelling_t spelling)
 {
     int32_t index = _paramIndex(request, name, spelling);
     if (index >= 0)
     {
-        return sscanf(request->arg(index).c_str(), "%lf", &value) == 1;
+        return AlpacaParse::Double(request->arg(index).c_str(), value);
     }
     return false;
 }
 
-// get value of parameter 'name' in PUT request and return true, return false if not found
+// get value of parameter 'name' in PUT request and return true, return false if not found or invalid
 bool AlpacaServer::GetParam(AsyncWebServerRequest *request, const char *name, float &value, Spelling_t spelling)
 {
     int32_t index = _paramIndex(request, name, spelling);
     if (index >= 0)
     {
-        return sscanf(request->arg(index).c_str(), "%f", &value) == 1;
+        return AlpacaParse::Float(request->arg(index).c_str(), value);
     }
     return false;
 }
 
-// using namespace std;
-//  get value of parameter 'name' in PUT request and return true, return false if not found
+//  get value of parameter 'name' in PUT request and return true, return false if not found or invalid
 bool AlpacaServer::GetParam(AsyncWebServerRequest *request, const char *name, int32_t &value, Spelling_t spelling)
 {
     int32_t index = _paramIndex(request, name, spelling);
     if (index >= 0)
     {
-        return sscanf(request->arg(index).c_str(), "%i", &value) == 1;
+        return AlpacaParse::Int32(request->arg(index).c_str(), value);
     }
     return false;
 }
@@ -370,7 +534,7 @@ bool AlpacaServer::GetParam(AsyncWebServerRequest *request, const char *name, ui
     int32_t index = _paramIndex(request, name, spelling);
     if (index >= 0)
     {
-        return sscanf(request->arg(index).c_str(), "%u", &value) == 1;
+        return AlpacaParse::UInt32(request->arg(index).c_str(), value);
     }
     return false;
 }
@@ -379,7 +543,7 @@ bool AlpacaServer::GetParam(AsyncWebServerRequest *request, const char *name, ui
 bool AlpacaServer::GetParam(AsyncWebServerRequest *request, const char *name, char *buffer, int buffer_size, Spelling_t spelling)
 {
     int32_t index = _paramIndex(request, name, spelling);
-    if (index >= 0)
+    if (index >= 0 && buffer_size > 0)
     {
         request->arg(index).toCharArray(buffer, buffer_size);
         buffer[buffer_size - 1] = '\0';
@@ -422,65 +586,132 @@ void AlpacaServer::Respond(AsyncWebServerRequest *request, AlpacaClient_t &clien
     _respond(request, client, rsp_status, str_value, jason_string_value);
 }
 
+// copy <in> to <out> as JSON string content; quotes, backslashes and control characters are escaped.
+// Error messages quote the request url and parameters, so they must not break the response JSON.
+static const char *_jsonEscape(const char *in, char *out, size_t out_size)
+{
+    size_t o = 0;
+    for (; in != nullptr && *in != '\0' && o + 7 < out_size; in++)
+    {
+        uint8_t c = (uint8_t)*in;
+        if (c == '"' || c == '\\')
+        {
+            out[o++] = '\\';
+            out[o++] = (char)c;
+        }
+        else if (c < 0x20)
+        {
+            o += snprintf(&out[o], out_size - o, "\\u%04x", c);
+        }
+        else
+        {
+            out[o++] = (char)c;
+        }
+    }
+    out[o] = '\0';
+    return out;
+}
+
 // prepare and send json response to alpaca client.
 // as_json_str==true will aditional quote the value
 void AlpacaServer::_respond(AsyncWebServerRequest *request, AlpacaClient_t &client, AlpacaRspStatus_t &rsp_status, const char *value, JsonValue_t jason_string_value)
 {
     char response[2058 + 256];
+    char error_msg[sizeof(rsp_status.error_msg) * 2];
+    RspStatusReleaseDriver(rsp_status);
+    _jsonEscape(rsp_status.error_msg, error_msg, sizeof(error_msg));
 
     _server_transaction_id++;
     if (jason_string_value == JsonValue_t::kNoValue)
     {
         // "{\n\t\"ClientTransactionID\": %i,\n\t\"ServerTransactionID\": %i,\n\t\"ErrorNumber\": %i,\n\t\"ErrorMessage\": \"%s\"\n}"
         snprintf(response, sizeof(response), "{ \"ClientTransactionID\": %i, \"ServerTransactionID\": %i, \"ErrorNumber\": %i, \"ErrorMessage\": \"%s\"}",
-                 client.client_transaction_id, _server_transaction_id, rsp_status.error_code, rsp_status.error_msg);
+                 client.client_transaction_id, _server_transaction_id, rsp_status.error_code, error_msg);
     }
     else if (jason_string_value == JsonValue_t::kAsJsonStringValue)
     {
         // "{\n\t\"Value\": \"%s\",\n\t\"ClientTransactionID\": %i,\n\t\"ServerTransactionID\": %i,\n\t\"ErrorNumber\": %i,\n\t\"ErrorMessage\": \"%s\"\n}"
+        char str_value[512];
         snprintf(response, sizeof(response), "{ \"Value\": \"%s\", \"ClientTransactionID\": %i, \"ServerTransactionID\": %i, \"ErrorNumber\": %i, \"ErrorMessage\": \"%s\"}",
-                 value, client.client_transaction_id, _server_transaction_id, rsp_status.error_code, rsp_status.error_msg);
+                 _jsonEscape(value, str_value, sizeof(str_value)), client.client_transaction_id, _server_transaction_id, rsp_status.error_code, error_msg);
     }
     else
     {
         // "{\n\t\"Value\": %s,\n\t\"ClientTransactionID\": %i,\n\t\"ServerTransactionID\": %i,\n\t\"ErrorNumber\": %i,\n\t\"ErrorMessage\": \"%s\"\n}"
         snprintf(response, sizeof(response), "{ \"Value\": %s, \"ClientTransactionID\": %i, \"ServerTransactionID\": %i, \"ErrorNumber\": %i, \"ErrorMessage\": \"%s\"}",
-                 value, client.client_transaction_id, _server_transaction_id, rsp_status.error_code, rsp_status.error_msg);
+                 value, client.client_transaction_id, _server_transaction_id, rsp_status.error_code, error_msg);
     }
     request->send((int32_t)rsp_status.http_status, kAlpacaJsonType, response);
     DBG_RESPOND_VALUE;
 }
 
+// alpaca response with a Value of unknown length; sent as chunked transfer while value_filler produces it
+void AlpacaServer::RespondChunked(AsyncWebServerRequest *request, AlpacaClient_t &client, AlpacaRspStatus_t &rsp_status, AlpacaValueFiller_t value_filler)
+{
+    struct Stream_t
+    {
+        String text[2]; // before and after the value
+        AlpacaValueFiller_t value_filler;
+        int phase;      // 0 head, 1 value, 2 tail, 3 done
+        size_t pos;
+    };
+    char tail[160];
+    RspStatusReleaseDriver(rsp_status);
+    _server_transaction_id++;
+    snprintf(tail, sizeof(tail), ", \"ClientTransactionID\": %i, \"ServerTransactionID\": %i, \"ErrorNumber\": %i, \"ErrorMessage\": \"\"}",
+             client.client_transaction_id, _server_transaction_id, rsp_status.error_code);
+    std::shared_ptr<Stream_t> stream = std::make_shared<Stream_t>();
+    stream->text[0] = "{ \"Value\": ";
+    stream->text[1] = tail;
+    stream->value_filler = value_filler;
+    stream->phase = 0;
+    stream->pos = 0;
+
+    AsyncWebServerResponse *response = request->beginChunkedResponse(kAlpacaJsonType, [stream](uint8_t *buffer, size_t max_len, size_t index) -> size_t
+                                                                     {
+        size_t n = 0;
+        while (n < max_len && stream->phase < 3)
+        {
+            if (stream->phase == 1)
+            {
+                size_t len = stream->value_filler((char *)buffer + n, max_len - n);
+                n += len;
+                if (len == 0)
+                    stream->phase = 2;
+                continue;
+            }
+            const String &text = stream->text[stream->phase / 2];
+            size_t len = std::min(max_len - n, text.length() - stream->pos);
+            memcpy(buffer + n, text.c_str() + stream->pos, len);
+            n += len;
+            stream->pos += len;
+            if (stream->pos == text.length())
+            {
+                stream->phase++;
+                stream->pos = 0;
+            }
+        }
+        return n; });
+    request->send(response);
+}
+
 // Handler for replying to ascom alpaca discovery UDP packet
 void AlpacaServer::OnAlpacaDiscovery(AsyncUDPPacket &udpPacket)
 {
     // check for arrived UDP packet at port
-    int length = udpPacket.length();
-    SLOG_PRINTF(SLOG_INFO, "BEGIN length=%d ...\n", length);
-
-    if (length == 0)
-        return;
+    size_t length = udpPacket.length();
+    SLOG_PRINTF(SLOG_INFO, "BEGIN length=%d ...\n", (int)length);
 
     SLOG_PRINTF(SLOG_NOTICE, "... Remote ip %03d.%03d.%03d.%03d ...\n", udpPacket.remoteIP()[0], udpPacket.remoteIP()[1], udpPacket.remoteIP()[2], udpPacket.remoteIP()[3]);
 
-    // check size
-    if (length < 16)
+    // header "alpacadiscovery" (15 chars) and version (1 char) are mandatory
+    uint8_t version = 0;
+    if (!AlpacaParse::Discovery(udpPacket.data(), length, version))
     {
-        SLOG_PRINTF(SLOG_ERROR, "Wrong packet size %d\n", length);
-        return;
-    }
-
-    // check package content
-    AlpacaDiscoveryPacket *alpaca_packet = (AlpacaDiscoveryPacket *)udpPacket.data();
-    if (alpaca_packet->valid())
-    {
-        SLOG_PRINTF(SLOG_INFO, "... Header v.=%c ...\n", alpaca_packet->version());
-    }
-    else
-    {
-        SLOG_ERROR_PRINTF("Alpaca Discovery - Header mismatch\n");
+        SLOG_ERROR_PRINTF("Alpaca Discovery - no discovery packet length=%d\n", (int)length);
         return;
     }
+    SLOG_PRINTF(SLOG_INFO, "... Header v.=0x%02x ...\n", version);
 
     // reply port to ascom tcp server
     uint8_t resp_buf[32];
@@ -491,39 +722,232 @@ void AlpacaServer::OnAlpacaDiscovery(AsyncUDPPacket &udpPacket)
 
 void AlpacaServer::GetPath(AsyncWebServerRequest *request, const char *const path)
 {
+    if (_sendEmbedded(request, path))
+        return;
     SLOG_PRINTF(SLOG_INFO, "REQ url=%s send(LittleFS, %s)\n", request->url().c_str(), path);
     request->send(LittleFS, path);
 }
 
+// send embedded asset for url; 304 if the client has it; false if not embedded
+bool AlpacaServer::_sendEmbedded(AsyncWebServerRequest *request, const char *url)
+{
+#ifdef ALPACA_EMBEDDED_WEB_ASSETS
+    for (size_t i = 0; i < kAlpacaWebAssetsCount; i++)
+    {
+        const AlpacaWebAsset_t &asset = kAlpacaWebAssets[i];
+        if (strcmp(asset.url, url) != 0)
+            continue;
+
+        // immutable only for the url versioned with this content; an old or missing ?v= is revalidated
+        bool versioned = false;
+        if (asset.immutable && request->hasParam("v"))
+        {
+            const String &v = request->getParam("v")->value();
+            size_t etag_len = strlen(asset.etag) - 2; // without quotes
+            versioned = v.length() == etag_len && strncmp(asset.etag + 1, v.c_str(), etag_len) == 0;
+        }
+        const char *cache_control = versioned ? "public, max-age=31536000, immutable" : "no-cache";
+        AsyncWebServerResponse *response;
+        if (request->hasHeader("If-None-Match") && strstr(request->header("If-None-Match").c_str(), asset.etag) != nullptr)
+        {
+            response = request->beginResponse(304, asset.content_type, String());
+        }
+        else
+        {
+            response = request->beginResponse(200, asset.content_type, asset.data, asset.len);
+            response->addHeader("Content-Encoding", "gzip");
+        }
+        response->addHeader("ETag", asset.etag);
+        response->addHeader("Cache-Control", cache_control);
+        request->send(response);
+        SLOG_PRINTF(SLOG_INFO, "REQ url=%s embedded etag=%s\n", request->url().c_str(), asset.etag);
+        return true;
+    }
+#endif
+    return false;
+}
+
 void AlpacaServer::_getJsondata(AsyncWebServerRequest *request)
 {
     SLOG_PRINTF(SLOG_INFO, "BEGIN REQ %s...\n", request->url().c_str());
     DBG_REQ
+    char etag[32];
     JsonDocument doc;
     JsonObject root = doc.to<JsonObject>();
+    LockSettings(); // ETag and values of the same version
+    GetSettingsETag(nullptr, 0, etag, sizeof(etag));
+    if (SendNotModified(request, etag))
+    {
+        UnlockSettings();
+        DBG_END
+        return;
+    }
     _writeJson(root);
+    UnlockSettings();
     String ser_json = "";
     serializeJson(root, ser_json);
-    request->send(200, kAlpacaJsonType, ser_json);
+    SendJson(request, ser_json, etag);
     DBG_JSON_PRINTFJ(SLOG_NOTICE, root, "... END ser_json=<%s>\n", _ser_json_);
     DBG_END
 }
 
-void AlpacaServer::_getLinks(AsyncWebServerRequest *request)
+void AlpacaServer::_getSettingsJson(AsyncWebServerRequest *request)
 {
     SLOG_PRINTF(SLOG_INFO, "BEGIN REQ %s...\n", request->url().c_str());
     DBG_REQ
     JsonDocument doc;
     JsonObject root = doc.to<JsonObject>();
+    LockSettings();
+    _writeSettings(root);
+    UnlockSettings();
+    String ser_json = "";
+    serializeJson(root, ser_json);
+    request->send(200, kAlpacaJsonType, ser_json);
+    DBG_JSON_PRINTFJ(SLOG_NOTICE, root, "... END ser_json=<%s>\n", _ser_json_);
+    DBG_END
+}
+
+// type, bounds and access of the /jsondata keys
+void AlpacaServer::_getSchema(AsyncWebServerRequest *request)
+{
+    SLOG_PRINTF(SLOG_INFO, "BEGIN REQ %s...\n", request->url().c_str());
+    JsonDocument doc;
+    JsonObject root = doc.to<JsonObject>();
+    AlpacaSettings::Schema(kAlpacaServerSettings, root);
+    String ser_json = "";
+    serializeJson(root, ser_json);
+    request->send(200, kAlpacaJsonType, ser_json);
+    SLOG_PRINTF(SLOG_INFO, "... END REQ %s\n", request->url().c_str());
+}
+
+// counters in Prometheus text format
+void AlpacaServer::_getMetrics(AsyncWebServerRequest *request)
+{
+    SLOG_PRINTF(SLOG_INFO, "BEGIN REQ %s...\n", request->url().c_str());
+    String metrics = "";
+    char line[160];
+
+    metrics += "# TYPE alpaca_settings_writes_total counter\n";
+    snprintf(line, sizeof(line), "alpaca_settings_writes_total %u\n", _settings_writes);
+    metrics += line;
+    metrics += "# TYPE alpaca_settings_failed_saves gauge\n";
+    snprintf(line, sizeof(line), "alpaca_settings_failed_saves %u\n", _settings_failures);
+    metrics += line;
+    // duration and peak JSON heap (serialization buffer included) of the latest load and save
+    const char *const settings_ops[] = {"load", "save"};
+    const uint32_t settings_us[] = {_settings_load_us, _settings_save_us};
+    const uint32_t settings_heap[] = {_settings_load_heap, _settings_save_heap};
+    for (int i = 0; i < 2; i++)
+    {
+        snprintf(line, sizeof(line), "# TYPE alpaca_settings_%s_us gauge\nalpaca_settings_%s_us %u\n", settings_ops[i], settings_ops[i], settings_us[i]);
+        metrics += line;
+        snprintf(line, sizeof(line), "# TYPE alpaca_settings_%s_heap_bytes gauge\nalpaca_settings_%s_heap_bytes %u\n", settings_ops[i], settings_ops[i], settings_heap[i]);
+        metrics += line;
+    }
+
+    AlpacaPositionJournalStats_t journal;
+    _position_journal.GetStats(journal);
+    const char *const journal_metrics[][2] = {{"records_total", "counter"}, {"erases_total", "counter"}, {"torn_records", "gauge"}, {"recover_us", "gauge"}};
+    const uint32_t journal_values[] = {journal.records, journal.erases, journal.torn, journal.recover_us};
+    for (int m = 0; _position_journal.IsOpen() && m < 4; m++)
+    {
+        snprintf(line, sizeof(line), "# TYPE alpaca_position_journal_%s %s\nalpaca_position_journal_%s %u\n", journal_metrics[m][0], journal_metrics[m][1], journal_metrics[m][0], journal_values[m]);
+        metrics += line;
+    }
+
+    metrics += "# TYPE alpaca_device_requests_total counter\n";
+    for (int i = 0; i < _n_devices; i++)
+    {
+        snprintf(line, sizeof(line), "alpaca_device_requests_total{device=\"%s/%d\"} %u\n",
+                 _device[i]->GetDeviceType(), _device[i]->GetDeviceNumber(), _device[i]->GetServiceCounter());
+        metrics += line;
+    }
+
+    const char *const cache_metrics[] = {"hits_total", "misses_total", "ttl_ms"};
+    for (int m = 0; m < 3; m++)
+    {
+        snprintf(line, sizeof(line), "# TYPE alpaca_property_cache_%s %s\n", cache_metrics[m], m < 2 ? "counter" : "gauge");
+        metrics += line;
+        for (int i = 0; i < _n_devices; i++)
+        {
+            for (size_t k = 0; k < _device[i]->GetNumberOfCachedValues(); k++)
+            {
+                AlpacaCachedValueBase *cached_value = _device[i]->GetCachedValue(k);
+                uint32_t value = m == 0 ? cached_value->GetHits() : (m == 1 ? cached_value->GetMisses() : cached_value->GetTTL());
+                snprintf(line, sizeof(line), "alpaca_property_cache_%s{device=\"%s/%d\",property=\"%s\"} %u\n", cache_metrics[m],
+                         _device[i]->GetDeviceType(), _device[i]->GetDeviceNumber(), cached_value->GetName(), value);
+                metrics += line;
+            }
+        }
+    }
+
+    // device specific metrics; one family per name over all devices. The buffers are members: the
+    // handler runs on the AsyncTCP task only, and its stack is small
+    for (int i = 0; i < _n_devices; i++)
+        _n_device_metrics[i] = min(_device[i]->AlpacaGetMetrics(_device_metrics[i], kAlpacaMaxDeviceMetrics), kAlpacaMaxDeviceMetrics);
+    for (int i = 0; i < _n_devices; i++)
+    {
+        for (size_t k = 0; k < _n_device_metrics[i]; k++)
+        {
+            const char *name = _device_metrics[i][k].name;
+            bool listed = false;
+            for (int j = 0; j < i && !listed; j++)
+                for (size_t l = 0; l < _n_device_metrics[j] && !listed; l++)
+                    listed = (strcmp(_device_metrics[j][l].name, name) == 0);
+            if (listed)
+                continue;
+            snprintf(line, sizeof(line), "# TYPE alpaca_%s %s\n", name, _device_metrics[i][k].type);
+            metrics += line;
+            for (int j = i; j < _n_devices; j++)
+            {
+                for (size_t l = 0; l < _n_device_metrics[j]; l++)
+                {
+                    if (strcmp(_device_metrics[j][l].name, name) != 0)
+                        continue;
+                    snprintf(line, sizeof(line), "alpaca_%s{device=\"%s/%d\"} %u\n", name,
+                             _device[j]->GetDeviceType(), _device[j]->GetDeviceNumber(), _device_metrics[j][l].value);
+                    metrics += line;
+                }
+            }
+        }
+    }
+    request->send(200, "text/plain; version=0.0.4", metrics);
+}
+
+void AlpacaServer::_writeLinks(JsonObject &root)
+{
     root["Server"] = "/setup";
     for (int i = 0; i < _n_devices; i++)
     {
         root[_device[i]->GetDeviceName()] = _device[i]->GetDeviceURL();
     }
+}
+
+void AlpacaServer::_getLinks(AsyncWebServerRequest *request)
+{
+    SLOG_PRINTF(SLOG_INFO, "BEGIN REQ %s...\n", request->url().c_str());
+    DBG_REQ
+    // links change with the device names only; the sum of the device versions increases with each change
+    uint32_t versions = 0;
+    char etag[32];
+    JsonDocument doc;
+    JsonObject root = doc.to<JsonObject>();
+    LockSettings();
+    for (int i = 0; i < _n_devices; i++)
+        versions += _settings_version[i + 1];
+    snprintf(etag, sizeof(etag), "\"%08x-L%u-%d\"", _settings_epoch, versions, _n_devices);
+    if (SendNotModified(request, etag))
+    {
+        UnlockSettings();
+        DBG_END
+        return;
+    }
+    _writeLinks(root);
+    UnlockSettings();
 
     String ser_json = "";
     serializeJson(root, ser_json);
-    request->send(200, kAlpacaJsonType, ser_json);
+    SendJson(request, ser_json, etag);
     DBG_JSON_PRINTFJ(SLOG_INFO, root, "... END ser_json=<%s>\n", _ser_json_);
     DBG_END
 }
@@ -531,102 +955,435 @@ void AlpacaServer::_getLinks(AsyncWebServerRequest *request)
 void AlpacaServer::_getSetupPage(AsyncWebServerRequest *request)
 {
     SLOG_PRINTF(SLOG_INFO, "REQ url=%s\n", request->url().c_str());
+    JsonDocument doc;
+    JsonObject root = doc.to<JsonObject>();
+    JsonDocument schema_doc;
+    JsonObject schema = schema_doc.to<JsonObject>();
+    AlpacaSettings::Schema(kAlpacaServerSettings, schema);
+    LockSettings();
+    _writeJson(root);
+    SendSetupPage(request, root, schema);
+    UnlockSettings();
+}
+
+#ifdef ALPACA_EMBEDDED_WEB_ASSETS
+// zlib compatible crc32; continues crc
+static uint32_t _crc32(uint32_t crc, const uint8_t *buf, size_t len)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= buf[i];
+        for (int k = 0; k < 8; k++)
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+    return ~crc;
+}
+#endif
+
+/*
+ * Send the setup page with the /links, jsondata and schema payloads, so the page needs no data request.
+ * kAlpacaSetupBundle is an open gzip stream of the page with its own css and js inlined; the libraries are
+ * versioned references to the embedded assets, which the browser caches as immutable after the first view.
+ * The boot data script and kAlpacaSetupBundleEnd are appended as final stored deflate block(s), followed
+ * by the gzip trailer.
+ */
+void AlpacaServer::SendSetupPage(AsyncWebServerRequest *request, JsonObject &jsondata, JsonObject &schema)
+{
+#ifdef ALPACA_EMBEDDED_WEB_ASSETS
+    JsonDocument doc;
+    JsonObject boot = doc.to<JsonObject>();
+    JsonObject links = boot["links"].to<JsonObject>();
+    _writeLinks(links);
+    boot["jsondata"] = jsondata;
+    boot["schema"] = schema;
+    String boot_json = "";
+    serializeJson(boot, boot_json);
+
+    // uncompressed end of the page; "</" escaped inside the script
+    std::vector<uint8_t> tail;
+    const char script_begin[] = "<script>window.alpacaBoot=";
+    const char script_end[] = ";</script>";
+    tail.insert(tail.end(), script_begin, script_begin + sizeof(script_begin) - 1);
+    for (size_t i = 0; i < boot_json.length(); i++)
+    {
+        if (boot_json[i] == '/' && i > 0 && boot_json[i - 1] == '<')
+            tail.push_back('\\');
+        tail.push_back(boot_json[i]);
+    }
+    tail.insert(tail.end(), script_end, script_end + sizeof(script_end) - 1);
+    tail.insert(tail.end(), kAlpacaSetupBundleEnd, kAlpacaSetupBundleEnd + sizeof(kAlpacaSetupBundleEnd) - 1);
+
+    // stored blocks, last one final, and gzip trailer
+    std::shared_ptr<std::vector<uint8_t>> suffix = std::make_shared<std::vector<uint8_t>>();
+    suffix->reserve(tail.size() + 5 * (tail.size() / 0xFFFF + 1) + 8);
+    size_t pos = 0;
+    do
+    {
+        uint16_t len = (uint16_t)std::min((size_t)0xFFFF, tail.size() - pos);
+        uint8_t hdr[5] = {(uint8_t)(pos + len == tail.size() ? 0x01 : 0x00), (uint8_t)len, (uint8_t)(len >> 8), (uint8_t)~len, (uint8_t)(~len >> 8)};
+        suffix->insert(suffix->end(), hdr, hdr + sizeof(hdr));
+        suffix->insert(suffix->end(), tail.begin() + pos, tail.begin() + pos + len);
+        pos += len;
+    } while (pos < tail.size());
+    uint32_t crc = _crc32(kAlpacaSetupBundleCrc, tail.data(), tail.size());
+    uint32_t size = kAlpacaSetupBundleSize + tail.size();
+    uint8_t trailer[8] = {(uint8_t)crc, (uint8_t)(crc >> 8), (uint8_t)(crc >> 16), (uint8_t)(crc >> 24),
+                          (uint8_t)size, (uint8_t)(size >> 8), (uint8_t)(size >> 16), (uint8_t)(size >> 24)};
+    suffix->insert(suffix->end(), trailer, trailer + sizeof(trailer));
+
+    size_t total = sizeof(kAlpacaSetupBundle) + suffix->size();
+    AsyncWebServerResponse *response = request->beginResponse("text/html", total, [suffix](uint8_t *buffer, size_t max_len, size_t index) -> size_t
+                                                              {
+        size_t n = 0;
+        while (n < max_len)
+        {
+            size_t i = index + n;
+            if (i < sizeof(kAlpacaSetupBundle))
+            {
+                size_t len = std::min(max_len - n, sizeof(kAlpacaSetupBundle) - i);
+                memcpy(buffer + n, kAlpacaSetupBundle + i, len);
+                n += len;
+            }
+            else if (i - sizeof(kAlpacaSetupBundle) < suffix->size())
+            {
+                size_t len = std::min(max_len - n, suffix->size() - (i - sizeof(kAlpacaSetupBundle)));
+                memcpy(buffer + n, suffix->data() + (i - sizeof(kAlpacaSetupBundle)), len);
+                n += len;
+            }
+            else
+                break;
+        }
+        return n; });
+    response->addHeader("Content-Encoding", "gzip");
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+    SLOG_PRINTF(SLOG_INFO, "REQ url=%s bundle %d bytes\n", request->url().c_str(), total);
+#else
     GetPath(request, kAlpacaSetupPagePath);
+#endif
 }
 
-void AlpacaServer::_readJson(JsonObject &root)
+void AlpacaServer::_readJson(JsonObject &root, JsonObject errors)
 {
     DBG_JSON_PRINTFJ(SLOG_INFO, root, "BEGIN (root=<%s>) ...\n", _ser_json_);
 
-    _mng_server_name = root["Name"] | _mng_server_name;
-    _port_tcp = root["TCP_port"] | _port_tcp;
-    _port_udp = root["UDP_port"] | _port_udp;
-    _syslog_host = root["SYSLOG_host"] | _syslog_host;
-    _log_level = root["LOG_level"] | SLOG_DEBUG;
-    //_serial_log = (root["SERIAL_log"] | 1) == 0 ? false : true;   // this changes from 0~1 numerical value to a switch on setup web page
-    _serial_log = (root["SERIAL_log"] == "true") ? false : true;
+    AlpacaServerSettings_t old_settings = _settings;
+    AlpacaSettings::Read(kAlpacaServerSettings, root, &_settings, errors);
+    _applySettings(old_settings);
+
+    SLOG_PRINTF(SLOG_INFO, "... END name=%s port_tcp=%d port_udp=%d syslog_host=%s log_level=%d serial_log=%s\n",
+                _settings.name, _settings.port_tcp, _settings.port_udp, _settings.syslog_host, _settings.log_level, _settings.serial_log == true ? "true" : "false");
+}
+
+// reconfigure only what differs from old_settings; port changes are applied by Loop()
+void AlpacaServer::_applySettings(const AlpacaServerSettings_t &old_settings)
+{
+    bool all = !_settings_applied;
+    _settings_applied = true;
 
-    // activated SLog settings
-    g_Slog.Begin(_syslog_host.c_str());
-    g_Slog.SetLvlMsk(_log_level);
-    g_Slog.SetEnableSerial(_serial_log);
+    if (all || strcmp(old_settings.syslog_host, _settings.syslog_host) != 0)
+        g_Slog.Begin(_settings.syslog_host);
+    if (all || old_settings.log_level != _settings.log_level)
+        g_Slog.SetLvlMsk(_settings.log_level);
+    if (all || old_settings.serial_log != _settings.serial_log)
+        g_Slog.SetEnableSerial(_settings.serial_log);
 
-    SLOG_PRINTF(SLOG_INFO, "... END _mng_server_name=%s _port_tcp=%d _port_udp=%d _syslog_host=%s _log_level=%d _serial_log=%s\n",
-                _mng_server_name.c_str(), _port_tcp, _port_udp, _syslog_host.c_str(), _log_level, _serial_log == true ? "true" : "false");
+    if (old_settings.port_udp != _settings.port_udp)
+    {
+        _rebind_request_ms = millis();
+        _rebind_udp = true;
+    }
+    if (old_settings.port_tcp != _settings.port_tcp)
+        SLOG_PRINTF(SLOG_NOTICE, "TCP port %d is used from the next start\n", _settings.port_tcp);
 }
 
 void AlpacaServer::_writeJson(JsonObject &root)
 {
     SLOG_PRINTF(SLOG_INFO, "SERVER WRITE BEGIN ...\n");
-    // read-only values marked with #
-    root["Name"] = _mng_server_name;
-    root["UID"] = _uid;
-    root["TCP_port"] = _port_tcp;
-    root["UDP_port"] = _port_udp;
-    root["SYSLOG_host"] = _syslog_host;
-    root["LOG_level"] = _log_level;
-    // root["SERIAL_log"] = _serial_log ? 1 : 0;   // this changes from 0~1 numerical value to a switch on setup web page
-    root["SERIAL_log"] = (_serial_log == true);
-
+    AlpacaSettings::Write(kAlpacaServerSettings, &_settings, root);
     DBG_JSON_PRINTFJ(SLOG_NOTICE, root, "...SERVER WRITE END root=<%s>\n", _ser_json_);
 }
 
-bool AlpacaServer::SaveSettings()
+int AlpacaServer::_deviceIndex(AlpacaDevice *device)
 {
-    SLOG_PRINTF(SLOG_INFO, "SERVER READ BEGIN ...\n")
-    JsonDocument doc;
-    JsonObject root = doc.to<JsonObject>();
-    DBG_JSON_PRINTFJ(SLOG_INFO, doc, "... doc=<%s> ...\n", _ser_json_);
-    _writeJson(root);
     for (int i = 0; i < _n_devices; i++)
     {
-        JsonObject json_obj = root[_device[i]->GetDeviceUID()].to<JsonObject>();
-        _device[i]->AlpacaWriteJson(json_obj);
+        if (_device[i] == device)
+            return i;
     }
-    DBG_JSON_PRINTFJ(SLOG_NOTICE, root, "... root=<%s> ...\n", _ser_json_);
+    return -1;
+}
 
-    LittleFS.remove(kAlpacaSettingsPath);
-    File file = LittleFS.open(kAlpacaSettingsPath, FILE_WRITE);
-    if (!file)
+void AlpacaServer::MarkSettingsDirty(AlpacaDevice *device)
+{
+    int i = _deviceIndex(device);
+    if (i >= 0)
+        _markSettingsDirty(0x01 << (i + 1));
+}
+
+// changed: sections in mask were modified; false only to retry a failed save
+void AlpacaServer::_markSettingsDirty(uint32_t mask, bool changed)
+{
+    uint32_t now = millis();
+    portENTER_CRITICAL(&_settings_mux);
+    if (_settings_dirty == 0)
+        _settings_first_dirty_ms = now;
+    _settings_dirty |= mask;
+    _settings_dirty_ms = now;
+    for (int i = 0; changed && i <= _n_devices; i++)
     {
-        SLOG_PRINTF(SLOG_WARNING, "...SERVER READ END LittleFS could not create %s\n", kAlpacaSettingsPath);
-        return false;
+        if (mask & (0x01 << i))
+            _settings_version[i]++;
     }
-    if (serializeJson(doc, file) == 0)
+    portEXIT_CRITICAL(&_settings_mux);
+}
+
+/**
+ * ETag of the jsondata of the server (device == nullptr) or of device: boot epoch, section version
+ * and revision of values that are no settings (see AlpacaDevice::AlpacaJsonRevision()); false for a device
+ * that was not added to the server
+ */
+bool AlpacaServer::GetSettingsETag(AlpacaDevice *device, uint32_t revision, char *etag, size_t len)
+{
+    int section = 0;
+    if (device != nullptr)
     {
-        SLOG_PRINTF(SLOG_WARNING, "...SERVER READ END ArduinoJson failed to write %s\n", kAlpacaSettingsPath);
-        file.close();
+        section = _deviceIndex(device) + 1;
+        if (section == 0)
+            return false;
+    }
+    snprintf(etag, len, "\"%08x-%d-%u-%u\"", _settings_epoch, section, _settings_version[section], revision);
+    return true;
+}
+
+// 304 without body if the client has etag
+bool AlpacaServer::SendNotModified(AsyncWebServerRequest *request, const char *etag)
+{
+    if (!request->hasHeader("If-None-Match") || strstr(request->header("If-None-Match").c_str(), etag) == nullptr)
         return false;
+    AsyncWebServerResponse *response = request->beginResponse(304, kAlpacaJsonType, String());
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response);
+    SLOG_PRINTF(SLOG_INFO, "REQ url=%s not modified etag=%s\n", request->url().c_str(), etag);
+    return true;
+}
+
+void AlpacaServer::SendJson(AsyncWebServerRequest *request, const String &ser_json, const char *etag)
+{
+    AsyncWebServerResponse *response = request->beginResponse(200, kAlpacaJsonType, ser_json);
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response);
+}
+
+/**
+ * Poll the state of all devices every kAlpacaEventsPeriodMs while there are event subscribers or
+ * change journal clients. Every changed key is added to the journal, and one event is sent with the
+ * changes of all devices: "delta" {"<device_type>/<device_number>":{<key>:<value>, ...}, ...}, or
+ * "state" with all keys after a new subscriber or a lost event. The driver getters are called with
+ * the driver lock of the device; a device busy with a request is polled in the next period. A
+ * subscriber that lags behind is skipped and gets the full state once its queue has drained.
+ */
+void AlpacaServer::_pollState()
+{
+    uint32_t now = millis();
+    bool events = _events != nullptr && _events->count() > 0;
+    if (_journal_polling && (now - _journal_request_ms) > kAlpacaJournalIdleMs)
+    {
+        portENTER_CRITICAL(&_journal_mux);
+        _journal_polling = false;
+        portEXIT_CRITICAL(&_journal_mux);
+    }
+    if ((!events && !_journal_polling) || (now - _state_ms) < kAlpacaEventsPeriodMs)
+        return;
+    _state_ms = now;
+
+    JsonDocument doc;
+    JsonObject changes = doc.to<JsonObject>();
+    for (int i = 0; i < _n_devices; i++)
+    {
+        if (!_device[i]->TryLockDriver())
+            continue;
+        JsonDocument state_doc;
+        JsonObject state = state_doc.to<JsonObject>();
+        _device[i]->AlpacaWriteState(state);
+        _device[i]->UnlockDriver();
+
+        char key[40];
+        snprintf(key, sizeof(key), "%s/%d", _device[i]->GetDeviceType(), _device[i]->GetDeviceNumber());
+        JsonObject last = _state[key];
+        if (last.isNull())
+            last = _state[key].to<JsonObject>();
+        for (JsonPair kv : state)
+        {
+            if (last[kv.key()] != kv.value())
+            {
+                last[kv.key()] = kv.value();
+                _journalAdd(i, kv.key().c_str());
+                changes[key][kv.key()] = kv.value();
+            }
+        }
+    }
+    if (!events)
+        return;
+
+    String delta = "";
+    String full = "";
+    uint32_t id = ++_events_id;
+    xSemaphoreTake(_events_mutex, portMAX_DELAY);
+    for (size_t i = 0; i < _n_subscribers; i++)
+    {
+        AlpacaEventsSubscriber_t &subscriber = _subscribers[i];
+        if (!subscriber.resync && changes.size() == 0)
+            continue;
+        if (subscriber.client->packetsWaiting() > kAlpacaEventsMaxQueued)
+        {
+            subscriber.resync = true; // this event is lost for the subscriber
+            continue;
+        }
+        String &ser_json = subscriber.resync ? full : delta;
+        if (ser_json.isEmpty())
+        {
+            if (subscriber.resync)
+                serializeJson(_state, ser_json);
+            else
+                serializeJson(changes, ser_json);
+        }
+        subscriber.resync = !subscriber.client->send(ser_json.c_str(), subscriber.resync ? "state" : "delta", id);
+    }
+    xSemaphoreGive(_events_mutex);
+}
+
+// next change sequence number for key of _device[device_idx]; the oldest entry is overwritten
+void AlpacaServer::_journalAdd(int device_idx, const char *key)
+{
+    portENTER_CRITICAL(&_journal_mux);
+    uint32_t seq = ++_journal_seq;
+    AlpacaJournalEntry_t &entry = _journal[seq % kAlpacaJournalSize];
+    if (entry.seq + 1 > _journal_min_seq)
+        _journal_min_seq = entry.seq + 1;
+    entry.seq = seq;
+    entry.device_idx = (uint8_t)device_idx;
+    strlcpy(entry.key, key, sizeof(entry.key));
+    portEXIT_CRITICAL(&_journal_mux);
+}
+
+/**
+ * State keys of device changed after the change sequence number since:
+ * {"Seq":<token for the next request>, "Resync":false, "State":{<key>:<value>, ...}}
+ * With "Resync":true "State" has all keys: since is 0, fell out of the journal, the journal was idle
+ * or there was no memory for the keys.
+ */
+void AlpacaServer::GetChanges(AlpacaDevice *device, uint32_t since, JsonObject &root)
+{
+    typedef char key_t[sizeof(AlpacaJournalEntry_t::key)];
+    int device_idx = _deviceIndex(device);
+    std::unique_ptr<key_t[]> keys(new (std::nothrow) key_t[kAlpacaJournalSize]); // not on the stack of the AsyncTCP task
+    size_t n_keys = 0;
+    bool resync = false;
+    uint32_t seq;
+
+    portENTER_CRITICAL(&_journal_mux);
+    _journal_request_ms = millis();
+    if (!_journal_polling)
+    {
+        // changes were not recorded; invalidate all tokens handed out before
+        _journal_polling = true;
+        _journal_seq++;
+        _journal_min_seq = _journal_seq + 1;
+    }
+    seq = _journal_seq;
+    resync = (since == 0 || since > seq || since + 1 < _journal_min_seq || !keys);
+    for (uint32_t s = since + 1; !resync && s <= seq; s++)
+    {
+        const AlpacaJournalEntry_t &entry = _journal[s % kAlpacaJournalSize];
+        if (entry.seq == s && entry.device_idx == device_idx)
+            strlcpy(keys[n_keys++], entry.key, sizeof(keys[0]));
+    }
+    portEXIT_CRITICAL(&_journal_mux);
+
+    JsonDocument state_doc;
+    JsonObject state = state_doc.to<JsonObject>();
+    device->AlpacaWriteState(state);
+    root["Seq"] = seq;
+    root["Resync"] = resync;
+    JsonObject changes = root["State"].to<JsonObject>();
+    if (resync)
+    {
+        changes.set(state);
     }
     else
     {
-        SLOG_PRINTF(SLOG_INFO, "...SERVER READ END ArduinoJson wrote to %s succesfully\n", kAlpacaSettingsPath);
+        for (size_t i = 0; i < n_keys; i++)
+            changes[keys[i]] = state[keys[i]];
     }
-    file.close();
-    return true;
 }
 
-bool AlpacaServer::LoadSettings()
+// write-behind: save settings when changes have settled or a reset is pending; a failed save is retried
+// with backoff, and a pending reset gives up after kAlpacaSettingsResetAttempts failed saves
+void AlpacaServer::_flushSettings()
 {
-    SLOG_PRINTF(SLOG_INFO, "BEGIN ...\n");
-    JsonDocument doc;
+    if (_settings_dirty == 0)
+        return;
+
+    uint32_t now = millis();
+    if (!_reset_request && (now - _settings_dirty_ms) < kAlpacaSettingsWriteDelayMs && (now - _settings_first_dirty_ms) < kAlpacaSettingsMaxWriteDelayMs)
+        return;
+    if (_settings_failures > 0)
+    {
+        uint32_t retry_ms = kAlpacaSettingsRetryMs << min(_settings_failures - 1, (uint32_t)6);
+        if ((now - _settings_failed_ms) < min(retry_ms, kAlpacaSettingsMaxRetryMs))
+            return;
+    }
+
+    if (SaveSettings() || !_reset_request || _settings_failures < kAlpacaSettingsResetAttempts)
+        return;
+    SLOG_ERROR_PRINTF("settings not saved after %d attempts; dropped for the reset\n", _settings_failures);
+    portENTER_CRITICAL(&_settings_mux);
+    _settings_dirty = 0;
+    portEXIT_CRITICAL(&_settings_mux);
+}
 
-    File file = LittleFS.open(kAlpacaSettingsPath, FILE_READ);
+// deserialize the part of the settings file selected by filter into doc
+static bool _loadSettingsPart(const char *path, bool msgpack, JsonDocument &filter, JsonDocument &doc)
+{
+    DeserializationError error;
+    File file = LittleFS.open(path, FILE_READ);
     if (!file)
     {
-        SLOG_WARNING_PRINTF("LittleFS: %s could not open\n", kAlpacaSettingsPath);
+        SLOG_WARNING_PRINTF("LittleFS: %s could not open\n", path);
         return false;
     }
-    DeserializationError error = deserializeJson(doc, file);
-    JsonObject root = doc.as<JsonObject>();
+    if (msgpack)
+        error = deserializeMsgPack(doc, file, DeserializationOption::Filter(filter), DeserializationOption::NestingLimit(kAlpacaJsonNestingLimit));
+    else
+        error = deserializeJson(doc, file, DeserializationOption::Filter(filter), DeserializationOption::NestingLimit(kAlpacaJsonNestingLimit));
     file.close();
     if (error)
     {
-        DBG_JSON_PRINTFJ(SLOG_WARNING, root, "failed to parse settings.json\n");
+        SLOG_WARNING_PRINTF("failed to parse %s\n", path);
         return false;
     }
+    return true;
+}
 
-    SLOG_PRINTF(SLOG_INFO, "... LittleFS: %s loaded ...\n", kAlpacaSettingsPath);
+// FNV-1a
+static uint32_t _settingsHash(const uint8_t *buf, size_t len)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= buf[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// settings of server and all devices
+void AlpacaServer::_readSettings(JsonObject &root)
+{
     _readJson(root);
 
     for (int i = 0; i < _n_devices; i++)
@@ -635,10 +1392,223 @@ bool AlpacaServer::LoadSettings()
         DBG_JSON_PRINTFJ(SLOG_INFO, json_obj, "... root[_device[%d]->getDeviceUID()]=<%s> ...\n", i, _ser_json_);
 
         if (json_obj)
+        {
+            _device[i]->AlpacaReadJson(json_obj);
+            _device[i]->AlpacaRestoreJson(json_obj);
+        }
+    }
+}
+
+// sections: mask of the sections written into root; a device section missing in root is always written
+void AlpacaServer::_writeSettings(JsonObject &root, uint32_t sections)
+{
+    root["SettingsVersion"] = kAlpacaSettingsVersion;
+    if (sections & 0x01)
+        _writeJson(root);
+    for (int i = 0; i < _n_devices; i++)
+    {
+        if ((sections & (0x01 << (i + 1))) == 0 && root[_device[i]->GetDeviceUID()].is<JsonObject>())
+            continue;
+        JsonObject json_obj = root[_device[i]->GetDeviceUID()].to<JsonObject>();
+        _device[i]->AlpacaWriteJson(json_obj);
+    }
+}
+
+/*
+ * Save settings to kAlpacaSettingsPath
+ * The file is written to kAlpacaSettingsTmpPath and renamed, so a power loss leaves either the old or the new file.
+ * Nothing is written if the content did not change since the last write.
+ */
+bool AlpacaServer::SaveSettings()
+{
+    SLOG_PRINTF(SLOG_INFO, "SERVER SAVE BEGIN ...\n");
+    bool result = false;
+    uint32_t dirty = 0;
+    bool merged = false;
+    size_t len = 0;
+    uint32_t hash = 0;
+    uint8_t *buf = nullptr;
+    uint32_t start_us = 0;
+    File file;
+    JsonDocument filter(&_settings_allocator);
+    JsonDocument doc(&_settings_allocator);
+    JsonObject root;
+
+    LockSettings();
+    start_us = micros();
+    _settings_allocator.ResetPeak();
+
+    portENTER_CRITICAL(&_settings_mux);
+    dirty = _settings_dirty;
+    _settings_dirty = 0;
+    portEXIT_CRITICAL(&_settings_mux);
+
+    // clean sections are kept from the file, if it was written by this boot
+    filter.set(true);
+    if (_settings_hash != 0 && LittleFS.exists(kAlpacaSettingsPath) && _loadSettingsPart(kAlpacaSettingsPath, true, filter, doc) && doc.is<JsonObject>())
+        merged = true;
+    root = merged ? doc.as<JsonObject>() : doc.to<JsonObject>();
+    _writeSettings(root, merged ? dirty : 0xFFFFFFFF);
+    DBG_JSON_PRINTFJ(SLOG_NOTICE, root, "... merged=%d root=<%s> ...\n", merged, _ser_json_);
+
+    len = measureMsgPack(doc);
+    buf = (uint8_t *)malloc(len);
+    if (buf != nullptr)
+        _settings_allocator.Hold(len);
+    if (buf == nullptr || serializeMsgPack(doc, buf, len) != len)
+    {
+        SLOG_WARNING_PRINTF("ArduinoJson failed to serialize settings (%d bytes)\n", len);
+        goto mycatch;
+    }
+
+    hash = _settingsHash(buf, len);
+    if (hash == _settings_hash && LittleFS.exists(kAlpacaSettingsPath))
+    {
+        SLOG_PRINTF(SLOG_INFO, "... dirty=0x%02x %s unchanged ...\n", dirty, kAlpacaSettingsPath);
+        result = true;
+        goto mycatch;
+    }
+
+    file = LittleFS.open(kAlpacaSettingsTmpPath, FILE_WRITE);
+    if (!file)
+    {
+        SLOG_WARNING_PRINTF("LittleFS could not create %s\n", kAlpacaSettingsTmpPath);
+        goto mycatch;
+    }
+    if (file.write(buf, len) != len)
+    {
+        SLOG_WARNING_PRINTF("LittleFS failed to write %s\n", kAlpacaSettingsTmpPath);
+        file.close();
+        LittleFS.remove(kAlpacaSettingsTmpPath);
+        goto mycatch;
+    }
+    file.close();
+
+    if (!LittleFS.rename(kAlpacaSettingsTmpPath, kAlpacaSettingsPath))
+    {
+        SLOG_WARNING_PRINTF("LittleFS failed to rename %s to %s\n", kAlpacaSettingsTmpPath, kAlpacaSettingsPath);
+        LittleFS.remove(kAlpacaSettingsTmpPath);
+        goto mycatch;
+    }
+
+    _settings_hash = hash;
+    _settings_writes++;
+    result = true;
+    SLOG_PRINTF(SLOG_INFO, "... dirty=0x%02x merged=%d wrote %d bytes to %s (writes=%d) ...\n", dirty, merged, len, kAlpacaSettingsPath, _settings_writes);
+
+mycatch:
+    if (!result)
+    {
+        _markSettingsDirty(dirty, false); // retry later
+        _settings_failures++;
+        _settings_failed_ms = millis();
+    }
+    else
+        _settings_failures = 0;
+
+    if (buf != nullptr)
+        _settings_allocator.Release(len);
+    free(buf);
+    doc.clear(); // the allocator is only used under the settings lock
+    filter.clear();
+    _settings_save_us = micros() - start_us;
+    _settings_save_heap = _settings_allocator.GetPeak();
+    UnlockSettings();
+    SLOG_PRINTF(SLOG_INFO, "... SERVER SAVE END result=%s\n", result ? "true" : "false");
+    return result;
+}
+
+/*
+ * Load settings from kAlpacaSettingsPath (MessagePack)
+ * If only kAlpacaSettingsJsonPath exists, it is loaded and migrated to kAlpacaSettingsPath.
+ * The server section and every device section are loaded in separate passes through the file, each with
+ * a filter, so only one section is held in RAM at a time.
+ */
+bool AlpacaServer::LoadSettings()
+{
+    SLOG_PRINTF(SLOG_INFO, "BEGIN ...\n");
+    const char *path = kAlpacaSettingsPath;
+    bool migrate = false;
+
+    LockSettings();
+    uint32_t start_us = micros();
+    _settings_allocator.ResetPeak();
+
+    // left over from an interrupted save; kAlpacaSettingsPath still holds the previous settings
+    if (LittleFS.exists(kAlpacaSettingsTmpPath))
+    {
+        SLOG_WARNING_PRINTF("LittleFS: remove incomplete %s\n", kAlpacaSettingsTmpPath);
+        LittleFS.remove(kAlpacaSettingsTmpPath);
+    }
+
+    if (!LittleFS.exists(kAlpacaSettingsPath))
+    {
+        if (!LittleFS.exists(kAlpacaSettingsJsonPath))
+        {
+            SLOG_WARNING_PRINTF("LittleFS: %s not found\n", kAlpacaSettingsPath);
+            UnlockSettings();
+            return false;
+        }
+        path = kAlpacaSettingsJsonPath;
+        migrate = true;
+    }
+
+    // server section
+    {
+        JsonDocument filter(&_settings_allocator);
+        JsonObject filter_obj = filter.to<JsonObject>();
+        filter_obj["SettingsVersion"] = true;
+        AlpacaSettings::Filter(kAlpacaServerSettings, filter_obj);
+        JsonDocument doc(&_settings_allocator);
+        if (!_loadSettingsPart(path, !migrate, filter, doc))
+        {
+            UnlockSettings();
+            return false;
+        }
+
+        JsonObject root = doc.as<JsonObject>();
+        uint16_t version = root["SettingsVersion"] | 0; // 0: settings.json without version
+        if (version > kAlpacaSettingsVersion)
+            SLOG_WARNING_PRINTF("settings version %d newer than %d; only known keys are loaded\n", version, kAlpacaSettingsVersion);
+        SLOG_PRINTF(SLOG_INFO, "... LittleFS: %s version=%d ...\n", path, version);
+        _readJson(root);
+    }
+
+    // device sections
+    for (int i = 0; i < _n_devices; i++)
+    {
+        JsonDocument filter(&_settings_allocator);
+        JsonObject filter_obj = filter[_device[i]->GetDeviceUID()].to<JsonObject>();
+        _device[i]->AlpacaSettingsFilter(filter_obj);
+        if (filter_obj.size() == 0)
+            filter[_device[i]->GetDeviceUID()] = true; // no schema declared: whole section
+        JsonDocument doc(&_settings_allocator);
+        if (!_loadSettingsPart(path, !migrate, filter, doc))
+            continue;
+
+        JsonObject json_obj = doc[_device[i]->GetDeviceUID()];
+        DBG_JSON_PRINTFJ(SLOG_INFO, json_obj, "... root[_device[%d]->getDeviceUID()]=<%s> ...\n", i, _ser_json_);
+        if (json_obj)
+        {
             _device[i]->AlpacaReadJson(json_obj);
+            _device[i]->AlpacaRestoreJson(json_obj);
+        }
+    }
+    _settings_load_us = micros() - start_us;
+    _settings_load_heap = _settings_allocator.GetPeak();
+    SLOG_PRINTF(SLOG_INFO, "... loaded in %u us, peak JSON heap %u bytes ...\n", _settings_load_us, _settings_load_heap);
+
+    if (migrate)
+    {
+        if (SaveSettings())
+        {
+            LittleFS.remove(kAlpacaSettingsJsonPath);
+            SLOG_INFO_PRINTF("... %s migrated to %s ...\n", kAlpacaSettingsJsonPath, kAlpacaSettingsPath);
+        }
     }
+    UnlockSettings();
 
-    DBG_JSON_PRINTFJ(SLOG_NOTICE, root, "... END root=<%s>\n", _ser_json_);
+    SLOG_PRINTF(SLOG_INFO, "... END\n");
     return true;
 }
 
@@ -14,20 +14,43 @@
 #include <esp_system.h>
 #include <AsyncUDP.h>
 #include <ESPAsyncWebServer.h>
-#include <AsyncJson.h>
 #include <ArduinoJson.h>
 #include "AlpacaDebug.h"
 #include "AlpacaConfig.h"
+#include "AlpacaSettings.h"
+#include "AlpacaServerSettings.h"
+#include "AlpacaJsonAllocator.h"
+#include "AlpacaParse.h"
+#include "AlpacaPositionJournal.h"
 
 const char kAlpacaDeviceCommand[] = "/api/v1/%s/%d/%s"; // <device_type>, <device_number>, <command>
 const char kAlpacaDeviceSetup[] = "/setup/v1/%s/%d/%s"; // device_type, device_number, command
 
-const char kAlpacaSettingsPath[] = "/settings.json";     // Path to server and device settings
+const char kAlpacaSettingsPath[] = "/settings.msgpack";  // Path to server and device settings (MessagePack)
+const char kAlpacaSettingsTmpPath[] = "/settings.tmp";   // settings are written here and renamed to kAlpacaSettingsPath
+const char kAlpacaSettingsJsonPath[] = "/settings.json"; // JSON import/export url; settings file before version 1, migrated at boot
+const uint16_t kAlpacaSettingsVersion = 1;              // version of the settings file layout
 const char kAlpacaSetupPagePath[] = "/www/setup.html";  // Path to server and device setup page
 
 const char kAlpacaJsonType[] = "application/json";
-const uint32_t kAlpacaDiscoveryLength = 64;
-const char kAlpacaDiscoveryHeader[] = "alpacadiscovery";
+const size_t kAlpacaMaxJsonContentLength = 4096;  // max body of setup POST requests
+const size_t kAlpacaMaxSettingsContentLength = 16384; // max body of settings import
+const uint32_t kAlpacaRebindDelayMs = 500;            // UDP port change is applied this time after the setup POST
+const uint32_t kAlpacaSettingsRetryMs = 1000;         // first retry of a failed settings save; doubled per failure
+const uint32_t kAlpacaSettingsMaxRetryMs = 64000;     // ... up to this
+const uint32_t kAlpacaSettingsResetAttempts = 3;      // failed saves before a pending reset goes ahead without them
+
+// handler of a JSON request body registered by AlpacaServer::OnJson(); root is null if the body is no object
+typedef std::function<void(AsyncWebServerRequest *request, JsonObject &root)> AlpacaJsonHandler_t;
+// writes the JSON of a streamed Value piece by piece into buffer; returns 0 only when done
+typedef std::function<size_t(char *buffer, size_t max_len)> AlpacaValueFiller_t;
+const char kAlpacaEventsPath[] = "/events";          // server-sent events of device state changes
+const uint32_t kAlpacaEventsPeriodMs = 50;           // device state is polled and changes are sent with this period
+const size_t kAlpacaEventsMaxQueued = 4;             // events are held back from a subscriber with more messages queued
+const size_t kAlpacaEventsMaxSubscribers = 8;        // further subscribers get no events
+const uint32_t kAlpacaJournalSize = 64;              // change journal entries; older tokens get a resync
+const uint32_t kAlpacaJournalIdleMs = 60000;         // journal polling stops this time after the last changes request
+const size_t kAlpacaMaxDeviceMetrics = 12;          // device specific metrics of /metrics per device
 
 // Lambda Handler Function for calling object function
 #define LHF(method) \
@@ -35,6 +58,32 @@ const char kAlpacaDiscoveryHeader[] = "alpacadiscovery";
 
 class AlpacaDevice;
 
+// change journal entry: key of the device state changed with sequence number seq
+struct AlpacaJournalEntry_t
+{
+    uint32_t seq;
+    uint8_t device_idx;
+    char key[24];
+};
+
+// subscriber of the server-sent events; resync: the next event is the full state
+struct AlpacaEventsSubscriber_t
+{
+    AsyncEventSourceClient *client;
+    bool resync;
+};
+
+// static web asset embedded by tools/embed_assets.py
+struct AlpacaWebAsset_t
+{
+    const char *url;
+    const char *content_type;
+    const uint8_t *data; // gzip
+    size_t len;
+    const char *etag;    // quoted content hash
+    bool immutable;      // url versioned by setup.html; cache forever
+};
+
 enum struct HttpStatus_t //
 {
     kPassed = 200,         // request correctly formatted and passed to the device handler
@@ -84,38 +133,86 @@ enum struct AlpacaErrorCode_t : int32_t
     ValueNotSet = (int)0x00000402                        // for reporting that a value has not been set.
 };
 
+// device specific metric of /metrics; exported as alpaca_<name>{device="<type>/<number>"}
+struct AlpacaMetric_t
+{
+    const char *name;
+    const char *type; // "counter" or "gauge"
+    uint32_t value;
+};
+
 struct AlpacaRspStatus_t
 {
     AlpacaErrorCode_t error_code;
     char error_msg[128];
     HttpStatus_t http_status;
+    SemaphoreHandle_t driver_lock = nullptr; // driver lock held by the handler; given back by Respond() before the response is built
 };
 
 class AlpacaServer
 {
 private:
     // Data for alpaca management description request
-    String _mng_server_name = "empty";
     String _mng_manufacture = "TecnoSky";
     String _mng_manufacture_version = "V1.0";
     String _mng_location = "Italy";
 
-    // Logging see SLog
-    String _syslog_host = "0.0.0.0";
-    uint16_t _log_level = SLOG_DEBUG;
-    bool _serial_log = true;            // false/true: disable/enable logging after boot
+    AlpacaServerSettings_t _settings = {"empty", "", kAlpacaTcpPort, kAlpacaUdpPort, "0.0.0.0", SLOG_DEBUG, true};
 
     AsyncWebServer *_server_tcp;
     AsyncUDP _server_udp;
-    uint16_t _port_tcp;
-    uint16_t _port_udp;
+
+    // live UDP port change; a TCP port change is used from the next start
+    uint16_t _port_tcp = kAlpacaTcpPort; // port of _server_tcp
+    uint32_t _rebind_request_ms = 0;
+    volatile bool _rebind_udp = false;
+    bool _settings_applied = false; // SLog configured once
     uint32_t _server_transaction_id = 0;
 
-    char _uid[13] = {0}; // from wifi mac
     AlpacaDevice *_device[kAlpacaMaxDevices];
     int _n_devices = 0;
 
     bool _reset_request = false;
+    AlpacaPositionJournal _position_journal; // device positions over resets
+
+    // settings write-behind; bit 0: server section, bit i+1: section of _device[i]
+    SemaphoreHandle_t _settings_mutex = nullptr; // recursive; held around every read and write of the settings members
+    portMUX_TYPE _settings_mux = portMUX_INITIALIZER_UNLOCKED;
+    uint32_t _settings_dirty = 0;
+    uint32_t _settings_dirty_ms = 0;       // time of the last change
+    uint32_t _settings_first_dirty_ms = 0; // time of the first unsaved change
+    uint32_t _settings_hash = 0;           // hash of the last written settings file
+    uint32_t _settings_writes = 0;         // number of flash writes
+    uint32_t _settings_failures = 0;       // failed saves in a row
+    uint32_t _settings_failed_ms = 0;      // time of the last failed save
+    AlpacaJsonPeakAllocator _settings_allocator; // JSON heap of LoadSettings() and SaveSettings()
+    uint32_t _settings_load_us = 0;        // duration of the latest LoadSettings()
+    uint32_t _settings_load_heap = 0;      // its peak JSON heap [bytes]
+    uint32_t _settings_save_us = 0;
+    uint32_t _settings_save_heap = 0;
+    // device specific metrics of the /metrics request being answered; not on the small AsyncTCP stack
+    AlpacaMetric_t _device_metrics[kAlpacaMaxDevices][kAlpacaMaxDeviceMetrics];
+    size_t _n_device_metrics[kAlpacaMaxDevices] = {0};
+    // versions of the sections, incremented with every change; ETag of /jsondata, /links and device jsondata
+    uint32_t _settings_epoch = 0; // random per boot, so ETags of a previous boot never match
+    uint32_t _settings_version[kAlpacaMaxDevices + 1] = {0};
+
+    // device state polled for events and the change journal
+    JsonDocument _state;                  // state polled last, per device
+    uint32_t _state_ms = 0;
+    // server-sent events at kAlpacaEventsPath; one event per period with the changes of all devices
+    AsyncEventSource *_events = nullptr;  // owned by _server_tcp
+    uint32_t _events_id = 0;
+    SemaphoreHandle_t _events_mutex = nullptr; // _subscribers; connect/disconnect (AsyncTCP task) vs _pollState (Loop task)
+    AlpacaEventsSubscriber_t _subscribers[kAlpacaEventsMaxSubscribers] = {};
+    size_t _n_subscribers = 0;
+    // change journal ring; entry of sequence number seq at seq % kAlpacaJournalSize
+    portMUX_TYPE _journal_mux = portMUX_INITIALIZER_UNLOCKED;
+    AlpacaJournalEntry_t _journal[kAlpacaJournalSize] = {};
+    uint32_t _journal_seq = 0;            // sequence number of the last change
+    uint32_t _journal_min_seq = 1;        // oldest sequence number still in the journal
+    uint32_t _journal_request_ms = 0;
+    bool _journal_polling = false;
 
     AlpacaRspStatus_t _mng_rsp_status;
     AlpacaClient_t _mng_client_id;
@@ -124,11 +221,27 @@ private:
     void _getDescription(AsyncWebServerRequest *request);
     void _getConfiguredDevices(AsyncWebServerRequest *request);
     int32_t _paramIndex(AsyncWebServerRequest *request, const char *name, Spelling_t spelling);
-    void _readJson(JsonObject &root);
+    void _readJson(JsonObject &root, JsonObject errors = JsonObject()); // errors: per-field errors of a PATCH
     void _writeJson(JsonObject &root);
+    void _readSettings(JsonObject &root);
+    void _writeSettings(JsonObject &root, uint32_t sections = 0xFFFFFFFF);
+    void _getSettingsJson(AsyncWebServerRequest *request);
+    void _getSchema(AsyncWebServerRequest *request);
+    bool _sendEmbedded(AsyncWebServerRequest *request, const char *url);
     void _getJsondata(AsyncWebServerRequest *request);
     void _getLinks(AsyncWebServerRequest *request);
+    void _getMetrics(AsyncWebServerRequest *request);
+    void _writeLinks(JsonObject &root);
     void _getSetupPage(AsyncWebServerRequest *request);
+    void _markSettingsDirty(uint32_t mask, bool changed = true);
+    int _deviceIndex(AlpacaDevice *device);
+    void _applySettings(const AlpacaServerSettings_t &old_settings);
+    void _loadPorts();
+    void _beginTCP();
+    void _rebind();
+    void _flushSettings();
+    void _pollState();
+    void _journalAdd(int device_idx, const char *key);
 
     void _respond(AsyncWebServerRequest *request, AlpacaClient_t &client, AlpacaRspStatus_t &rsp_status, const char *str, JsonValue_t jason_string_value);
 
@@ -142,6 +255,7 @@ public:
     void RegisterCallbacks();
     void Loop();
     void AddDevice(AlpacaDevice *device);
+    void OnJson(const char *url, WebRequestMethodComposite method, size_t max_length, AlpacaJsonHandler_t handler);
     bool GetParam(AsyncWebServerRequest *request, const char *name, bool &value, Spelling_t spelling);
     bool GetParam(AsyncWebServerRequest *request, const char *name, float &value, Spelling_t spelling);
     bool GetParam(AsyncWebServerRequest *request, const char *name, double &value, Spelling_t spelling);
@@ -154,23 +268,40 @@ public:
     void Respond(AsyncWebServerRequest *request, AlpacaClient_t &client, AlpacaRspStatus_t &rsp_status, double double_value);
     void Respond(AsyncWebServerRequest *request, AlpacaClient_t &client, AlpacaRspStatus_t &rsp_status, bool bool_value);
     void Respond(AsyncWebServerRequest *request, AlpacaClient_t &client, AlpacaRspStatus_t &rsp_status, const char *str_value, JsonValue_t jason_string_value);
+    void RespondChunked(AsyncWebServerRequest *request, AlpacaClient_t &client, AlpacaRspStatus_t &rsp_status, AlpacaValueFiller_t value_filler);
 
     bool CheckMngClientData(AsyncWebServerRequest *req, Spelling_t spelling);
 
     void GetPath(AsyncWebServerRequest *request, const char *const path);
+    void SendSetupPage(AsyncWebServerRequest *request, JsonObject &jsondata, JsonObject &schema);
+    bool GetSettingsETag(AlpacaDevice *device, uint32_t revision, char *etag, size_t len); // device == nullptr: server section; false if not added
+    bool SendNotModified(AsyncWebServerRequest *request, const char *etag);
+    void SendJson(AsyncWebServerRequest *request, const String &ser_json, const char *etag);
+    void GetChanges(AlpacaDevice *device, uint32_t since, JsonObject &root);
     bool LoadSettings();
     bool SaveSettings();
+    void LockSettings() { xSemaphoreTakeRecursive(_settings_mutex, portMAX_DELAY); }  // around AlpacaReadJson()/AlpacaWriteJson()
+    void UnlockSettings() { xSemaphoreGiveRecursive(_settings_mutex); }
+    void MarkSettingsDirty() { _markSettingsDirty(0x01); }  // server section changed
+    void MarkSettingsDirty(AlpacaDevice *device);          // device section changed
+    const bool GetSettingsDirty() { return _settings_dirty != 0; }
+    const uint32_t GetSettingsWrites() { return _settings_writes; }
     void OnAlpacaDiscovery(AsyncUDPPacket &udpPacket);
     AsyncWebServer *getServerTCP() { return _server_tcp; }
-    const char *GetUID() { return _uid; }
-    const String GetSyslogHost() { return _syslog_host; };
-    const uint16_t GetLogLvl() { return _log_level; };
-    const bool GetSerialLog() { return _serial_log; };
+    const char *GetUID() { return _settings.uid; }
+    const String GetSyslogHost() { return String(_settings.syslog_host); };
+    const uint16_t GetLogLvl() { return _settings.log_level; };
+    const bool GetSerialLog() { return _settings.serial_log; };
     const bool GetResetRequest() { return _reset_request; };
     void SetResetRequest() { _reset_request = true; };
+    AlpacaPositionJournal &GetPositionJournal() { return _position_journal; };
 
     // only for testing
-    void RemoveSettingsFile() { LittleFS.remove(kAlpacaSettingsPath); }
+    void RemoveSettingsFile()
+    {
+        LittleFS.remove(kAlpacaSettingsPath);
+        LittleFS.remove(kAlpacaSettingsJsonPath);
+    }
 
     // Alpaca response status helpers ==============================================================================================
     void RspStatusClear(AlpacaRspStatus_t &rsp_status)
@@ -179,6 +310,14 @@ public:
         rsp_status.http_status = HttpStatus_t::kPassed;
         strcpy(rsp_status.error_msg, "");
     }
+    // the driver calls of a handler end with its response
+    void RspStatusReleaseDriver(AlpacaRspStatus_t &rsp_status)
+    {
+        if (rsp_status.driver_lock == nullptr)
+            return;
+        xSemaphoreGive(rsp_status.driver_lock);
+        rsp_status.driver_lock = nullptr;
+    }
 
 // Alpaca Error responses
 #define MYTHROW_RspStatusClientIDNotFound(req, rsp_status)                                                                   \
@@ -277,6 +416,14 @@ public:
         goto mycatch;                                                                                                                          \
     }
 
+#define MYTHROW_RspStatusInvalidWhileSlaved(req, rsp_status, command)                                                                  \
+    {                                                                                                                                   \
+        rsp_status.error_code = AlpacaErrorCode_t::InvalidWhileSlaved;                                                                  \
+        rsp_status.http_status = HttpStatus_t::kPassed;                                                                                 \
+        snprintf(rsp_status.error_msg, sizeof(rsp_status.error_msg), "%s - Command '%s' invalid while slaved", req->url().c_str(), command); \
+        goto mycatch;                                                                                                                   \
+    }
+
 #define MYTHROW_RspStatusCommandNotImplemented(req, rsp_status, command)                                                                \
     {                                                                                                                                   \
         rsp_status.error_code = AlpacaErrorCode_t::NotImplemented;                                                                      \
@@ -308,4 +455,12 @@ public:
         snprintf(rsp_status.error_msg, sizeof(rsp_status.error_msg), "%s - Command '%s' returned an error", req->url().c_str(), command);   \
         goto mycatch;                                                                                                                       \
     }
+
+#define MYTHROW_RspStatusDriverBusy(req, rsp_status, timeout_ms)                                                                             \
+    {                                                                                                                                       \
+        rsp_status.error_code = AlpacaErrorCode_t::InvalidOperationException;                                                               \
+        rsp_status.http_status = HttpStatus_t::kPassed;                                                                                     \
+        snprintf(rsp_status.error_msg, sizeof(rsp_status.error_msg), "%s - Driver busy for %u ms; retry", req->url().c_str(), timeout_ms);  \
+        goto mycatch;                                                                                                                       \
+    }
 };
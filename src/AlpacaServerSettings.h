@@ -0,0 +1,35 @@
+/**************************************************************************************************
+  Filename:       AlpacaServerSettings.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Settings table of the server
+
+  Free of the web server, so the fuzz target of the settings parser (test/fuzz) reads and
+  writes the shipped table.
+**************************************************************************************************/
+#pragma once
+#include <SLog.h>
+#include "AlpacaSettings.h"
+
+// settings of AlpacaServer
+struct AlpacaServerSettings_t
+{
+    char name[33];        // management server name
+    char uid[13];         // from wifi mac
+    uint16_t port_tcp;
+    uint16_t port_udp;
+    char syslog_host[65]; // Logging see SLog
+    uint16_t log_level;
+    bool serial_log;      // false/true: disable/enable logging after boot
+};
+
+// server settings: top level keys of settings and /jsondata
+static constexpr AlpacaSettingField_t kAlpacaServerSettings[] = {
+    ALPACA_SETTING(AlpacaServerSettings_t, name, nullptr, "Name", kString, 1, 32, false),
+    ALPACA_SETTING(AlpacaServerSettings_t, uid, nullptr, "UID", kString, 0, 12, true),
+    ALPACA_SETTING(AlpacaServerSettings_t, port_tcp, nullptr, "TCP_port", kUInt16, 1, 65535, false),
+    ALPACA_SETTING(AlpacaServerSettings_t, port_udp, nullptr, "UDP_port", kUInt16, 1, 65535, false),
+    ALPACA_SETTING(AlpacaServerSettings_t, syslog_host, nullptr, "SYSLOG_host", kString, 0, 64, false),
+    ALPACA_SETTING(AlpacaServerSettings_t, log_level, nullptr, "LOG_level", kUInt16, 0, SLOG_DEBUG, false),
+    ALPACA_SETTING(AlpacaServerSettings_t, serial_log, nullptr, "SERIAL_log", kBool, 0, 1, false),
+};
@@ -0,0 +1,269 @@
+/**************************************************************************************************
+  Filename:       AlpacaSettings.cpp
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+
+  Description:    Table driven settings of server and devices
+**************************************************************************************************/
+#include "AlpacaSettings.h"
+#include "AlpacaDebug.h"
+
+static const char *const kAlpacaSettingTypeStr[] = {"bool", "uint16", "int32", "uint32", "float", "double", "string"};
+
+static JsonVariant _fieldVariant(const AlpacaSettingField_t &field, JsonObject &root)
+{
+    if (field.section == nullptr)
+        return root[field.key];
+    JsonObject obj = root[field.section];
+    return obj ? obj[field.key] : JsonVariant();
+}
+
+// bool from true/false, "true"/"false" or 0/1
+static bool _readBool(JsonVariant value, bool &result)
+{
+    if (value.is<bool>())
+    {
+        result = value.as<bool>();
+        return true;
+    }
+    if (value.is<const char *>())
+    {
+        const char *str = value.as<const char *>();
+        if (strcasecmp(str, "true") == 0 || strcasecmp(str, "false") == 0)
+        {
+            result = (strcasecmp(str, "true") == 0);
+            return true;
+        }
+        return false;
+    }
+    if (value.is<int32_t>())
+    {
+        int32_t i = value.as<int32_t>();
+        if (i == 0 || i == 1)
+        {
+            result = (i == 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+// reason of a rejected value at the path of the field
+static void _fieldError(const AlpacaSettingField_t &field, JsonObject &errors, const char *reason)
+{
+    if (errors.isNull())
+        return;
+    char msg[64];
+    if (field.type == AlpacaSettingType_t::kString)
+        snprintf(msg, sizeof(msg), "%s; length %.0f..%.0f", reason, field.min, field.max);
+    else if (field.type == AlpacaSettingType_t::kBool || field.read_only)
+        snprintf(msg, sizeof(msg), "%s", reason);
+    else
+        snprintf(msg, sizeof(msg), "%s; range %g..%g", reason, field.min, field.max);
+    if (field.section == nullptr)
+        errors[field.key] = msg;
+    else
+        errors[field.section][field.key] = msg;
+}
+
+uint32_t AlpacaSettings::Read(const AlpacaSettingField_t *fields, size_t n, JsonObject &root, void *settings, JsonObject errors)
+{
+    uint32_t rejected = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        const AlpacaSettingField_t &field = fields[i];
+        JsonVariant value = _fieldVariant(field, root);
+        if (value.isNull())
+            continue;
+        if (field.read_only)
+        {
+            _fieldError(field, errors, "read only");
+            continue;
+        }
+
+        uint8_t *member = (uint8_t *)settings + field.offset;
+        bool valid = false;
+        switch (field.type)
+        {
+        case AlpacaSettingType_t::kBool:
+        {
+            bool b;
+            if ((valid = _readBool(value, b)))
+                *(bool *)member = b;
+            break;
+        }
+        case AlpacaSettingType_t::kString:
+        {
+            const char *str = value.as<const char *>();
+            size_t len = str ? strlen(str) : 0;
+            if ((valid = (str != nullptr && len >= field.min && len <= field.max && len < field.size)))
+                strlcpy((char *)member, str, field.size);
+            break;
+        }
+        default:
+        {
+            if (!value.is<double>())
+                break;
+            double d = value.as<double>();
+            if (!(d >= field.min && d <= field.max)) // also rejects NaN
+                break;
+            if (field.type != AlpacaSettingType_t::kFloat && field.type != AlpacaSettingType_t::kDouble && d != floor(d))
+                break; // no silent truncation of 1.5 to an integer field
+            valid = true;
+            switch (field.type)
+            {
+            case AlpacaSettingType_t::kUInt16:
+                *(uint16_t *)member = (uint16_t)d;
+                break;
+            case AlpacaSettingType_t::kInt32:
+                *(int32_t *)member = (int32_t)d;
+                break;
+            case AlpacaSettingType_t::kUInt32:
+                *(uint32_t *)member = (uint32_t)d;
+                break;
+            case AlpacaSettingType_t::kFloat:
+                *(float *)member = (float)d;
+                break;
+            case AlpacaSettingType_t::kDouble:
+                *(double *)member = d;
+                break;
+            default:
+                valid = false;
+                break;
+            }
+        }
+        }
+
+        if (!valid)
+        {
+            rejected++;
+            _fieldError(field, errors, "invalid");
+            SLOG_WARNING_PRINTF("setting %s/%s invalid; kept\n", field.section ? field.section : "", field.key);
+        }
+    }
+    return rejected;
+}
+
+void AlpacaSettings::Write(const AlpacaSettingField_t *fields, size_t n, const void *settings, JsonObject &root)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        const AlpacaSettingField_t &field = fields[i];
+        JsonObject obj = root;
+        if (field.section != nullptr)
+        {
+            obj = root[field.section];
+            if (!obj)
+                obj = root[field.section].to<JsonObject>();
+        }
+
+        const uint8_t *member = (const uint8_t *)settings + field.offset;
+        switch (field.type)
+        {
+        case AlpacaSettingType_t::kBool:
+            obj[field.key] = *(const bool *)member;
+            break;
+        case AlpacaSettingType_t::kUInt16:
+            obj[field.key] = *(const uint16_t *)member;
+            break;
+        case AlpacaSettingType_t::kInt32:
+            obj[field.key] = *(const int32_t *)member;
+            break;
+        case AlpacaSettingType_t::kUInt32:
+            obj[field.key] = *(const uint32_t *)member;
+            break;
+        case AlpacaSettingType_t::kFloat:
+            obj[field.key] = *(const float *)member;
+            break;
+        case AlpacaSettingType_t::kDouble:
+            obj[field.key] = *(const double *)member;
+            break;
+        case AlpacaSettingType_t::kString:
+            obj[field.key] = (const char *)member;
+            break;
+        }
+    }
+}
+
+uint32_t AlpacaSettings::Restore(const AlpacaSettingField_t *fields, size_t n, JsonObject &root, void *settings)
+{
+    uint32_t rejected = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (!fields[i].read_only)
+            continue;
+        AlpacaSettingField_t field = fields[i]; // validated like a writable field
+        field.read_only = false;
+        rejected += Read(&field, 1, root, settings);
+    }
+    return rejected;
+}
+
+void AlpacaSettings::Filter(const AlpacaSettingField_t *fields, size_t n, JsonObject &filter, bool read_only)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        if (fields[i].read_only && !read_only)
+            continue;
+        if (fields[i].section == nullptr)
+            filter[fields[i].key] = true;
+        else
+            filter[fields[i].section][fields[i].key] = true;
+    }
+}
+
+void AlpacaSettings::Schema(const AlpacaSettingField_t *fields, size_t n, JsonObject &root)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        const AlpacaSettingField_t &field = fields[i];
+        JsonObject obj;
+        if (field.section == nullptr)
+            obj = root[field.key].to<JsonObject>();
+        else
+            obj = root[field.section][field.key].to<JsonObject>();
+        obj["Type"] = kAlpacaSettingTypeStr[(int)field.type];
+        if (field.type != AlpacaSettingType_t::kBool)
+        {
+            obj["Min"] = field.min;
+            obj["Max"] = field.max;
+        }
+        obj["ReadOnly"] = field.read_only;
+    }
+}
+
+uint32_t AlpacaSettings::Unknown(JsonObject root, JsonObject known, JsonObject errors)
+{
+    uint32_t unknown = 0;
+    for (JsonPair kv : root)
+    {
+        JsonVariant known_value = known[kv.key()];
+        if (known_value.isNull())
+        {
+            errors[kv.key()] = "unknown";
+            unknown++;
+        }
+        else if (known_value.is<JsonObject>())
+        {
+            if (!kv.value().is<JsonObject>())
+            {
+                errors[kv.key()] = "object expected";
+                unknown++;
+                continue;
+            }
+            JsonObject section_errors = errors[kv.key()].to<JsonObject>();
+            unknown += Unknown(kv.value().as<JsonObject>(), known_value.as<JsonObject>(), section_errors);
+            if (section_errors.size() == 0)
+                errors.remove(kv.key().c_str());
+        }
+    }
+    return unknown;
+}
+
+uint32_t AlpacaSettings::Count(JsonObject root)
+{
+    uint32_t count = 0;
+    for (JsonPair kv : root)
+        count += kv.value().is<JsonObject>() ? Count(kv.value().as<JsonObject>()) : 1;
+    return count;
+}
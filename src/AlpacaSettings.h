@@ -0,0 +1,74 @@
+/**************************************************************************************************
+  Filename:       AlpacaSettings.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+
+  Description:    Table driven settings of server and devices
+
+  Each class describes its settings with a constexpr table of AlpacaSettingField_t, one entry
+  per JSON key, mapped by offsetof() to a member of a plain settings struct. The same table
+  drives reading (with validation), writing, the load filter and the schema for the setup UI.
+**************************************************************************************************/
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <stddef.h>
+
+enum struct AlpacaSettingType_t : uint8_t
+{
+    kBool,
+    kUInt16,
+    kInt32,
+    kUInt32,
+    kFloat,
+    kDouble,
+    kString
+};
+
+struct AlpacaSettingField_t
+{
+    const char *section;      // JSON object of the key; nullptr - key at top level
+    const char *key;          // JSON key
+    AlpacaSettingType_t type; // type of the struct member
+    uint16_t offset;          // offsetof() the member in the settings struct
+    uint16_t size;            // sizeof() the member; buffer size for kString
+    double min;               // numbers: min value; kString: min length
+    double max;               // numbers: max value; kString: max length (< size)
+    bool read_only;           // written and shown, never read
+};
+
+// table entry for <member> of <struct_t>
+#define ALPACA_SETTING(struct_t, member, section, key, type, min, max, read_only) \
+    {section, key, AlpacaSettingType_t::type, offsetof(struct_t, member), sizeof(((struct_t *)nullptr)->member), min, max, read_only}
+
+class AlpacaSettings
+{
+public:
+    // read all writable fields present in root into settings; invalid values are rejected and keep the
+    // current value; returns the number of rejected values. If errors is not null, every rejected or
+    // read-only key present in root gets its reason at the same path in errors
+    static uint32_t Read(const AlpacaSettingField_t *fields, size_t n, JsonObject &root, void *settings, JsonObject errors = JsonObject());
+    static void Write(const AlpacaSettingField_t *fields, size_t n, const void *settings, JsonObject &root);
+    // Read() of the read-only fields only; for state kept with the settings, e.g. a fitted model, when
+    // the settings are loaded or imported, never for the setup form or a PATCH
+    static uint32_t Restore(const AlpacaSettingField_t *fields, size_t n, JsonObject &root, void *settings);
+    // keys read by Read() as DeserializationOption::Filter; read_only - also those read by Restore()
+    static void Filter(const AlpacaSettingField_t *fields, size_t n, JsonObject &filter, bool read_only = false);
+    // type, bounds and access of every field for the setup UI
+    static void Schema(const AlpacaSettingField_t *fields, size_t n, JsonObject &root);
+    // keys of a PATCH that are not in known (the jsondata of the section) get "unknown" in errors; returns their number
+    static uint32_t Unknown(JsonObject root, JsonObject known, JsonObject errors);
+    // number of values in root, those of nested objects included
+    static uint32_t Count(JsonObject root);
+
+    template <size_t N>
+    static uint32_t Read(const AlpacaSettingField_t (&fields)[N], JsonObject &root, void *settings, JsonObject errors = JsonObject()) { return Read(fields, N, root, settings, errors); }
+    template <size_t N>
+    static void Write(const AlpacaSettingField_t (&fields)[N], const void *settings, JsonObject &root) { Write(fields, N, settings, root); }
+    template <size_t N>
+    static uint32_t Restore(const AlpacaSettingField_t (&fields)[N], JsonObject &root, void *settings) { return Restore(fields, N, root, settings); }
+    template <size_t N>
+    static void Filter(const AlpacaSettingField_t (&fields)[N], JsonObject &filter, bool read_only = false) { Filter(fields, N, filter, read_only); }
+    template <size_t N>
+    static void Schema(const AlpacaSettingField_t (&fields)[N], JsonObject &root) { Schema(fields, N, root); }
+};
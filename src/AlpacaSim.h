@@ -0,0 +1,51 @@
+/**************************************************************************************************
+  Filename:       AlpacaSim.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 02 $
+  Description:    Common helpers for the simulated reference drivers (AlpacaSim*)
+
+  JSON settings of the latency and failure model of AlpacaSimCore.h; the model itself has no
+  JSON dependency and is run on the host by test/test_simulators. The settings tables of all
+  simulators are in AlpacaSimSettings.h.
+**************************************************************************************************/
+#pragma once
+#include "AlpacaDevice.h"
+#include "AlpacaSimCore.h"
+#include "AlpacaSimSettings.h"
+
+class AlpacaSimulator : public AlpacaSimCore
+{
+public:
+    // settings keys of the simulators: "General" of AlpacaDevice and "Simulator"
+    void SimSettingsFilter(JsonObject &filter)
+    {
+        filter["General"] = true;
+        filter["Simulator"] = true;
+    }
+
+    // "Simulator" section of the device setup page; Calls and Failures are read-only
+    void SimReadJson(JsonObject &root, JsonObject errors = JsonObject())
+    {
+        if (root["Simulator"].isNull())
+            return; // keep the PRNG state
+        AlpacaSimConfig_t config = GetSimConfig();
+        AlpacaSimCounters_t counters = {_sim_calls, _sim_failures};
+        AlpacaSettings::Read(kAlpacaSimSettings, root, &config, errors);
+        AlpacaSettings::Read(kAlpacaSimCounters, root, &counters, errors); // only reports them as read-only
+        SetSimConfig(config);
+    }
+
+    void SimWriteJson(JsonObject &root)
+    {
+        AlpacaSimCounters_t counters = {_sim_calls, _sim_failures};
+        AlpacaSettings::Write(kAlpacaSimSettings, &GetSimConfig(), root);
+        AlpacaSettings::Write(kAlpacaSimCounters, &counters, root);
+    }
+
+    void SimWriteSchema(JsonObject &root)
+    {
+        AlpacaSettings::Schema(kAlpacaSimSettings, root);
+        AlpacaSettings::Schema(kAlpacaSimCounters, root);
+    }
+    uint32_t SimJsonRevision() { return _sim_calls + _sim_failures; } // Calls and Failures of SimWriteJson()
+};
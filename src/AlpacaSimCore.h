@@ -0,0 +1,80 @@
+/**************************************************************************************************
+  Filename:       AlpacaSimCore.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Latency and failure model of the simulated reference drivers (AlpacaSim*)
+
+  Every simulator call goes through AlpacaSimCore::SimCall() which adds the configured
+  latency and decides - from a seeded PRNG - whether the call fails. With the same seed
+  and the same request sequence the simulators behave identically on every run.
+  No JSON and no server dependency; the host test (test/test_simulators) runs it in simulated time.
+**************************************************************************************************/
+#pragma once
+#include <Arduino.h>
+#include "AlpacaConfig.h"
+
+struct AlpacaSimConfig_t
+{
+    uint32_t latency_ms;        // fixed latency of every driver call
+    uint32_t jitter_ms;         // additional random latency 0,...,jitter_ms
+    uint32_t failure_permille;  // probability of a failing driver call [1/1000]
+    uint32_t seed;              // PRNG seed; 0 - use default seed
+};
+
+class AlpacaSimCore
+{
+private:
+    AlpacaSimConfig_t _sim_config = {0, 0, 0, 1};
+    uint32_t _sim_state = 1;
+
+protected:
+    uint32_t _sim_calls = 0;
+    uint32_t _sim_failures = 0;
+
+public:
+    // xorshift32; deterministic for a given seed
+    uint32_t SimRandom()
+    {
+        _sim_state ^= _sim_state << 13;
+        _sim_state ^= _sim_state >> 17;
+        _sim_state ^= _sim_state << 5;
+        return _sim_state;
+    }
+
+    // uniform in [-1.0,...,1.0]
+    double SimNoise() { return ((double)(SimRandom() % 20001) - 10000.0) / 10000.0; }
+
+    // latency of the next call incl. extra_ms of the device (e.g. a relay write); clamped to kAlpacaSimMaxLatencyMs
+    // because the call blocks the AsyncTCP task while it holds the driver lock
+    uint32_t SimLatency(uint32_t extra_ms = 0)
+    {
+        uint64_t latency_ms = (uint64_t)_sim_config.latency_ms + extra_ms;
+        if (_sim_config.jitter_ms > 0)
+            latency_ms += SimRandom() % ((uint64_t)_sim_config.jitter_ms + 1);
+        return latency_ms < kAlpacaSimMaxLatencyMs ? (uint32_t)latency_ms : kAlpacaSimMaxLatencyMs;
+    }
+
+    // apply latency; return false if failure injection decided that this call fails
+    bool SimCall(uint32_t extra_ms = 0)
+    {
+        _sim_calls++;
+        uint32_t latency_ms = SimLatency(extra_ms);
+        if (latency_ms > 0)
+            delay(latency_ms);
+        if (_sim_config.failure_permille > 0 && (SimRandom() % 1000) < _sim_config.failure_permille)
+        {
+            _sim_failures++;
+            return false;
+        }
+        return true;
+    }
+
+    void SetSimConfig(const AlpacaSimConfig_t &config)
+    {
+        _sim_config = config;
+        _sim_state = config.seed != 0 ? config.seed : 1;
+    }
+    const AlpacaSimConfig_t &GetSimConfig() { return _sim_config; }
+    const uint32_t GetSimCalls() { return _sim_calls; }
+    const uint32_t GetSimFailures() { return _sim_failures; }
+};
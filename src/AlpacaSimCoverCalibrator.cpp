@@ -0,0 +1,110 @@
+/**************************************************************************************************
+  Filename:       AlpacaSimCoverCalibrator.cpp
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Simulated reference CoverCalibrator - cover travel time, calibrator warm-up
+**************************************************************************************************/
+#include "AlpacaSimCoverCalibrator.h"
+
+AlpacaSimCoverCalibrator::AlpacaSimCoverCalibrator(uint32_t cover_travel_ms, uint32_t warmup_ms)
+{
+    _cover_travel_ms = cover_travel_ms;
+    _warmup_ms = warmup_ms;
+    SetCoverState(AlpacaCoverStatus_t::kClosed);
+    SetCalibratorState(AlpacaCalibratorStatus_t::kOff);
+    SetMaxBrightness(ALPACA_COVER_CALIBRATOR_MAX_BRIGHTNESS);
+}
+
+void AlpacaSimCoverCalibrator::Loop()
+{
+    uint32_t now_ms = millis();
+    if (GetCoverState() == AlpacaCoverStatus_t::kMoving && now_ms - _cover_start_ms >= _cover_travel_ms)
+        SetCoverState(_cover_target);
+    if (GetCalibratorState() == AlpacaCalibratorStatus_t::kNotReady && now_ms - _calibrator_start_ms >= _warmup_ms)
+        SetCalibratorState(AlpacaCalibratorStatus_t::kReady);
+}
+
+const bool AlpacaSimCoverCalibrator::_calibratorOff()
+{
+    if (!SimCall())
+    {
+        SetCalibratorState(AlpacaCalibratorStatus_t::kError);
+        return false;
+    }
+    SetBrightness(0);
+    SetCalibratorState(AlpacaCalibratorStatus_t::kOff);
+    return true;
+}
+
+const bool AlpacaSimCoverCalibrator::_calibratorOn(int32_t brightness)
+{
+    if (brightness < 0 || brightness > GetMaxBrightness())
+        return false;
+    if (!SimCall())
+    {
+        SetCalibratorState(AlpacaCalibratorStatus_t::kError);
+        return false;
+    }
+    SetBrightness(brightness);
+    SetCalibratorState(AlpacaCalibratorStatus_t::kNotReady);
+    _calibrator_start_ms = millis();
+    return true;
+}
+
+const bool AlpacaSimCoverCalibrator::_closeCover()
+{
+    if (!SimCall())
+    {
+        SetCoverState(AlpacaCoverStatus_t::kError);
+        return false;
+    }
+    _cover_target = AlpacaCoverStatus_t::kClosed;
+    _cover_start_ms = millis();
+    SetCoverState(AlpacaCoverStatus_t::kMoving);
+    return true;
+}
+
+const bool AlpacaSimCoverCalibrator::_openCover()
+{
+    if (!SimCall())
+    {
+        SetCoverState(AlpacaCoverStatus_t::kError);
+        return false;
+    }
+    _cover_target = AlpacaCoverStatus_t::kOpen;
+    _cover_start_ms = millis();
+    SetCoverState(AlpacaCoverStatus_t::kMoving);
+    return true;
+}
+
+const bool AlpacaSimCoverCalibrator::_haltCover()
+{
+    if (GetCoverState() == AlpacaCoverStatus_t::kMoving)
+        SetCoverState(AlpacaCoverStatus_t::kUnknown);
+    return SimCall();
+}
+
+void AlpacaSimCoverCalibrator::AlpacaReadJson(JsonObject &root)
+{
+    AlpacaCoverCalibrator::AlpacaReadJson(root);
+    SimReadJson(root, _patch_errors);
+    AlpacaSimCoverCalibratorConfig_t config = {_cover_travel_ms, _warmup_ms};
+    AlpacaSettings::Read(kAlpacaSimCoverCalibratorSettings, root, &config, _patch_errors);
+    _cover_travel_ms = config.cover_travel_ms;
+    _warmup_ms = config.warmup_ms;
+}
+
+void AlpacaSimCoverCalibrator::AlpacaWriteJson(JsonObject &root)
+{
+    AlpacaCoverCalibrator::AlpacaWriteJson(root);
+    SimWriteJson(root);
+    AlpacaSimCoverCalibratorConfig_t config = {_cover_travel_ms, _warmup_ms};
+    AlpacaSettings::Write(kAlpacaSimCoverCalibratorSettings, &config, root);
+}
+
+void AlpacaSimCoverCalibrator::AlpacaWriteSchema(JsonObject &root)
+{
+    AlpacaCoverCalibrator::AlpacaWriteSchema(root);
+    SimWriteSchema(root);
+    AlpacaSettings::Schema(kAlpacaSimCoverCalibratorSettings, root);
+}
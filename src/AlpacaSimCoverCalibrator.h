@@ -0,0 +1,49 @@
+/**************************************************************************************************
+  Filename:       AlpacaSimCoverCalibrator.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Simulated reference CoverCalibrator - cover travel time, calibrator warm-up
+**************************************************************************************************/
+#pragma once
+#include "AlpacaCoverCalibrator.h"
+#include "AlpacaSim.h"
+
+class AlpacaSimCoverCalibrator : public AlpacaCoverCalibrator, public AlpacaSimulator
+{
+private:
+    uint32_t _cover_travel_ms = 5000;
+    uint32_t _warmup_ms = 1000;
+    uint32_t _cover_start_ms = 0;
+    uint32_t _calibrator_start_ms = 0;
+    AlpacaCoverStatus_t _cover_target = AlpacaCoverStatus_t::kClosed;
+
+#ifdef ALPACA_COVER_CALIBRATOR_PUT_ACTION_IMPLEMENTED
+    const bool _putAction(const char *const action, const char *const parameters) { return false; };
+#endif
+#ifdef ALPACA_COVER_CALIBRATOR_PUT_COMMAND_BLIND_IMPLEMENTED
+    const bool _putCommandBlind(const char *const command, const char *const raw) { return false; };
+#endif
+#ifdef ALPACA_COVER_CALIBRATOR_PUT_COMMAND_BOOL_IMPLEMENTED
+    const bool _putCommandBool(const char *const command, const char *const raw, bool &command_bool) { return false; };
+#endif
+#ifdef ALPACA_COVER_CALIBRATOR_PUT_COMMAND_STRING_IMPLEMENTED
+    const bool _putCommandString(const char *const command, const char *const raw, char *string_response, size_t string_response_size) { return false; };
+#endif
+
+    const bool _calibratorOff();
+    const bool _calibratorOn(int32_t brightness);
+    const bool _closeCover();
+    const bool _openCover();
+    const bool _haltCover();
+    const char *const _getFirmwareVersion() { return "sim"; };
+
+public:
+    AlpacaSimCoverCalibrator(uint32_t cover_travel_ms = 5000, uint32_t warmup_ms = 1000);
+    void Begin() { AlpacaCoverCalibrator::Begin(); };
+    void Loop();
+    void AlpacaReadJson(JsonObject &root);
+    void AlpacaWriteJson(JsonObject &root);
+    void AlpacaSettingsFilter(JsonObject &filter) { SimSettingsFilter(filter); }
+    uint32_t AlpacaJsonRevision() { return SimJsonRevision(); }
+    void AlpacaWriteSchema(JsonObject &root);
+};
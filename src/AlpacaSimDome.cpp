@@ -0,0 +1,89 @@
+/**************************************************************************************************
+  Filename:       AlpacaSimDome.cpp
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Simulated reference Dome - shutter with travel time, rotation with inertia
+**************************************************************************************************/
+#include "AlpacaSimDome.h"
+
+// integrate shutter movement since the latest update; limits are sent as shutter events
+void AlpacaSimDome::_updateShutter()
+{
+    uint32_t now_ms = millis();
+    if (_shutter_dir != 0)
+    {
+        _shutter_pos_ms += _shutter_dir * (int32_t)(now_ms - _shutter_time_ms);
+        if (_shutter_pos_ms <= 0)
+        {
+            _shutter_pos_ms = 0;
+            _shutter_dir = 0;
+            ShutterEvent(AlpacaShutterEvent_t::kClosedLimit);
+        }
+        else if (_shutter_pos_ms >= (int32_t)_travel_time_ms)
+        {
+            _shutter_pos_ms = _travel_time_ms;
+            _shutter_dir = 0;
+            ShutterEvent(AlpacaShutterEvent_t::kOpenLimit);
+        }
+    }
+    _shutter_time_ms = now_ms;
+}
+
+const bool AlpacaSimDome::_putAbort()
+{
+    _updateShutter();
+    _shutter_dir = 0;
+    return SimCall();
+}
+
+const bool AlpacaSimDome::_putClose()
+{
+    _updateShutter();
+    if (!SimCall())
+        return false;
+    _shutter_dir = -1;
+    return true;
+}
+
+const bool AlpacaSimDome::_putOpen()
+{
+    _updateShutter();
+    if (!SimCall())
+        return false;
+    _shutter_dir = 1;
+    return true;
+}
+
+const bool AlpacaSimDome::_getSlewing()
+{
+    _updateShutter();
+    return _shutter_dir != 0;
+}
+
+void AlpacaSimDome::AlpacaReadJson(JsonObject &root)
+{
+    AlpacaDome::AlpacaReadJson(root);
+    SimReadJson(root, _patch_errors);
+    AlpacaSimDomeConfig_t config = {_travel_time_ms, _rotation_speed_dps, _rotation_accel_dps2};
+    AlpacaSettings::Read(kAlpacaSimDomeSettings, root, &config, _patch_errors);
+    _travel_time_ms = config.travel_time_ms;
+    SetShutterTimeout(_travel_time_ms * 3 / 2);
+    _rotation_speed_dps = config.rotation_speed_dps;
+    _rotation_accel_dps2 = config.rotation_accel_dps2;
+    _motor.SetSpeed(_rotation_speed_dps, _rotation_accel_dps2);
+}
+
+void AlpacaSimDome::AlpacaWriteJson(JsonObject &root)
+{
+    AlpacaDome::AlpacaWriteJson(root);
+    SimWriteJson(root);
+    AlpacaSimDomeConfig_t config = {_travel_time_ms, _rotation_speed_dps, _rotation_accel_dps2};
+    AlpacaSettings::Write(kAlpacaSimDomeSettings, &config, root);
+}
+
+void AlpacaSimDome::AlpacaWriteSchema(JsonObject &root)
+{
+    AlpacaDome::AlpacaWriteSchema(root);
+    SimWriteSchema(root);
+    AlpacaSettings::Schema(kAlpacaSimDomeSettings, root);
+}
@@ -0,0 +1,63 @@
+/**************************************************************************************************
+  Filename:       AlpacaSimDome.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Simulated reference Dome - shutter with travel time, rotation with inertia
+
+  The shutter reports its limits as events to the state machine of AlpacaDome. The rotation is
+  driven by AlpacaDomeRotator through a simulated motor which moves the encoder and triggers the
+  home sensor.
+**************************************************************************************************/
+#pragma once
+#include "AlpacaDome.h"
+#include "AlpacaSim.h"
+#include "AlpacaSimDomeMotor.h"
+
+class AlpacaSimDome : public AlpacaDome, public AlpacaSimulator
+{
+private:
+    static const int32_t kCountsPerRev = 3600;
+    float _rotation_speed_dps = 5.0f;   // max rotation speed [deg/s]
+    float _rotation_accel_dps2 = 2.0f;  // rotation acceleration [deg/s^2]
+    AlpacaDomeRotator _rotator;
+    AlpacaSimDomeMotor _motor{_rotator, kCountsPerRev, _rotation_speed_dps, _rotation_accel_dps2};
+    uint32_t _travel_time_ms = 10000;   // full open <-> close travel time
+    int32_t _shutter_pos_ms = 0;        // 0 - closed; _travel_time_ms - open
+    int32_t _shutter_dir = 0;           // +1 opening, -1 closing, 0 stopped
+    uint32_t _shutter_time_ms = 0;      // time of the latest position update
+
+    void _updateShutter();
+
+    const bool _putAbort();
+    const bool _putClose();
+    const bool _putOpen();
+    const bool _getSlewing();
+    const char *const _getFirmwareVersion() { return "sim"; };
+
+public:
+    AlpacaSimDome(uint32_t travel_time_ms = 10000) : _travel_time_ms(travel_time_ms)
+    {
+        SetShutterTimeout(travel_time_ms * 3 / 2);
+        SetRotator(&_rotator);
+    };
+    void Begin()
+    {
+        _rotator.Begin(&_motor, kCountsPerRev);
+        ShutterEvent(_shutter_pos_ms == 0 ? AlpacaShutterEvent_t::kClosedLimit : AlpacaShutterEvent_t::kOpenLimit);
+        AlpacaDome::Begin();
+    };
+    void Loop()
+    {
+        _updateShutter();
+        AlpacaDome::Loop();
+    }
+    void AlpacaReadJson(JsonObject &root);
+    void AlpacaWriteJson(JsonObject &root);
+    void AlpacaSettingsFilter(JsonObject &filter)
+    {
+        AlpacaDome::AlpacaSettingsFilter(filter);
+        SimSettingsFilter(filter);
+    }
+    uint32_t AlpacaJsonRevision() { return SimJsonRevision(); }
+    void AlpacaWriteSchema(JsonObject &root);
+};
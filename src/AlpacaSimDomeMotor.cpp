@@ -0,0 +1,27 @@
+/**************************************************************************************************
+  Filename:       AlpacaSimDomeMotor.cpp
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Simulated dome motor - backend of AlpacaDomeRotator with inertia
+**************************************************************************************************/
+#include "AlpacaSimDomeMotor.h"
+
+// ramp the speed to the command, move and report whole counts and home sensor crossings; control tick of the rotator
+void AlpacaSimDomeMotor::Tick(uint32_t dt_us)
+{
+    float dt = (float)dt_us / 1000000.0f;
+    float target = _command * _max_speed;
+    float dv = _accel * dt;
+    _speed = target > _speed + dv ? _speed + dv : (target < _speed - dv ? _speed - dv : target);
+
+    double old_position = _position;
+    _position += _speed * dt;
+    int32_t encoder = (int32_t)floor(_position);
+    if (encoder != _encoder)
+    {
+        _rotator.EncoderStep(encoder - _encoder);
+        _encoder = encoder;
+    }
+    if (floor((old_position - _home_counts) / _counts_per_rev) != floor((_position - _home_counts) / _counts_per_rev))
+        _rotator.HomeSensor();
+}
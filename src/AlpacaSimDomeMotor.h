@@ -0,0 +1,37 @@
+/**************************************************************************************************
+  Filename:       AlpacaSimDomeMotor.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Simulated dome motor - backend of AlpacaDomeRotator with inertia
+
+  Used by AlpacaSimDome and by the host test of the rotator (test/test_dome_rotator).
+**************************************************************************************************/
+#pragma once
+#include "AlpacaDomeRotator.h"
+
+// motor backend with max speed and acceleration; feeds encoder counts and home sensor of the rotator
+class AlpacaSimDomeMotor : public AlpacaDomeMotor
+{
+private:
+    AlpacaDomeRotator &_rotator;
+    int32_t _counts_per_rev;
+    int32_t _home_counts;          // home sensor position
+    float _max_speed;              // [counts/s]
+    float _accel;                  // [counts/s^2]
+    volatile float _command = 0.0f;
+    float _speed = 0.0f;           // [counts/s]
+    double _position = 0.0;        // [counts]
+    int32_t _encoder = 0;          // counts sent to the rotator
+
+public:
+    AlpacaSimDomeMotor(AlpacaDomeRotator &rotator, int32_t counts_per_rev, float max_speed_dps, float accel_dps2)
+        : _rotator(rotator), _counts_per_rev(counts_per_rev), _home_counts(counts_per_rev / 4),
+          _max_speed(max_speed_dps * counts_per_rev / 360.0f), _accel(accel_dps2 * counts_per_rev / 360.0f) {};
+    void Drive(float speed) { _command = speed; };
+    void Tick(uint32_t dt_us);
+    void SetSpeed(float max_speed_dps, float accel_dps2)
+    {
+        _max_speed = max_speed_dps * _counts_per_rev / 360.0f;
+        _accel = accel_dps2 * _counts_per_rev / 360.0f;
+    };
+};
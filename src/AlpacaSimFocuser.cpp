@@ -0,0 +1,130 @@
+/**************************************************************************************************
+  Filename:       AlpacaSimFocuser.cpp
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 02 $
+  Description:    Simulated reference Focuser - driver or step generator moves, noisy temperature
+**************************************************************************************************/
+#include "AlpacaSimFocuser.h"
+
+// position on a trapezoidal (or triangular for short moves) velocity profile
+int32_t AlpacaSimFocuser::_positionAt(uint32_t now_ms)
+{
+    double distance = fabs((double)(_target_pos - _start_pos));
+    if (distance == 0.0 || _speed <= 0.0f || _accel <= 0.0f)
+        return _target_pos;
+
+    double t = (double)(now_ms - _start_ms) / 1000.0;
+    double t_acc = _speed / _accel;
+    double d_acc = 0.5 * _accel * t_acc * t_acc;
+    double v_max = _speed;
+    if (2.0 * d_acc > distance) // triangular profile
+    {
+        t_acc = sqrt(distance / _accel);
+        d_acc = distance / 2.0;
+        v_max = _accel * t_acc;
+    }
+    double t_cruise = (distance - 2.0 * d_acc) / v_max;
+    double s;
+    if (t <= t_acc)
+        s = 0.5 * _accel * t * t;
+    else if (t <= t_acc + t_cruise)
+        s = d_acc + v_max * (t - t_acc);
+    else if (t <= 2.0 * t_acc + t_cruise)
+    {
+        double td = 2.0 * t_acc + t_cruise - t;
+        s = distance - 0.5 * _accel * td * td;
+    }
+    else
+        s = distance;
+
+    return _start_pos + (_target_pos > _start_pos ? 1 : -1) * (int32_t)(s + 0.5);
+}
+
+const bool AlpacaSimFocuser::_putHalt()
+{
+    if (!SimCall())
+        return false;
+    _start_pos = _target_pos = _positionAt(millis());
+    return true;
+}
+
+const bool AlpacaSimFocuser::_putMove(int32_t position)
+{
+    if (!SimCall())
+        return false;
+    if (position < 0 || position > _max_step)
+        return false;
+    uint32_t now_ms = millis();
+    _start_pos = _positionAt(now_ms);
+    _target_pos = position;
+    _start_ms = now_ms;
+    PublishMove(_start_pos, _target_pos, _speed, _accel);
+    _move_published = true;
+    return true;
+}
+
+// the driver's end of move: the simulated position corrects the prediction
+void AlpacaSimFocuser::Loop()
+{
+    AlpacaFocuser::Loop();
+    if (_move_published && _positionAt(millis()) == _target_pos)
+    {
+        CorrectPosition(_target_pos, false);
+        _move_published = false;
+    }
+}
+
+const bool AlpacaSimFocuser::_getIsMoving()
+{
+    SimCall();
+    return _positionAt(millis()) != _target_pos;
+}
+
+const int32_t AlpacaSimFocuser::_getPosition()
+{
+    SimCall();
+    return _positionAt(millis());
+}
+
+const double AlpacaSimFocuser::_getTemperature()
+{
+    SimCall();
+    return _temperature + _temperature_drift * (double)millis() / 3600000.0 + _temperature_noise * SimNoise();
+}
+
+void AlpacaSimFocuser::AlpacaReadJson(JsonObject &root)
+{
+    AlpacaFocuser::AlpacaReadJson(root);
+    SimReadJson(root, _patch_errors);
+    AlpacaSimFocuserConfig_t config = {_max_step, _temperature, _temperature_noise, _temperature_drift};
+    AlpacaSettings::Read(kAlpacaSimFocuserSettings, root, &config, _patch_errors);
+    _max_step = config.max_step;
+    _max_increment = _max_step;
+    _temperature = config.temperature;
+    _temperature_noise = config.temperature_noise;
+    _temperature_drift = config.temperature_drift;
+
+    AlpacaSimFocuserMotion_t motion = {_speed, _accel, _sink.GetPlay(), _sink.GetLoad()};
+    AlpacaSettings::Read(_step_generator ? kAlpacaSimFocuserLoadSettings : kAlpacaSimFocuserProfileSettings, root, &motion, _patch_errors);
+    _speed = motion.speed;
+    _accel = motion.accel;
+    _sink.SetPlay(motion.play_steps);
+}
+
+void AlpacaSimFocuser::AlpacaWriteJson(JsonObject &root)
+{
+    AlpacaFocuser::AlpacaWriteJson(root);
+    SimWriteJson(root);
+    AlpacaSimFocuserConfig_t config = {_max_step, _temperature, _temperature_noise, _temperature_drift};
+    AlpacaSettings::Write(kAlpacaSimFocuserSettings, &config, root);
+    AlpacaSimFocuserMotion_t motion = {_speed, _accel, _sink.GetPlay(), _sink.GetLoad()};
+    AlpacaSettings::Write(_step_generator ? kAlpacaSimFocuserLoadSettings : kAlpacaSimFocuserProfileSettings, &motion, root);
+}
+
+void AlpacaSimFocuser::AlpacaWriteSchema(JsonObject &root)
+{
+    AlpacaFocuser::AlpacaWriteSchema(root);
+    SimWriteSchema(root);
+    AlpacaSettings::Schema(kAlpacaSimFocuserSettings, root);
+    AlpacaSettings::Schema(_step_generator ? kAlpacaSimFocuserLoadSettings : kAlpacaSimFocuserProfileSettings, root);
+}
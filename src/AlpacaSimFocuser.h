@@ -0,0 +1,112 @@
+/**************************************************************************************************
+  Filename:       AlpacaSimFocuser.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Simulated reference Focuser - driver or step generator moves, noisy temperature
+
+  By default the simulator is a driver that runs its moves itself on a trapezoidal profile; Move,
+  Halt, Position and IsMoving are driver calls through SimCall(). Each move is published with
+  PublishMove() and corrected with the simulated position when it ends, so Position and IsMoving
+  are predicted while moving. With step_generator the moves are
+  run by AlpacaFocuserStepper instead; the simulated drive counts the steps and has a gear play
+  which the backlash compensation of the "Motion" settings takes up. The temperature drifts
+  linearly for the built-in temperature compensation.
+**************************************************************************************************/
+#pragma once
+#include "AlpacaFocuser.h"
+#include "AlpacaSim.h"
+
+// step sink of a drive with gear play; the load follows the motor once the play is taken up
+class AlpacaSimStepSink : public AlpacaStepSink
+{
+private:
+    volatile int32_t _motor = 0; // [steps]
+    volatile int32_t _load = 0;  // [steps]
+    volatile uint32_t _load_moves = 0; // steps of the load; revision of LoadPosition
+    int32_t _play = 0;           // [steps]
+
+public:
+    void Step(int8_t dir)
+    {
+        _motor = _motor + dir;
+        if (_motor - _load > _play)
+        {
+            _load = _motor - _play;
+            _load_moves = _load_moves + 1;
+        }
+        else if (_load > _motor)
+        {
+            _load = _motor;
+            _load_moves = _load_moves + 1;
+        }
+    };
+    void SetPlay(int32_t play) { _play = play > 0 ? play : 0; };
+    int32_t GetPlay() const { return _play; };
+    int32_t GetLoad() const { return _load; };
+    uint32_t GetLoadMoves() const { return _load_moves; };
+    int32_t GetMotor() const { return _motor; };
+};
+
+class AlpacaSimFocuser : public AlpacaFocuser, public AlpacaSimulator
+{
+private:
+    int32_t _max_step = 50000;
+    int32_t _max_increment = 50000;
+    double _step_size = 1.0;            // [um]
+    double _temperature = 10.0;         // mean temperature [degC]
+    double _temperature_noise = 0.2;    // noise amplitude [degC]
+    double _temperature_drift = 0.0;    // [degC/h]
+    bool _step_generator = false;
+    AlpacaFocuserStepper _stepper;
+    AlpacaSimStepSink _sink;
+
+    // driver moves without step generator
+    float _speed = 1000.0f;             // max speed [steps/s]
+    float _accel = 2000.0f;             // acceleration [steps/s^2]
+    int32_t _start_pos = 0;
+    int32_t _target_pos = 0;
+    uint32_t _start_ms = 0;
+    bool _move_published = false;       // end not yet corrected
+
+    int32_t _positionAt(uint32_t now_ms);
+
+    const bool _putHalt();
+    const bool _putMove(int32_t position);
+    const bool _getAbsolut() { return true; };
+    const bool _getIsMoving();
+    const int32_t _getPosition();
+    const int32_t _getMaxIncrement() { return _max_increment; };
+    const int32_t _getMaxStep() { return _max_step; };
+    const double _getStepSize() { return _step_size; };
+    const bool _getTempCompAvailable() { return true; };
+    const double _getTemperature();
+    const char *const _getFirmwareVersion() { return "sim"; };
+
+public:
+    AlpacaSimFocuser(int32_t max_step = 50000, float speed = 1000.0f, float accel = 2000.0f, bool step_generator = false)
+        : _max_step(max_step), _max_increment(max_step), _step_generator(step_generator), _speed(speed), _accel(accel)
+    {
+        if (_step_generator)
+        {
+            _stepper.SetConfig({speed, accel, 0, false});
+            SetStepper(&_stepper);
+        }
+        SetTempCompEngine();
+    };
+    void Begin()
+    {
+        if (_step_generator)
+            _stepper.Begin(&_sink);
+        AlpacaFocuser::Begin();
+    };
+    void Loop();
+    void AlpacaReadJson(JsonObject &root);
+    void AlpacaWriteJson(JsonObject &root);
+    void AlpacaSettingsFilter(JsonObject &filter)
+    {
+        AlpacaFocuser::AlpacaSettingsFilter(filter);
+        SimSettingsFilter(filter);
+    }
+    uint32_t AlpacaJsonRevision() { return SimJsonRevision() + _sink.GetLoadMoves(); } // sum of counters; increases with every change
+    void AlpacaWriteSchema(JsonObject &root);
+};
@@ -0,0 +1,92 @@
+/**************************************************************************************************
+  Filename:       AlpacaSimObservingConditions.cpp
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Simulated reference ObservingConditions - sensors as noisy random walks
+**************************************************************************************************/
+#include "AlpacaSimObservingConditions.h"
+
+// typical night values; star FWHM and sky brightness are not simulated
+static const double kSimSensorInit[kOcMaxSensorIdx] = {
+    20.0,   // CloudCover [%]
+    5.0,    // DewPoint [degC]
+    60.0,   // Humidity [%]
+    1013.0, // Pressure [hPa]
+    0.0,    // RainRate [mm/h]
+    0.0,    // SkyBrightness [lux]
+    20.5,   // SkyQuality [mag/arcsec^2]
+    -20.0,  // SkyTemperature [degC]
+    0.0,    // StarFwhm [arcsec]
+    12.0,   // Temperature [degC]
+    180.0,  // WindDirection [deg]
+    4.0,    // WindGust [m/s]
+    2.0     // WindSpeed [m/s]
+};
+
+AlpacaSimObservingConditions::AlpacaSimObservingConditions(uint32_t update_period_ms)
+{
+    _update_period_ms = update_period_ms;
+    for (int i = 0; i < kOcMaxSensorIdx; i++)
+        _base[i] = kSimSensorInit[i];
+}
+
+void AlpacaSimObservingConditions::Begin()
+{
+    AlpacaObservingConditions::Begin();
+    for (int i = 0; i < kOcMaxSensorIdx; i++)
+        SetSensorImplementedByIdx((OCSensorIdx_t)i, i != kOcSkyBrightnessSensorIdx && i != kOcStarFwhmSensorIdx);
+    _updateSensors();
+}
+
+void AlpacaSimObservingConditions::Loop()
+{
+    if (millis() - _last_update_ms >= _update_period_ms)
+        _updateSensors();
+}
+
+void AlpacaSimObservingConditions::_updateSensors()
+{
+    uint32_t now_ms = millis();
+    _last_update_ms = now_ms;
+    if (!SimCall())
+        return; // failed bus transaction - values become stale
+    for (int i = 0; i < kOcMaxSensorIdx; i++)
+    {
+        double scale = fabs(kSimSensorInit[i]) > 1.0 ? fabs(kSimSensorInit[i]) : 1.0;
+        _base[i] += 0.1 * _noise * scale * SimNoise();                // slow drift
+        _base[i] += 0.01 * (kSimSensorInit[i] - _base[i]);            // pulled back to the typical value
+        double value = _base[i] + _noise * scale * SimNoise();
+        if (i == kOcWindDirectionSensorIdx)
+            value = fmod(value + 360.0, 360.0);
+        else if (i == kOcCloudCoverSensorIdx || i == kOcHumiditySensorIdx)
+            value = value < 0.0 ? 0.0 : (value > 100.0 ? 100.0 : value);
+        else if (i == kOcRainRateSensorIdx || i == kOcWindGuestSensorIdx || i == kOcWindSpeedSensorIdx)
+            value = value < 0.0 ? 0.0 : value;
+        SetSensorValueByIdx((OCSensorIdx_t)i, value, now_ms);
+    }
+}
+
+void AlpacaSimObservingConditions::AlpacaReadJson(JsonObject &root)
+{
+    AlpacaObservingConditions::AlpacaReadJson(root);
+    SimReadJson(root, _patch_errors);
+    AlpacaSimObservingConditionsConfig_t config = {_update_period_ms, _noise};
+    AlpacaSettings::Read(kAlpacaSimObservingConditionsSettings, root, &config, _patch_errors);
+    _update_period_ms = config.update_period_ms;
+    _noise = config.noise;
+}
+
+void AlpacaSimObservingConditions::AlpacaWriteJson(JsonObject &root)
+{
+    AlpacaObservingConditions::AlpacaWriteJson(root);
+    SimWriteJson(root);
+    AlpacaSimObservingConditionsConfig_t config = {_update_period_ms, _noise};
+    AlpacaSettings::Write(kAlpacaSimObservingConditionsSettings, &config, root);
+}
+
+void AlpacaSimObservingConditions::AlpacaWriteSchema(JsonObject &root)
+{
+    AlpacaObservingConditions::AlpacaWriteSchema(root);
+    SimWriteSchema(root);
+    AlpacaSettings::Schema(kAlpacaSimObservingConditionsSettings, root);
+}
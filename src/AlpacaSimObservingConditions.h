@@ -0,0 +1,34 @@
+/**************************************************************************************************
+  Filename:       AlpacaSimObservingConditions.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Simulated reference ObservingConditions - sensors as noisy random walks
+**************************************************************************************************/
+#pragma once
+#include "AlpacaObservingConditions.h"
+#include "AlpacaSim.h"
+
+class AlpacaSimObservingConditions : public AlpacaObservingConditions, public AlpacaSimulator
+{
+private:
+    uint32_t _update_period_ms = 1000;  // sensor sampling period
+    uint32_t _last_update_ms = 0;
+    double _noise = 0.05;               // relative noise of each sample
+    double _base[kOcMaxSensorIdx];      // random walk state
+
+    void _updateSensors();
+
+    void _putRefreshRequest() { _updateSensors(); };
+    const bool _putAveragePeriodRequest(double average_period) { return SimCall() && average_period >= 0.0; };
+    const char *const _getFirmwareVersion() { return "sim"; };
+
+public:
+    AlpacaSimObservingConditions(uint32_t update_period_ms = 1000);
+    void Begin();
+    void Loop();
+    void AlpacaReadJson(JsonObject &root);
+    void AlpacaWriteJson(JsonObject &root);
+    void AlpacaSettingsFilter(JsonObject &filter) { SimSettingsFilter(filter); }
+    uint32_t AlpacaJsonRevision() { return SimJsonRevision(); }
+    void AlpacaWriteSchema(JsonObject &root);
+};
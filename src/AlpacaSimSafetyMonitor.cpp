@@ -0,0 +1,41 @@
+/**************************************************************************************************
+  Filename:       AlpacaSimSafetyMonitor.cpp
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Simulated reference SafetyMonitor - periodic safe/unsafe transitions
+**************************************************************************************************/
+#include "AlpacaSimSafetyMonitor.h"
+
+// a failing driver call reports unsafe, as a real monitor should
+const bool AlpacaSimSafetyMonitor::_getIsSafe()
+{
+    if (!SimCall())
+        return false;
+    if (_safe_period_ms == 0)
+        return true;
+    return (((millis() - _begin_ms) / _safe_period_ms) & 1) == 0;
+}
+
+void AlpacaSimSafetyMonitor::AlpacaReadJson(JsonObject &root)
+{
+    AlpacaSafetyMonitor::AlpacaReadJson(root);
+    SimReadJson(root, _patch_errors);
+    AlpacaSimSafetyMonitorConfig_t config = {_safe_period_ms};
+    AlpacaSettings::Read(kAlpacaSimSafetyMonitorSettings, root, &config, _patch_errors);
+    _safe_period_ms = config.safe_period_ms;
+}
+
+void AlpacaSimSafetyMonitor::AlpacaWriteJson(JsonObject &root)
+{
+    AlpacaSafetyMonitor::AlpacaWriteJson(root);
+    SimWriteJson(root);
+    AlpacaSimSafetyMonitorConfig_t config = {_safe_period_ms};
+    AlpacaSettings::Write(kAlpacaSimSafetyMonitorSettings, &config, root);
+}
+
+void AlpacaSimSafetyMonitor::AlpacaWriteSchema(JsonObject &root)
+{
+    AlpacaSafetyMonitor::AlpacaWriteSchema(root);
+    SimWriteSchema(root);
+    AlpacaSettings::Schema(kAlpacaSimSafetyMonitorSettings, root);
+}
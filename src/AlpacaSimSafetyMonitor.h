@@ -0,0 +1,32 @@
+/**************************************************************************************************
+  Filename:       AlpacaSimSafetyMonitor.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Simulated reference SafetyMonitor - periodic safe/unsafe transitions
+**************************************************************************************************/
+#pragma once
+#include "AlpacaSafetyMonitor.h"
+#include "AlpacaSim.h"
+
+class AlpacaSimSafetyMonitor : public AlpacaSafetyMonitor, public AlpacaSimulator
+{
+private:
+    uint32_t _safe_period_ms = 0;       // 0 - always safe; else safe/unsafe toggles every period
+    uint32_t _begin_ms = 0;
+
+    const bool _getIsSafe();
+    const char *const _getFirmwareVersion() { return "sim"; };
+
+public:
+    AlpacaSimSafetyMonitor(uint32_t safe_period_ms = 0) : _safe_period_ms(safe_period_ms) {};
+    void Begin()
+    {
+        _begin_ms = millis();
+        AlpacaSafetyMonitor::Begin();
+    };
+    void AlpacaReadJson(JsonObject &root);
+    void AlpacaWriteJson(JsonObject &root);
+    void AlpacaSettingsFilter(JsonObject &filter) { SimSettingsFilter(filter); }
+    uint32_t AlpacaJsonRevision() { return SimJsonRevision(); }
+    void AlpacaWriteSchema(JsonObject &root);
+};
@@ -0,0 +1,127 @@
+/**************************************************************************************************
+  Filename:       AlpacaSimSettings.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Settings tables of the simulated reference drivers (AlpacaSim*)
+
+  Free of the web server and the device classes, so the fuzz target of the settings parser
+  (test/fuzz) reads and writes the tables of the shipped simulators.
+**************************************************************************************************/
+#pragma once
+#include "AlpacaSettings.h"
+#include "AlpacaSimCore.h"
+
+// "Simulator" section of the simulated devices; latency plus jitter is clamped to kAlpacaSimMaxLatencyMs
+static constexpr AlpacaSettingField_t kAlpacaSimSettings[] = {
+    ALPACA_SETTING(AlpacaSimConfig_t, latency_ms, "Simulator", "Latency_ms", kUInt32, 0, kAlpacaSimMaxLatencyMs, false),
+    ALPACA_SETTING(AlpacaSimConfig_t, jitter_ms, "Simulator", "Jitter_ms", kUInt32, 0, kAlpacaSimMaxLatencyMs, false),
+    ALPACA_SETTING(AlpacaSimConfig_t, failure_permille, "Simulator", "Failure_permille", kUInt32, 0, 1000, false),
+    ALPACA_SETTING(AlpacaSimConfig_t, seed, "Simulator", "Seed", kUInt32, 0, 4294967295.0, false),
+};
+
+struct AlpacaSimCounters_t
+{
+    uint32_t calls;
+    uint32_t failures;
+};
+
+// read-only counters of the "Simulator" section
+static constexpr AlpacaSettingField_t kAlpacaSimCounters[] = {
+    ALPACA_SETTING(AlpacaSimCounters_t, calls, "Simulator", "Calls", kUInt32, 0, 4294967295.0, true),
+    ALPACA_SETTING(AlpacaSimCounters_t, failures, "Simulator", "Failures", kUInt32, 0, 4294967295.0, true),
+};
+
+// "Simulator" keys of the cover calibrator model
+struct AlpacaSimCoverCalibratorConfig_t
+{
+    uint32_t cover_travel_ms;
+    uint32_t warmup_ms;
+};
+
+static constexpr AlpacaSettingField_t kAlpacaSimCoverCalibratorSettings[] = {
+    ALPACA_SETTING(AlpacaSimCoverCalibratorConfig_t, cover_travel_ms, "Simulator", "CoverTravel_ms", kUInt32, 0, 600000, false),
+    ALPACA_SETTING(AlpacaSimCoverCalibratorConfig_t, warmup_ms, "Simulator", "Warmup_ms", kUInt32, 0, 600000, false),
+};
+
+// "Simulator" keys of the dome model
+struct AlpacaSimDomeConfig_t
+{
+    uint32_t travel_time_ms;   // full open <-> close travel time
+    float rotation_speed_dps;  // max rotation speed [deg/s]
+    float rotation_accel_dps2; // rotation acceleration [deg/s^2]
+};
+
+static constexpr AlpacaSettingField_t kAlpacaSimDomeSettings[] = {
+    ALPACA_SETTING(AlpacaSimDomeConfig_t, travel_time_ms, "Simulator", "TravelTime_ms", kUInt32, 100, 600000, false),
+    ALPACA_SETTING(AlpacaSimDomeConfig_t, rotation_speed_dps, "Simulator", "RotationSpeed_dps", kFloat, 0.1, 90.0, false),
+    ALPACA_SETTING(AlpacaSimDomeConfig_t, rotation_accel_dps2, "Simulator", "RotationAccel_dps2", kFloat, 0.1, 90.0, false),
+};
+
+// "Simulator" keys of the focuser model
+struct AlpacaSimFocuserConfig_t
+{
+    int32_t max_step;
+    double temperature;       // mean temperature [degC]
+    double temperature_noise; // noise amplitude [degC]
+    double temperature_drift; // [degC/h]
+};
+
+// "Simulator" keys of the motion: profile of driver moves, or play of the load with the step generator
+struct AlpacaSimFocuserMotion_t
+{
+    float speed;           // max speed [steps/s]
+    float accel;           // acceleration [steps/s^2]
+    int32_t play_steps;
+    int32_t load_position; // read-only
+};
+
+static constexpr AlpacaSettingField_t kAlpacaSimFocuserSettings[] = {
+    ALPACA_SETTING(AlpacaSimFocuserConfig_t, max_step, "Simulator", "MaxStep", kInt32, 1, 10000000, false),
+    ALPACA_SETTING(AlpacaSimFocuserConfig_t, temperature, "Simulator", "Temperature", kDouble, -50.0, 60.0, false),
+    ALPACA_SETTING(AlpacaSimFocuserConfig_t, temperature_noise, "Simulator", "TemperatureNoise", kDouble, 0.0, 10.0, false),
+    ALPACA_SETTING(AlpacaSimFocuserConfig_t, temperature_drift, "Simulator", "TemperatureDrift_degC_h", kDouble, -20.0, 20.0, false),
+};
+
+// driver moves
+static constexpr AlpacaSettingField_t kAlpacaSimFocuserProfileSettings[] = {
+    ALPACA_SETTING(AlpacaSimFocuserMotion_t, speed, "Simulator", "Speed_steps_s", kFloat, 1.0, 100000.0, false),
+    ALPACA_SETTING(AlpacaSimFocuserMotion_t, accel, "Simulator", "Accel_steps_s2", kFloat, 1.0, 1000000.0, false),
+};
+
+// step generator; LoadPosition follows Position if Motion.Backlash_steps covers the play
+static constexpr AlpacaSettingField_t kAlpacaSimFocuserLoadSettings[] = {
+    ALPACA_SETTING(AlpacaSimFocuserMotion_t, play_steps, "Simulator", "Play_steps", kInt32, 0, 10000, false),
+    ALPACA_SETTING(AlpacaSimFocuserMotion_t, load_position, "Simulator", "LoadPosition", kInt32, -2147483648.0, 2147483647.0, true),
+};
+
+// "Simulator" keys of the sensor model
+struct AlpacaSimObservingConditionsConfig_t
+{
+    uint32_t update_period_ms;
+    double noise;
+};
+
+static constexpr AlpacaSettingField_t kAlpacaSimObservingConditionsSettings[] = {
+    ALPACA_SETTING(AlpacaSimObservingConditionsConfig_t, update_period_ms, "Simulator", "UpdatePeriod_ms", kUInt32, 100, 3600000, false),
+    ALPACA_SETTING(AlpacaSimObservingConditionsConfig_t, noise, "Simulator", "Noise", kDouble, 0.0, 1.0, false),
+};
+
+// "Simulator" keys of the safety monitor model
+struct AlpacaSimSafetyMonitorConfig_t
+{
+    uint32_t safe_period_ms;
+};
+
+static constexpr AlpacaSettingField_t kAlpacaSimSafetyMonitorSettings[] = {
+    ALPACA_SETTING(AlpacaSimSafetyMonitorConfig_t, safe_period_ms, "Simulator", "SafePeriod_ms", kUInt32, 0, 86400000, false),
+};
+
+// "Simulator" keys of the switch model
+struct AlpacaSimSwitchConfig_t
+{
+    uint32_t write_latency_ms;
+};
+
+static constexpr AlpacaSettingField_t kAlpacaSimSwitchSettings[] = {
+    ALPACA_SETTING(AlpacaSimSwitchConfig_t, write_latency_ms, "Simulator", "WriteLatency_ms", kUInt32, 0, kAlpacaSimMaxLatencyMs, false),
+};
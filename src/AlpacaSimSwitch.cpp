@@ -0,0 +1,53 @@
+/**************************************************************************************************
+  Filename:       AlpacaSimSwitch.cpp
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 02 $
+  Description:    Simulated reference Switch - switch bank with write latency
+**************************************************************************************************/
+#include "AlpacaSimSwitch.h"
+
+AlpacaSimSwitch::AlpacaSimSwitch(uint32_t num_of_switch_devices, uint32_t write_latency_ms) : AlpacaSwitch(num_of_switch_devices)
+{
+    _write_latency_ms = write_latency_ms;
+
+    // first half on/off relays, second half analog outputs 0,...,255
+    for (uint32_t id = 0; id < num_of_switch_devices; id++)
+    {
+        InitSwitchCanWrite(id, true);
+        if (id >= num_of_switch_devices / 2)
+        {
+            InitSwitchMaxValue(id, 255.0);
+            InitSwitchStep(id, 1.0);
+        }
+    }
+}
+
+// the write latency counts into the clamped latency of the call
+const bool AlpacaSimSwitch::_writeSwitchValue(uint32_t id, double value)
+{
+    return SimCall(_write_latency_ms);
+}
+
+void AlpacaSimSwitch::AlpacaReadJson(JsonObject &root)
+{
+    AlpacaSwitch::AlpacaReadJson(root);
+    SimReadJson(root, _patch_errors);
+    AlpacaSimSwitchConfig_t config = {_write_latency_ms};
+    AlpacaSettings::Read(kAlpacaSimSwitchSettings, root, &config, _patch_errors);
+    _write_latency_ms = config.write_latency_ms;
+}
+
+void AlpacaSimSwitch::AlpacaWriteJson(JsonObject &root)
+{
+    AlpacaSwitch::AlpacaWriteJson(root);
+    SimWriteJson(root);
+    AlpacaSimSwitchConfig_t config = {_write_latency_ms};
+    AlpacaSettings::Write(kAlpacaSimSwitchSettings, &config, root);
+}
+
+void AlpacaSimSwitch::AlpacaWriteSchema(JsonObject &root)
+{
+    AlpacaSwitch::AlpacaWriteSchema(root);
+    SimWriteSchema(root);
+    AlpacaSettings::Schema(kAlpacaSimSwitchSettings, root);
+}
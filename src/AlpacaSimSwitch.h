@@ -0,0 +1,27 @@
+/**************************************************************************************************
+  Filename:       AlpacaSimSwitch.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Simulated reference Switch - switch bank with write latency
+**************************************************************************************************/
+#pragma once
+#include "AlpacaSwitch.h"
+#include "AlpacaSim.h"
+
+class AlpacaSimSwitch : public AlpacaSwitch, public AlpacaSimulator
+{
+private:
+    uint32_t _write_latency_ms = 20;    // relay/bus write time, added to the common latency
+
+    const bool _writeSwitchValue(uint32_t id, double value);
+    const char *const _getFirmwareVersion() { return "sim"; };
+
+public:
+    AlpacaSimSwitch(uint32_t num_of_switch_devices = 8, uint32_t write_latency_ms = 20);
+    void Begin() { AlpacaSwitch::Begin(); };
+    void AlpacaReadJson(JsonObject &root);
+    void AlpacaWriteJson(JsonObject &root);
+    void AlpacaSettingsFilter(JsonObject &filter) { SimSettingsFilter(filter); }
+    uint32_t AlpacaJsonRevision() { return SimJsonRevision(); }
+    void AlpacaWriteSchema(JsonObject &root);
+};
@@ -14,7 +14,7 @@ AlpacaSwitch::AlpacaSwitch(uint32_t num_of_switch_devices)
     _max_switch_devices = num_of_switch_devices;
 
     strlcpy(_device_type, ALPACA_SWITCH_DEVICE_TYPE, sizeof(_device_type));
-    strlcpy(_device_description, ALPACA_SWITCH_DESCRIPTION, sizeof(_device_description));
+    strlcpy(_general.description, ALPACA_SWITCH_DESCRIPTION, sizeof(_general.description));
     strlcpy(_driver_info, ALPACA_SWITCH_DRIVER_INFO, sizeof(_driver_info));
     strlcpy(_device_and_driver_version, esp32_alpaca_device_library_version, sizeof(_device_and_driver_version));
     _device_interface_version = ALPACA_SWITCH_INTERFACE_VERSION;
@@ -425,4 +425,13 @@ const bool AlpacaSwitch::SetSwitchName(uint32_t id, char *name)
         return true;
     }
     return false;
-};
\ No newline at end of file
+};
+
+// state for the events of AlpacaServer
+void AlpacaSwitch::AlpacaWriteState(JsonObject &root)
+{
+    AlpacaDevice::AlpacaWriteState(root);
+    JsonArray values = root["SwitchValue"].to<JsonArray>();
+    for (uint32_t id = 0; id < _max_switch_devices; id++)
+        values.add(GetSwitchValue(id));
+}
@@ -87,4 +87,5 @@ protected:
     const bool SetSwitchName(uint32_t id, char *name);
 
 public:
+    void AlpacaWriteState(JsonObject &root);
 };
\ No newline at end of file
@@ -0,0 +1,191 @@
+/**************************************************************************************************
+  Filename:       fuzz_parse.cpp
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 02 $
+  Description:    libFuzzer target of the parsers of network input
+
+  One input is tried as query parameter value (AlpacaParse numbers), as UDP discovery packet, as
+  JSON body of a setup POST/PATCH and as settings file (MessagePack with load filter); parsed
+  objects are read into the shipped settings tables of the server and of the simulators, written
+  back and read again. Without libFuzzer (ALPACA_FUZZ_REPLAY) main() replays the files and
+  directories given as arguments.
+**************************************************************************************************/
+#include <string>
+#include "AlpacaParse.h"
+#include "AlpacaSettings.h"
+#include "AlpacaServerSettings.h"
+#include "AlpacaSimSettings.h"
+
+struct FuzzTable_t
+{
+    const AlpacaSettingField_t *fields;
+    size_t n;
+    size_t size; // of the settings struct
+};
+
+#define FUZZ_TABLE(table, struct_t) {table, sizeof(table) / sizeof(table[0]), sizeof(struct_t)}
+
+static const FuzzTable_t kFuzzTables[] = {
+    FUZZ_TABLE(kAlpacaServerSettings, AlpacaServerSettings_t),
+    FUZZ_TABLE(kAlpacaSimSettings, AlpacaSimConfig_t),
+    FUZZ_TABLE(kAlpacaSimCounters, AlpacaSimCounters_t),
+    FUZZ_TABLE(kAlpacaSimCoverCalibratorSettings, AlpacaSimCoverCalibratorConfig_t),
+    FUZZ_TABLE(kAlpacaSimDomeSettings, AlpacaSimDomeConfig_t),
+    FUZZ_TABLE(kAlpacaSimFocuserSettings, AlpacaSimFocuserConfig_t),
+    FUZZ_TABLE(kAlpacaSimFocuserProfileSettings, AlpacaSimFocuserMotion_t),
+    FUZZ_TABLE(kAlpacaSimFocuserLoadSettings, AlpacaSimFocuserMotion_t),
+    FUZZ_TABLE(kAlpacaSimObservingConditionsSettings, AlpacaSimObservingConditionsConfig_t),
+    FUZZ_TABLE(kAlpacaSimSafetyMonitorSettings, AlpacaSimSafetyMonitorConfig_t),
+    FUZZ_TABLE(kAlpacaSimSwitchSettings, AlpacaSimSwitchConfig_t),
+};
+
+static const size_t kFuzzMaxSettingsSize = 256;
+
+// valid settings: every number at the bound next to 0, every string of min length
+static void _defaults(const FuzzTable_t &table, uint8_t *settings)
+{
+    if (table.size > kFuzzMaxSettingsSize)
+        abort();
+    memset(settings, 0, table.size);
+    for (size_t i = 0; i < table.n; i++)
+    {
+        const AlpacaSettingField_t &field = table.fields[i];
+        uint8_t *member = settings + field.offset;
+        double d = constrain(0.0, field.min, field.max);
+        switch (field.type)
+        {
+        case AlpacaSettingType_t::kBool:
+            *(bool *)member = false;
+            break;
+        case AlpacaSettingType_t::kUInt16:
+            *(uint16_t *)member = (uint16_t)d;
+            break;
+        case AlpacaSettingType_t::kInt32:
+            *(int32_t *)member = (int32_t)d;
+            break;
+        case AlpacaSettingType_t::kUInt32:
+            *(uint32_t *)member = (uint32_t)d;
+            break;
+        case AlpacaSettingType_t::kFloat:
+            *(float *)member = (float)d;
+            break;
+        case AlpacaSettingType_t::kDouble:
+            *(double *)member = d;
+            break;
+        case AlpacaSettingType_t::kString:
+            memset(member, 'x', (size_t)field.min);
+            member[(size_t)field.min] = '\0';
+            break;
+        }
+    }
+}
+
+static void _readSettings(const FuzzTable_t &table, JsonObject root)
+{
+    uint8_t settings[kFuzzMaxSettingsSize];
+    _defaults(table, settings);
+    JsonDocument rsp;
+    JsonObject errors = rsp.to<JsonObject>();
+    AlpacaSettings::Read(table.fields, table.n, root, settings, errors);
+    AlpacaSettings::Restore(table.fields, table.n, root, settings);
+
+    // written values are valid and read back without errors and unchanged
+    JsonDocument doc;
+    JsonObject written = doc.to<JsonObject>();
+    AlpacaSettings::Write(table.fields, table.n, settings, written);
+    uint8_t again[kFuzzMaxSettingsSize];
+    memcpy(again, settings, table.size);
+    if (AlpacaSettings::Read(table.fields, table.n, written, again, JsonObject()) != 0)
+        abort();
+    if (AlpacaSettings::Restore(table.fields, table.n, written, again) != 0)
+        abort();
+    if (memcmp(again, settings, table.size) != 0)
+        abort();
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    std::string str((const char *)data, size); // query parameter values are NUL terminated
+    double d = 0.0;
+    float f = 0.0f;
+    int32_t i = 0;
+    uint32_t u = 0;
+    if (AlpacaParse::Double(str.c_str(), d) && !isfinite(d))
+        abort();
+    if (AlpacaParse::Float(str.c_str(), f) && !isfinite(f))
+        abort();
+    AlpacaParse::Int32(str.c_str(), i);
+    AlpacaParse::UInt32(str.c_str(), u);
+
+    // discovery packet; the reply is sent for exactly the header followed by the version byte
+    const size_t header_len = sizeof(kAlpacaDiscoveryHeader) - 1;
+    bool discovery = size > header_len && memcmp(data, kAlpacaDiscoveryHeader, header_len) == 0;
+    uint8_t version = 0;
+    if (AlpacaParse::Discovery(data, size, version) != discovery || (discovery && version != data[header_len]))
+        abort();
+
+    // setup POST/PATCH body
+    JsonDocument doc;
+    if (!AlpacaParse::Json(doc, data, size))
+    {
+        for (const FuzzTable_t &table : kFuzzTables)
+            _readSettings(table, doc.as<JsonObject>());
+    }
+
+    // settings file section of each table
+    for (const FuzzTable_t &table : kFuzzTables)
+    {
+        JsonDocument filter_doc;
+        JsonObject filter = filter_doc.to<JsonObject>();
+        AlpacaSettings::Filter(table.fields, table.n, filter, true);
+        JsonDocument file_doc;
+        if (!deserializeMsgPack(file_doc, data, size, DeserializationOption::Filter(filter), DeserializationOption::NestingLimit(kAlpacaJsonNestingLimit)))
+            _readSettings(table, file_doc.as<JsonObject>());
+    }
+    return 0;
+}
+
+#ifdef ALPACA_FUZZ_REPLAY
+#include <dirent.h>
+#include <sys/stat.h>
+#include <vector>
+
+static int _replay(const std::string &path)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+    {
+        fprintf(stderr, "%s not found\n", path.c_str());
+        return 1;
+    }
+    if (S_ISDIR(st.st_mode))
+    {
+        int rc = 0;
+        DIR *dir = opendir(path.c_str());
+        for (struct dirent *entry; dir != nullptr && (entry = readdir(dir)) != nullptr;)
+        {
+            if (entry->d_name[0] != '.')
+                rc |= _replay(path + "/" + entry->d_name);
+        }
+        if (dir != nullptr)
+            closedir(dir);
+        return rc;
+    }
+    FILE *file = fopen(path.c_str(), "rb");
+    std::vector<uint8_t> data(st.st_size);
+    size_t n = file != nullptr ? fread(data.data(), 1, data.size(), file) : 0;
+    if (file != nullptr)
+        fclose(file);
+    LLVMFuzzerTestOneInput(data.data(), n);
+    printf("%s: %zu bytes\n", path.c_str(), n);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int rc = 0;
+    for (int i = 1; i < argc; i++)
+        rc |= _replay(argv[i]);
+    return rc;
+}
+#endif
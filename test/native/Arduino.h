@@ -0,0 +1,74 @@
+/**************************************************************************************************
+  Filename:       Arduino.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Host shim of the Arduino core for the native tests and the fuzz target
+
+  Only what the host built modules of src/ use. Time is simulated: it stands still until a test
+  advances it with delay() or native::Run() of esp_timer.h, which also runs the due timers.
+**************************************************************************************************/
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <functional>
+#include "freertos_shim.h"
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+using std::max;
+using std::min;
+
+#define IRAM_ATTR
+#define PROGMEM
+#define LOW 0x0
+#define HIGH 0x1
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define CHANGE 0x03
+#define FALLING 0x02
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+namespace native
+{
+    inline int64_t &Now() // [us]
+    {
+        static int64_t now_us = 0;
+        return now_us;
+    }
+}
+
+inline unsigned long millis() { return (unsigned long)(native::Now() / 1000); }
+inline unsigned long micros() { return (unsigned long)native::Now(); }
+inline void delay(unsigned long ms) { native::Now() += (int64_t)ms * 1000; }
+inline void delayMicroseconds(uint32_t us) {} // pulse widths; the simulated time stands still
+inline bool psramFound() { return false; }
+
+// pins are not simulated; drivers of the tests use EncoderStep() and sinks instead of pins
+inline void pinMode(uint8_t pin, uint8_t mode) {}
+inline void digitalWrite(uint8_t pin, uint8_t val) {}
+inline int digitalRead(uint8_t pin) { return LOW; }
+inline int digitalPinToInterrupt(uint8_t pin) { return pin; }
+inline void attachInterruptArg(uint8_t pin, void (*isr)(void *), void *arg, int mode) {}
+
+#if defined(__GLIBC__) && __GLIBC__ == 2 && __GLIBC_MINOR__ < 38
+inline size_t strlcpy(char *dst, const char *src, size_t size)
+{
+    size_t len = strlen(src);
+    if (size > 0)
+    {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#endif
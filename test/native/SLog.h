@@ -0,0 +1,28 @@
+/**************************************************************************************************
+  Filename:       SLog.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Host shim of SLog; messages of level warning and above go to stderr
+**************************************************************************************************/
+#pragma once
+#include <stdio.h>
+
+#define SLOG_EMERGENCY 0
+#define SLOG_ALERT 1
+#define SLOG_CRITICAL 2
+#define SLOG_ERROR 3
+#define SLOG_WARNING 4
+#define SLOG_NOTICE 5
+#define SLOG_INFO 6
+#define SLOG_DEBUG 7
+
+#define SLOG_PRINTF(lvl, ...)              \
+    {                                      \
+        if ((lvl) <= SLOG_WARNING)         \
+            fprintf(stderr, __VA_ARGS__);  \
+    }
+#define SLOG_ERROR_PRINTF(...) SLOG_PRINTF(SLOG_ERROR, __VA_ARGS__)
+#define SLOG_WARNING_PRINTF(...) SLOG_PRINTF(SLOG_WARNING, __VA_ARGS__)
+#define SLOG_NOTICE_PRINTF(...) SLOG_PRINTF(SLOG_NOTICE, __VA_ARGS__)
+#define SLOG_INFO_PRINTF(...) SLOG_PRINTF(SLOG_INFO, __VA_ARGS__)
+#define SLOG_DEBUG_PRINTF(...) SLOG_PRINTF(SLOG_DEBUG, __VA_ARGS__)
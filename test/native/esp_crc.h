@@ -0,0 +1,21 @@
+/**************************************************************************************************
+  Filename:       esp_crc.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Host shim of the ROM CRC functions for the native tests
+**************************************************************************************************/
+#pragma once
+#include <stdint.h>
+
+// CRC-32/ISO-HDLC like the ROM: crc is the result of the previous block, 0 to start
+inline uint32_t esp_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    crc = ~crc;
+    for (uint32_t i = 0; i < len; i++)
+    {
+        crc ^= buf[i];
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+    return ~crc;
+}
@@ -0,0 +1,15 @@
+/**************************************************************************************************
+  Filename:       esp_heap_caps.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Host shim of the capability based heap for the native tests; plain malloc()
+**************************************************************************************************/
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+
+inline void *heap_caps_malloc(size_t size, uint32_t caps) { return malloc(size); }
+inline void heap_caps_free(void *ptr) { free(ptr); }
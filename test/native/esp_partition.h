@@ -0,0 +1,134 @@
+/**************************************************************************************************
+  Filename:       esp_partition.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Host shim of esp_partition for the native tests - one data partition in RAM
+
+  native::AddPartition() creates the partition, erased. Writes behave like NOR flash: they only
+  clear bits, an erase sets a whole range to 0xff. native::CutPowerAfter(n) simulates a reset:
+  after n more programmed bytes every write and erase fails without a change, and the write that
+  crosses the limit is truncated there.
+**************************************************************************************************/
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+#include "esp_err.h"
+
+typedef enum
+{
+    ESP_PARTITION_TYPE_APP = 0x00,
+    ESP_PARTITION_TYPE_DATA = 0x01
+} esp_partition_type_t;
+
+typedef int esp_partition_subtype_t;
+
+typedef struct
+{
+    esp_partition_type_t type;
+    esp_partition_subtype_t subtype;
+    uint32_t address;
+    uint32_t size;
+    char label[17];
+} esp_partition_t;
+
+namespace native
+{
+    struct Partition
+    {
+        esp_partition_t info;
+        std::vector<uint8_t> data;
+    };
+
+    inline std::vector<Partition *> &Partitions()
+    {
+        static std::vector<Partition *> partitions;
+        return partitions;
+    }
+
+    inline int64_t &PowerBudget() // programmed bytes until the power cut; < 0 - no cut
+    {
+        static int64_t budget = -1;
+        return budget;
+    }
+
+    inline uint64_t &ProgrammedBytes() // since the start of the test program
+    {
+        static uint64_t bytes = 0;
+        return bytes;
+    }
+
+    inline Partition *AddPartition(const char *label, esp_partition_subtype_t subtype, uint32_t size)
+    {
+        Partition *partition = new Partition{{ESP_PARTITION_TYPE_DATA, subtype, 0, size, {0}}, std::vector<uint8_t>(size, 0xff)};
+        strncpy(partition->info.label, label, sizeof(partition->info.label) - 1);
+        Partitions().push_back(partition);
+        return partition;
+    }
+
+    inline void ResetPartitions()
+    {
+        for (Partition *partition : Partitions())
+            delete partition;
+        Partitions().clear();
+        PowerBudget() = -1;
+    }
+
+    inline void CutPowerAfter(int64_t bytes) { PowerBudget() = bytes; }
+    inline void RestorePower() { PowerBudget() = -1; }
+
+    inline Partition *FindPartition(const esp_partition_t *info)
+    {
+        for (Partition *partition : Partitions())
+            if (&partition->info == info)
+                return partition;
+        return nullptr;
+    }
+}
+
+inline const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char *label)
+{
+    for (native::Partition *partition : native::Partitions())
+    {
+        if (partition->info.type == type && partition->info.subtype == subtype && (label == nullptr || strcmp(label, partition->info.label) == 0))
+            return &partition->info;
+    }
+    return nullptr;
+}
+
+inline esp_err_t esp_partition_read(const esp_partition_t *info, size_t offset, void *dst, size_t size)
+{
+    native::Partition *partition = native::FindPartition(info);
+    if (partition == nullptr || offset + size > info->size)
+        return ESP_ERR_INVALID_ARG;
+    memcpy(dst, &partition->data[offset], size);
+    return ESP_OK;
+}
+
+inline esp_err_t esp_partition_write(const esp_partition_t *info, size_t offset, const void *src, size_t size)
+{
+    native::Partition *partition = native::FindPartition(info);
+    if (partition == nullptr || offset + size > info->size)
+        return ESP_ERR_INVALID_ARG;
+    size_t n = size;
+    if (native::PowerBudget() >= 0 && (int64_t)n > native::PowerBudget())
+        n = (size_t)native::PowerBudget();
+    for (size_t i = 0; i < n; i++)
+        partition->data[offset + i] &= ((const uint8_t *)src)[i];
+    native::ProgrammedBytes() += n;
+    if (native::PowerBudget() >= 0)
+        native::PowerBudget() -= (int64_t)n;
+    return n == size ? ESP_OK : ESP_FAIL;
+}
+
+inline esp_err_t esp_partition_erase_range(const esp_partition_t *info, size_t offset, size_t size)
+{
+    native::Partition *partition = native::FindPartition(info);
+    if (partition == nullptr || offset + size > info->size)
+        return ESP_ERR_INVALID_ARG;
+    if (native::PowerBudget() == 0)
+        return ESP_FAIL;
+    memset(&partition->data[offset], 0xff, size);
+    return ESP_OK;
+}
@@ -0,0 +1,120 @@
+/**************************************************************************************************
+  Filename:       esp_timer.h
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Host shim of esp_timer for the native tests
+
+  Timers run in simulated time: native::Run() advances the clock of Arduino.h and calls every timer
+  callback at its due time, in time order. native::ResetTimers() deletes all timers, e.g. in
+  tearDown() before the objects owning them are destroyed.
+**************************************************************************************************/
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include "Arduino.h"
+#include "esp_err.h"
+
+typedef void (*esp_timer_cb_t)(void *arg);
+
+typedef enum
+{
+    ESP_TIMER_TASK,
+    ESP_TIMER_ISR
+} esp_timer_dispatch_t;
+
+typedef struct
+{
+    esp_timer_cb_t callback;
+    void *arg;
+    esp_timer_dispatch_t dispatch_method;
+    const char *name;
+    bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+struct esp_timer
+{
+    esp_timer_cb_t callback;
+    void *arg;
+    int64_t period_us; // 0: one-shot
+    int64_t due_us;
+    bool armed;
+};
+typedef struct esp_timer *esp_timer_handle_t;
+
+namespace native
+{
+    inline std::vector<esp_timer_handle_t> &Timers()
+    {
+        static std::vector<esp_timer_handle_t> timers;
+        return timers;
+    }
+
+    // advance the time by duration_us; due timers are called at their due time
+    inline void Run(int64_t duration_us)
+    {
+        int64_t end_us = Now() + duration_us;
+        for (;;)
+        {
+            esp_timer_handle_t next = nullptr;
+            for (esp_timer_handle_t timer : Timers())
+            {
+                if (timer->armed && timer->due_us <= end_us && (next == nullptr || timer->due_us < next->due_us))
+                    next = timer;
+            }
+            if (next == nullptr)
+                break;
+            if (next->due_us > Now())
+                Now() = next->due_us;
+            if (next->period_us > 0)
+                next->due_us += next->period_us;
+            else
+                next->armed = false;
+            next->callback(next->arg);
+        }
+        Now() = end_us;
+    }
+
+    inline void ResetTimers()
+    {
+        for (esp_timer_handle_t timer : Timers())
+            delete timer;
+        Timers().clear();
+    }
+}
+
+inline int64_t esp_timer_get_time() { return native::Now(); }
+
+inline esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *handle)
+{
+    *handle = new esp_timer{args->callback, args->arg, 0, 0, false};
+    native::Timers().push_back(*handle);
+    return ESP_OK;
+}
+
+inline esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+    if (timer->armed)
+        return ESP_ERR_INVALID_STATE;
+    timer->period_us = (int64_t)period_us;
+    timer->due_us = native::Now() + (int64_t)period_us;
+    timer->armed = true;
+    return ESP_OK;
+}
+
+inline esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    if (timer->armed)
+        return ESP_ERR_INVALID_STATE;
+    timer->period_us = 0;
+    timer->due_us = native::Now() + (int64_t)timeout_us;
+    timer->armed = true;
+    return ESP_OK;
+}
+
+inline esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (!timer->armed)
+        return ESP_ERR_INVALID_STATE;
+    timer->armed = false;
+    return ESP_OK;
+}
@@ -0,0 +1,147 @@
+/**************************************************************************************************
+  Filename:       test_main.cpp
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Host test of AlpacaDomeRotator with the simulated motor of AlpacaSimDome
+
+  pio test -e native -f test_dome_rotator
+  The control tick runs from the esp_timer shim in simulated time.
+**************************************************************************************************/
+#include <unity.h>
+#include "AlpacaSimDomeMotor.h"
+
+static const int32_t kCountsPerRev = 3600;
+static const double kToleranceDeg = 0.5;
+
+static AlpacaDomeRotator *rotator = nullptr;
+static AlpacaSimDomeMotor *motor = nullptr;
+
+// motor that never moves the encoder
+class StuckMotor : public AlpacaDomeMotor
+{
+public:
+    void Drive(float speed) {};
+};
+
+void setUp()
+{
+    rotator = new AlpacaDomeRotator();
+    motor = new AlpacaSimDomeMotor(*rotator, kCountsPerRev, 5.0f, 2.0f);
+    rotator->Begin(motor, kCountsPerRev);
+}
+
+void tearDown()
+{
+    native::ResetTimers();
+    delete motor;
+    delete rotator;
+}
+
+// run the control loop until the rotator is at rest; false after max_ms
+static bool runUntilIdle(uint32_t max_ms, double *min_azimuth = nullptr, double *max_azimuth = nullptr)
+{
+    for (uint32_t ms = 0; ms < max_ms; ms += 10)
+    {
+        native::Run(10000);
+        rotator->Loop();
+        double azimuth = rotator->GetAzimuth();
+        if (min_azimuth != nullptr)
+            *min_azimuth = min(*min_azimuth, azimuth);
+        if (max_azimuth != nullptr)
+            *max_azimuth = max(*max_azimuth, azimuth);
+        if (!rotator->IsSlewing())
+            return true;
+    }
+    return false;
+}
+
+void test_sync()
+{
+    rotator->Sync(123.4);
+    TEST_ASSERT_DOUBLE_WITHIN(0.1, 123.4, rotator->GetAzimuth());
+    rotator->Sync(-10.0);
+    TEST_ASSERT_DOUBLE_WITHIN(0.1, 350.0, rotator->GetAzimuth());
+}
+
+void test_slew_shortest_path_across_zero()
+{
+    double min_azimuth = 360.0;
+    double max_azimuth = 0.0;
+    rotator->Sync(350.0);
+    rotator->SlewTo(10.0);
+    TEST_ASSERT_TRUE(rotator->IsSlewing());
+    TEST_ASSERT_TRUE(runUntilIdle(60000, &min_azimuth, &max_azimuth));
+    TEST_ASSERT_EQUAL(AlpacaDomeRotatorMode_t::kIdle, rotator->GetMode());
+    TEST_ASSERT_TRUE(rotator->AtAzimuth(10.0));
+    // through 0, never the long way round
+    TEST_ASSERT_TRUE(min_azimuth < 1.0);
+    TEST_ASSERT_TRUE(max_azimuth > 359.0);
+    TEST_ASSERT_TRUE(rotator->GetAzimuth() < 10.0 + kToleranceDeg || rotator->GetAzimuth() > 350.0);
+}
+
+void test_slew_decelerates_before_target()
+{
+    rotator->Sync(0.0);
+    rotator->SlewTo(90.0);
+    float max_velocity = 0.0f;
+    float velocity_near_target = 0.0f;
+    for (int i = 0; i < 6000 && rotator->IsSlewing(); i++)
+    {
+        native::Run(10000);
+        float velocity = rotator->GetVelocity();
+        max_velocity = max(max_velocity, velocity);
+        if (fabs(rotator->GetAzimuth() - 90.0) < 1.0 && velocity_near_target == 0.0f)
+            velocity_near_target = velocity;
+    }
+    TEST_ASSERT_FALSE(rotator->IsSlewing());
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 5.0f, max_velocity); // estimate of whole counts per tick
+    TEST_ASSERT_TRUE(velocity_near_target < max_velocity / 2.0f); // braking is limited by the motor acceleration
+    TEST_ASSERT_DOUBLE_WITHIN(kToleranceDeg, 90.0, rotator->GetAzimuth());
+}
+
+void test_find_home()
+{
+    AlpacaDomeRotatorConfig_t config = rotator->GetConfig();
+    config.home_azimuth = 45.0;
+    rotator->SetConfig(config);
+    rotator->Sync(200.0); // wrong guess; the sensor corrects it
+    TEST_ASSERT_FALSE(rotator->IsHomed());
+    rotator->FindHome();
+    TEST_ASSERT_TRUE(runUntilIdle(120000));
+    TEST_ASSERT_TRUE(rotator->IsHomed());
+    TEST_ASSERT_DOUBLE_WITHIN(kToleranceDeg, 45.0, rotator->GetAzimuth());
+}
+
+void test_stall_is_a_fault()
+{
+    StuckMotor stuck;
+    native::ResetTimers();
+    AlpacaDomeRotator stuck_rotator;
+    stuck_rotator.Begin(&stuck, kCountsPerRev);
+    stuck_rotator.SlewTo(90.0);
+    native::Run((int64_t)kAlpacaDomeRotatorStallUs + 100000);
+    TEST_ASSERT_EQUAL(AlpacaDomeRotatorMode_t::kFault, stuck_rotator.GetMode());
+    stuck_rotator.Loop(); // logged from the loop task, not from the tick
+    native::ResetTimers();
+}
+
+void test_tick_within_jitter_budget()
+{
+    AlpacaDomeRotatorStats_t stats;
+    native::Run(1000000);
+    rotator->GetStats(stats);
+    TEST_ASSERT_EQUAL_UINT32(1000000 / kAlpacaDomeRotatorPeriodUs, stats.ticks);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.ticks_over_budget);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_sync);
+    RUN_TEST(test_slew_shortest_path_across_zero);
+    RUN_TEST(test_slew_decelerates_before_target);
+    RUN_TEST(test_find_home);
+    RUN_TEST(test_stall_is_a_fault);
+    RUN_TEST(test_tick_within_jitter_budget);
+    return UNITY_END();
+}
@@ -0,0 +1,170 @@
+/**************************************************************************************************
+  Filename:       test_main.cpp
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Host test and benchmark of the fixed point solver of AlpacaDomeSlaving
+
+  pio test -e native -f test_dome_slaving -v
+  The fixed point solve is compared with the double precision solve over the sky above the horizon
+  for typical geometries and for the corners of the "Slaving" setting ranges (overflow check). The
+  cost per solve is printed; on the target it is exported by /metrics.
+**************************************************************************************************/
+#include <unity.h>
+#include <chrono>
+#include "AlpacaDomeSlaving.h"
+
+struct Geometry_t
+{
+    const char *name;
+    AlpacaDomeSlavingConfig_t config;
+    double max_error_deg;  // anywhere above the horizon
+    double mean_error_deg;
+};
+
+static const Geometry_t kGeometries[] = {
+    {"centered fork", {48.0, 2500, 0, 0, 0, 0, 3.0}, 0.02, 0.005},
+    {"offset GEM", {48.0, 2500, 300, -400, 600, 350, 3.0}, 0.05, 0.005},
+    {"southern GEM", {-33.9, 1800, -200, 250, 400, -300, 3.0}, 0.05, 0.005},
+    {"equator", {0.0, 3000, 0, 500, 200, 400, 3.0}, 0.05, 0.005},
+    {"pole", {89.0, 3000, 100, 100, 300, 400, 3.0}, 0.05, 0.005},
+    {"largest dome", {30.0, 20000, 10000, -10000, 10000, 5000, 3.0}, 0.05, 0.005},
+    {"largest offsets", {-60.0, 20000, -10000, 10000, -10000, -5000, 3.0}, 0.05, 0.005},
+    {"smallest dome", {50.0, 500, 0, 0, 0, 300, 3.0}, 0.1, 0.005}, // slit close to the zenith of the dome
+};
+
+static double _azimuthError(uint16_t azimuth, double reference_deg)
+{
+    double error = fabs(AlpacaFixedTrig::ToDeg(azimuth) - reference_deg);
+    return error > 180.0 ? 360.0 - error : error;
+}
+
+static double _altitude(double ha_deg, double dec_deg, double latitude_deg)
+{
+    double ha = ha_deg * M_PI / 180.0;
+    double dec = dec_deg * M_PI / 180.0;
+    double lat = latitude_deg * M_PI / 180.0;
+    return asin(sin(lat) * sin(dec) + cos(lat) * cos(dec) * cos(ha)) * 180.0 / M_PI;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_fixed_trig()
+{
+    AlpacaFixedTrig::Init();
+    double max_sin = 0.0;
+    for (uint32_t angle = 0; angle < 0x10000; angle++)
+        max_sin = max(max_sin, fabs((double)AlpacaFixedTrig::Sin((uint16_t)angle) / AlpacaFixedTrig::kOne - sin(angle * 2.0 * M_PI / 65536.0)));
+    TEST_ASSERT_TRUE(max_sin < 1.0e-6);
+
+    double max_atan = 0.0;
+    for (int i = 0; i < 3600; i++)
+    {
+        double a = i * 0.1 * M_PI / 180.0;
+        for (double r : {1.0e3, 1.0e6, 1.0e9})
+        {
+            uint16_t angle = AlpacaFixedTrig::Atan2((int64_t)llround(r * sin(a)), (int64_t)llround(r * cos(a)));
+            max_atan = max(max_atan, _azimuthError(angle, i * 0.1));
+        }
+    }
+    TEST_ASSERT_TRUE(max_atan < 0.1);
+    max_atan = 0.0;
+    for (int i = 0; i < 3600; i++)
+    {
+        double a = i * 0.1 * M_PI / 180.0;
+        uint16_t angle = AlpacaFixedTrig::Atan2((int64_t)llround(1.0e6 * sin(a)), (int64_t)llround(1.0e6 * cos(a)));
+        max_atan = max(max_atan, _azimuthError(angle, i * 0.1));
+    }
+    TEST_ASSERT_TRUE(max_atan < 0.01);
+
+    for (uint64_t x : {0ULL, 1ULL, 2ULL, 1000000ULL, 0xFFFFFFFFULL, 0x3FFFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFFFULL})
+    {
+        uint64_t root = AlpacaFixedTrig::Sqrt(x);
+        TEST_ASSERT_TRUE((unsigned __int128)root * root <= x);
+        TEST_ASSERT_TRUE((unsigned __int128)(root + 1) * (root + 1) > x);
+    }
+}
+
+// whole sky above the horizon in 2 deg steps, both sides of the pier
+void test_solver_accuracy()
+{
+    for (const Geometry_t &geometry : kGeometries)
+    {
+        AlpacaDomeSlaving slaving;
+        slaving.SetConfig(geometry.config);
+        double max_error = 0.0;
+        double sum_error = 0.0;
+        uint32_t n = 0;
+        for (int ha = -180; ha < 180; ha += 2)
+        {
+            for (int dec = -90; dec <= 90; dec += 2)
+            {
+                double altitude = _altitude(ha, dec, geometry.config.latitude_deg);
+                if (altitude < 0.0 || altitude > 89.9) // at the zenith the azimuth of a centered mount is undefined
+                    continue;
+                for (AlpacaPierSide_t pier : {AlpacaPierSide_t::kEast, AlpacaPierSide_t::kWest})
+                {
+                    uint16_t ha_fixed = AlpacaFixedTrig::FromDeg(ha);
+                    uint16_t dec_fixed = AlpacaFixedTrig::FromDeg(dec);
+                    double reference = slaving.SolveReference(AlpacaFixedTrig::ToDeg(ha_fixed), AlpacaFixedTrig::ToDeg(dec_fixed), pier);
+                    double error = _azimuthError(slaving.Solve(ha_fixed, dec_fixed, pier), reference);
+                    max_error = max(max_error, error);
+                    sum_error += error;
+                    n++;
+                }
+            }
+        }
+        char message[128];
+        snprintf(message, sizeof(message), "%s: max %.4f deg, mean %.5f deg over %u solves", geometry.name, max_error, sum_error / n, n);
+        TEST_MESSAGE(message);
+        TEST_ASSERT_TRUE_MESSAGE(max_error < geometry.max_error_deg, message);
+        TEST_ASSERT_TRUE_MESSAGE(sum_error / n < geometry.mean_error_deg, message);
+    }
+}
+
+void test_solver_cost()
+{
+    AlpacaDomeSlaving slaving;
+    slaving.SetConfig(kGeometries[1].config);
+    const uint32_t n = 1000000;
+    uint32_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < n; i++)
+        sum += slaving.Solve((uint16_t)(i * 7), (uint16_t)(i * 3 & 0x3FFF), AlpacaPierSide_t::kUnknown);
+    double solve_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / n;
+
+    start = std::chrono::steady_clock::now();
+    double sum_reference = 0.0;
+    for (uint32_t i = 0; i < n; i++)
+        sum_reference += slaving.SolveReference(AlpacaFixedTrig::ToDeg((uint16_t)(i * 7)), AlpacaFixedTrig::ToDeg((uint16_t)(i * 3 & 0x3FFF)), AlpacaPierSide_t::kUnknown);
+    double reference_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / n;
+
+    char message[128];
+    snprintf(message, sizeof(message), "fixed point %.1f ns/solve, double %.1f ns/solve (checksum %u %.0f)", solve_ns, reference_ns, sum, sum_reference);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE_MESSAGE(solve_ns < 10000.0, message); // far below the update period on any host
+}
+
+void test_update_tracks_sidereal_rate()
+{
+    AlpacaDomeSlaving slaving;
+    uint16_t azimuth = 0;
+    TEST_ASSERT_FALSE(slaving.Update(azimuth));
+    slaving.SetConfig(kGeometries[0].config);
+    slaving.SetPointingHaDec(-2.0, 20.0, AlpacaPierSide_t::kUnknown, true);
+    TEST_ASSERT_TRUE(slaving.Update(azimuth));
+    TEST_ASSERT_DOUBLE_WITHIN(0.05, slaving.SolveReference(-30.0, 20.0, AlpacaPierSide_t::kUnknown), AlpacaFixedTrig::ToDeg(azimuth));
+    delay(3600000); // one hour later the target is at HA -1h
+    TEST_ASSERT_TRUE(slaving.Update(azimuth));
+    TEST_ASSERT_DOUBLE_WITHIN(0.1, slaving.SolveReference(-15.0 + 3600.0 * 15.0 * (1.0 / 0.99726957 - 1.0) / 3600.0, 20.0, AlpacaPierSide_t::kUnknown), AlpacaFixedTrig::ToDeg(azimuth));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_fixed_trig);
+    RUN_TEST(test_solver_accuracy);
+    RUN_TEST(test_solver_cost);
+    RUN_TEST(test_update_tracks_sidereal_rate);
+    return UNITY_END();
+}
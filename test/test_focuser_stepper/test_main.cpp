@@ -0,0 +1,176 @@
+/**************************************************************************************************
+  Filename:       test_main.cpp
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Host test of the ramp generator of AlpacaFocuserStepper
+
+  pio test -e native -f test_focuser_stepper
+  The step timer runs from the esp_timer shim in simulated time; a sink records every step.
+**************************************************************************************************/
+#include <unity.h>
+#include <vector>
+#include "AlpacaFocuserStepper.h"
+
+static const AlpacaFocuserStepperConfig_t kTrapezoid = {1000.0f, 2000.0f, 0, false}; // ramp of 250 steps in 0.5 s
+
+// step times and directions as seen by the driver
+class RecordingSink : public AlpacaStepSink
+{
+public:
+    std::vector<int64_t> time_us;
+    int32_t position = 0; // incl. the backlash steps
+    uint32_t reversals = 0;
+    int8_t dir = 0;
+
+    void Step(int8_t step_dir)
+    {
+        if (dir != 0 && step_dir != dir)
+            reversals++;
+        dir = step_dir;
+        position += step_dir;
+        time_us.push_back(esp_timer_get_time());
+    }
+    uint32_t Interval(size_t n) const { return (uint32_t)(time_us[n + 1] - time_us[n]); }
+};
+
+static AlpacaFocuserStepper *stepper = nullptr;
+static RecordingSink *sink = nullptr;
+
+void setUp()
+{
+    stepper = new AlpacaFocuserStepper();
+    sink = new RecordingSink();
+    stepper->SetConfig(kTrapezoid);
+    stepper->Begin(sink);
+}
+
+void tearDown()
+{
+    native::ResetTimers();
+    delete sink;
+    delete stepper;
+}
+
+// run the step timer until the move ends; false after max_ms
+static bool runUntilIdle(uint32_t max_ms)
+{
+    for (uint32_t ms = 0; ms < max_ms && stepper->IsMoving(); ms++)
+        native::Run(1000);
+    return !stepper->IsMoving();
+}
+
+void test_move_without_timer_fails()
+{
+    AlpacaFocuserStepper idle;
+    TEST_ASSERT_FALSE(idle.MoveTo(100));
+    TEST_ASSERT_FALSE(idle.IsMoving());
+}
+
+void test_move_reaches_target()
+{
+    TEST_ASSERT_TRUE(stepper->MoveTo(1000));
+    TEST_ASSERT_TRUE(stepper->IsMoving());
+    TEST_ASSERT_TRUE(runUntilIdle(5000));
+    TEST_ASSERT_EQUAL_INT32(1000, stepper->GetPosition());
+    TEST_ASSERT_EQUAL_INT32(1000, sink->position);
+    TEST_ASSERT_EQUAL_UINT32(1000, sink->time_us.size());
+    TEST_ASSERT_EQUAL_UINT32(0, sink->reversals);
+}
+
+// s(t) = a t^2 / 2 on the ramp, 1 / speed when cruising, the ramp reversed at the end
+void test_trapezoid_profile()
+{
+    stepper->MoveTo(1000);
+    TEST_ASSERT_TRUE(runUntilIdle(5000));
+    const std::vector<int64_t> &t = sink->time_us;
+    for (uint32_t n = 10; n <= 250; n += 40)
+    {
+        double expected_us = (sqrt(2.0 * n / kTrapezoid.accel) - sqrt(2.0 / kTrapezoid.accel)) * 1000000.0;
+        TEST_ASSERT_DOUBLE_WITHIN(n * 1.0, expected_us, (double)(t[n] - t[1]));
+    }
+    for (size_t n = 1; n < 250; n++)
+        TEST_ASSERT_TRUE(sink->Interval(n) <= sink->Interval(n - 1));
+    for (size_t n = 260; n < 740; n++)
+        TEST_ASSERT_EQUAL_UINT32(1000, sink->Interval(n));
+    for (size_t n = 750; n < 998; n++)
+        TEST_ASSERT_TRUE(sink->Interval(n + 1) >= sink->Interval(n));
+    // decelerating takes as long as accelerating
+    TEST_ASSERT_DOUBLE_WITHIN(0.01 * (t[250] - t[0]), (double)(t[250] - t[0]), (double)(t[999] - t[749]));
+}
+
+// no jerk at the start: the S-curve starts slower than the trapezoid and ends the ramp at the same speed
+void test_s_curve_profile()
+{
+    AlpacaFocuserStepperConfig_t config = kTrapezoid;
+    config.s_curve = true;
+    stepper->SetConfig(config);
+    stepper->MoveTo(1000);
+    TEST_ASSERT_TRUE(runUntilIdle(5000));
+    TEST_ASSERT_EQUAL_INT32(1000, stepper->GetPosition());
+    uint32_t trapezoid_us = (uint32_t)((sqrt(2.0 * 2 / kTrapezoid.accel) - sqrt(2.0 / kTrapezoid.accel)) * 1000000.0);
+    TEST_ASSERT_TRUE(sink->Interval(1) > trapezoid_us * 5 / 4);
+    for (size_t n = 1; n < 250; n++)
+        TEST_ASSERT_TRUE(sink->Interval(n) <= sink->Interval(n - 1));
+    TEST_ASSERT_UINT32_WITHIN(20, 1000, sink->Interval(249));
+    // the mean acceleration is the configured one: the ramp takes speed / accel
+    TEST_ASSERT_DOUBLE_WITHIN(20000.0, 500000.0, (double)(sink->time_us[250] - sink->time_us[0]));
+}
+
+void test_halt_decelerates()
+{
+    stepper->MoveTo(5000);
+    native::Run(1000000); // cruising
+    int32_t position = stepper->GetPosition();
+    stepper->Halt();
+    TEST_ASSERT_TRUE(runUntilIdle(5000));
+    int32_t braking = stepper->GetPosition() - position;
+    TEST_ASSERT_TRUE(braking > 200 && braking <= 251);
+    TEST_ASSERT_EQUAL_INT32(stepper->GetPosition(), stepper->GetTarget());
+    TEST_ASSERT_EQUAL_UINT32(0, sink->reversals);
+}
+
+// new target behind the move: decelerated stop, reversal, backlash taken up off the position count
+void test_reversal_with_backlash()
+{
+    AlpacaFocuserStepperConfig_t config = kTrapezoid;
+    config.backlash = 30;
+    stepper->SetConfig(config);
+    stepper->MoveTo(2000);
+    native::Run(1000000);
+    TEST_ASSERT_TRUE(stepper->GetPosition() > 500);
+    stepper->MoveTo(200);
+    TEST_ASSERT_TRUE(runUntilIdle(10000));
+    TEST_ASSERT_EQUAL_INT32(200, stepper->GetPosition());
+    TEST_ASSERT_EQUAL_UINT32(1, sink->reversals);
+    TEST_ASSERT_EQUAL_INT32(200 - config.backlash, sink->position);
+    // the same direction again takes up no backlash
+    uint32_t steps = sink->time_us.size();
+    stepper->MoveTo(100);
+    TEST_ASSERT_TRUE(runUntilIdle(5000));
+    TEST_ASSERT_EQUAL_UINT32(steps + 100, sink->time_us.size());
+}
+
+void test_stats()
+{
+    AlpacaFocuserStepperStats_t stats;
+    stepper->MoveTo(1000);
+    TEST_ASSERT_TRUE(runUntilIdle(5000));
+    stepper->GetStats(stats);
+    TEST_ASSERT_EQUAL_UINT32(1000, stats.steps);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.steps_late); // simulated timers are never late
+    TEST_ASSERT_EQUAL_UINT32(0, stats.jitter_max_us);
+    TEST_ASSERT_UINT32_WITHIN(10, 1000, stats.rate_max_hz);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_move_without_timer_fails);
+    RUN_TEST(test_move_reaches_target);
+    RUN_TEST(test_trapezoid_profile);
+    RUN_TEST(test_s_curve_profile);
+    RUN_TEST(test_halt_decelerates);
+    RUN_TEST(test_reversal_with_backlash);
+    RUN_TEST(test_stats);
+    return UNITY_END();
+}
@@ -0,0 +1,202 @@
+/**************************************************************************************************
+  Filename:       test_main.cpp
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Host benchmark of the step timer of AlpacaFocuserStepper
+
+  pio test -e native -f test_focuser_stepper_timing -v
+  - cost of one timer callback, measured with the wall clock around every call, and the step rate
+    the callback alone could sustain
+  - a move in real time: a timer thread calls the callback at its due time (busy wait, as the
+    esp_timer task would) and records how late each step starts, without and with load threads
+    competing for the CPU like a busy loop()
+  The real AlpacaStepDirSink is used; pins are no-ops of the shim. Numbers are printed, not
+  checked, since they depend on the host and its scheduler, which is not FreeRTOS; only the cost
+  of the callback has to fit into the shortest step interval. During a real time run the stepper
+  is used by the timer thread only.
+**************************************************************************************************/
+#include <unity.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "AlpacaFocuserStepper.h"
+
+// fastest speed the step generator allows; ramp of 250 steps
+static const AlpacaFocuserStepperConfig_t kFastest = {1000000.0f / kAlpacaFocuserStepMinIntervalUs, 200000.0f, 0, false};
+static const int32_t kCostSteps = 200000;
+static const int32_t kWallSteps = 20000;
+
+void setUp() { native::Now() = 0; }
+void tearDown() { native::ResetTimers(); }
+
+static int64_t wallNs() { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+
+struct Summary_t
+{
+    double mean;
+    uint32_t p50;
+    uint32_t p99;
+    uint32_t max;
+};
+
+static Summary_t summarize(std::vector<uint32_t> values)
+{
+    Summary_t summary = {0.0, 0, 0, 0};
+    if (values.empty())
+        return summary;
+    std::sort(values.begin(), values.end());
+    double sum = 0.0;
+    for (uint32_t value : values)
+        sum += value;
+    summary.mean = sum / values.size();
+    summary.p50 = values[values.size() / 2];
+    summary.p99 = values[values.size() * 99 / 100];
+    summary.max = values.back();
+    return summary;
+}
+
+// the timer callback of the stepper wrapped by a wall clock measurement
+struct Timed_t
+{
+    esp_timer_cb_t callback;
+    void *arg;
+    std::vector<uint32_t> ns;
+};
+
+static void timedCallback(void *arg)
+{
+    Timed_t *timed = (Timed_t *)arg;
+    int64_t start_ns = wallNs();
+    timed->callback(timed->arg);
+    timed->ns.push_back((uint32_t)(wallNs() - start_ns));
+}
+
+// cost per step of the callback in simulated time; ramp and cruise, both profiles
+void test_callback_cost()
+{
+    for (int s_curve = 0; s_curve < 2; s_curve++)
+    {
+        AlpacaStepDirSink sink(1, 2);
+        AlpacaFocuserStepper stepper;
+        AlpacaFocuserStepperConfig_t config = kFastest;
+        config.s_curve = s_curve != 0;
+        stepper.SetConfig(config);
+        TEST_ASSERT_TRUE(stepper.Begin(&sink));
+        esp_timer_handle_t timer = native::Timers().back();
+        Timed_t timed = {timer->callback, timer->arg, {}};
+        timed.ns.reserve(kCostSteps);
+        timer->callback = timedCallback;
+        timer->arg = &timed;
+
+        TEST_ASSERT_TRUE(stepper.MoveTo(kCostSteps));
+        while (stepper.IsMoving())
+            native::Run(100000);
+        TEST_ASSERT_EQUAL_INT32(kCostSteps, stepper.GetPosition());
+        TEST_ASSERT_EQUAL_UINT32(kCostSteps, timed.ns.size());
+
+        Summary_t cost = summarize(timed.ns);
+        printf("%-10s callback %7.1f ns mean %6u ns p50 %6u ns p99 %8u ns max; sustainable %.0f steps/s (p99)\n",
+               s_curve ? "S-curve" : "trapezoid", cost.mean, cost.p50, cost.p99, cost.max, 1e9 / max(cost.p99, (uint32_t)1));
+        TEST_ASSERT_LESS_THAN_UINT32(kAlpacaFocuserStepMinIntervalUs * 1000, cost.p50);
+        native::ResetTimers();
+    }
+}
+
+struct WallRun_t
+{
+    std::vector<uint32_t> late_us; // start of each step behind its due time
+    std::vector<int64_t> step_us;  // start of each step
+    AlpacaFocuserStepperStats_t stats;
+    int32_t position;
+    double seconds;
+};
+
+// move of kWallSteps in real time while load_threads spin
+static WallRun_t runWallClock(unsigned load_threads)
+{
+    AlpacaStepDirSink sink(1, 2);
+    AlpacaFocuserStepper stepper;
+    stepper.SetConfig(kFastest);
+    TEST_ASSERT_TRUE(stepper.Begin(&sink));
+    esp_timer_handle_t timer = native::Timers().back();
+    WallRun_t run;
+    run.late_us.reserve(kWallSteps);
+    run.step_us.reserve(kWallSteps);
+
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> load;
+    for (unsigned i = 0; i < load_threads; i++)
+    {
+        load.emplace_back([&stop]()
+                          {
+                              std::vector<double> buffer(64 * 1024, 1.0);
+                              for (size_t n = 0; !stop.load(std::memory_order_relaxed); n++)
+                                  buffer[(n * 4099) % buffer.size()] = sqrt(buffer[n % buffer.size()] + 1.0); });
+    }
+
+    int64_t start_ns = wallNs();
+    native::Now() = 0; // simulated time is the wall time since start_ns
+    TEST_ASSERT_TRUE(stepper.MoveTo(kWallSteps));
+    std::thread timer_task([&]()
+                           {
+                               while (stepper.IsMoving())
+                               {
+                                   int64_t now_us = (wallNs() - start_ns) / 1000;
+                                   if (!timer->armed || now_us < timer->due_us)
+                                       continue;
+                                   native::Now() = now_us;
+                                   run.late_us.push_back((uint32_t)(now_us - timer->due_us));
+                                   run.step_us.push_back(now_us);
+                                   timer->armed = false;
+                                   timer->callback(timer->arg);
+                               } });
+    timer_task.join();
+    run.seconds = (wallNs() - start_ns) / 1e9;
+    stop = true;
+    for (std::thread &thread : load)
+        thread.join();
+
+    stepper.GetStats(run.stats);
+    run.position = stepper.GetPosition();
+    native::ResetTimers();
+    return run;
+}
+
+static void report(const char *name, const WallRun_t &run)
+{
+    Summary_t late = summarize(run.late_us);
+    // cruise: between the acceleration and the deceleration ramp
+    size_t first = 300, last = run.step_us.size() - 300;
+    double cruise_hz = (last - first) * 1e6 / (double)(run.step_us[last] - run.step_us[first]);
+    printf("%-9s %u steps in %.2f s, cruise %.0f of %.0f steps/s; late %.1f us mean %u us p99 %u us max, %u steps > %u us\n",
+           name, (unsigned)run.stats.steps, run.seconds, cruise_hz, kFastest.speed, late.mean, late.p99, late.max,
+           (unsigned)run.stats.steps_late, kAlpacaFocuserStepJitterBudgetUs);
+}
+
+void test_wall_clock_unloaded()
+{
+    WallRun_t run = runWallClock(0);
+    TEST_ASSERT_EQUAL_INT32(kWallSteps, run.position);
+    TEST_ASSERT_EQUAL_UINT32(kWallSteps, run.stats.steps);
+    report("unloaded", run);
+}
+
+// at least one load thread more than cores, so the timer thread is preempted
+void test_wall_clock_loaded()
+{
+    unsigned threads = std::thread::hardware_concurrency();
+    WallRun_t run = runWallClock(threads > 0 ? threads : 1);
+    TEST_ASSERT_EQUAL_INT32(kWallSteps, run.position);
+    TEST_ASSERT_EQUAL_UINT32(kWallSteps, run.stats.steps);
+    report("loaded", run);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_callback_cost);
+    RUN_TEST(test_wall_clock_unloaded);
+    RUN_TEST(test_wall_clock_loaded);
+    return UNITY_END();
+}
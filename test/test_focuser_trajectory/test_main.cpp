@@ -0,0 +1,142 @@
+/**************************************************************************************************
+  Filename:       test_main.cpp
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Host test of the move prediction of AlpacaFocuserTrajectory
+
+  pio test -e native -f test_focuser_trajectory
+  Moves are published at the simulated time of the Arduino shim and evaluated with delay().
+**************************************************************************************************/
+#include <unity.h>
+#include "AlpacaFocuserTrajectory.h"
+
+static const float kSpeed = 1000.0f; // ramp of 0.5 s and 250 steps
+static const float kAccel = 2000.0f;
+
+static AlpacaFocuserTrajectory *trajectory = nullptr;
+
+void setUp()
+{
+    trajectory = new AlpacaFocuserTrajectory();
+}
+
+void tearDown()
+{
+    delete trajectory;
+}
+
+// position after ms from the last estimate; moving and overdue are checked by the caller
+static int32_t estimateAfter(uint32_t ms, bool &moving, bool &overdue)
+{
+    int32_t position = 0;
+    delay(ms);
+    TEST_ASSERT_TRUE(trajectory->Estimate(position, moving, overdue));
+    return position;
+}
+
+void test_nothing_published()
+{
+    int32_t position = 0;
+    bool moving = false;
+    bool overdue = false;
+    TEST_ASSERT_FALSE(trajectory->Estimate(position, moving, overdue));
+}
+
+// s = a t^2 / 2 on the ramps, v t when cruising: 0.5 s ramp, 0.5 s cruise, 0.5 s ramp
+void test_trapezoid()
+{
+    bool moving = false;
+    bool overdue = false;
+    trajectory->Publish(1000, 2000, kSpeed, kAccel, false);
+    TEST_ASSERT_EQUAL_INT32(1000, estimateAfter(0, moving, overdue));
+    TEST_ASSERT_TRUE(moving);
+    TEST_ASSERT_INT32_WITHIN(1, 1063, estimateAfter(250, moving, overdue));
+    TEST_ASSERT_INT32_WITHIN(1, 1250, estimateAfter(250, moving, overdue));
+    TEST_ASSERT_INT32_WITHIN(1, 1750, estimateAfter(500, moving, overdue));
+    TEST_ASSERT_INT32_WITHIN(1, 1938, estimateAfter(250, moving, overdue));
+    TEST_ASSERT_FALSE(overdue);
+    TEST_ASSERT_EQUAL_INT32(2000, estimateAfter(260, moving, overdue));
+    TEST_ASSERT_TRUE(moving); // until the driver confirms the end
+    TEST_ASSERT_TRUE(overdue);
+}
+
+// short moves do not reach the speed: v = sqrt(a d)
+void test_triangle_inward()
+{
+    bool moving = false;
+    bool overdue = false;
+    trajectory->Publish(500, 400, kSpeed, kAccel, false); // 0.224 s ramps
+    TEST_ASSERT_INT32_WITHIN(1, 450, estimateAfter(224, moving, overdue));
+    TEST_ASSERT_FALSE(overdue);
+    TEST_ASSERT_EQUAL_INT32(400, estimateAfter(230, moving, overdue));
+    TEST_ASSERT_TRUE(overdue);
+}
+
+// s(T / 2) = v / 2 (T / 2 - T / pi) on the S-curve ramp
+void test_s_curve()
+{
+    bool moving = false;
+    bool overdue = false;
+    trajectory->Publish(0, 1000, kSpeed, kAccel, true);
+    TEST_ASSERT_INT32_WITHIN(1, 45, estimateAfter(250, moving, overdue));
+    TEST_ASSERT_INT32_WITHIN(1, 250, estimateAfter(250, moving, overdue));
+}
+
+// the end correction hands the position back to the driver
+void test_end_correction()
+{
+    int32_t position = 0;
+    bool moving = false;
+    bool overdue = false;
+    trajectory->Publish(0, 100, kSpeed, kAccel, false);
+    delay(1000);
+    trajectory->Correct(101, false);
+    TEST_ASSERT_FALSE(trajectory->Estimate(position, moving, overdue));
+    // a move to the current position ends at once
+    trajectory->Publish(101, 101, kSpeed, kAccel, false);
+    TEST_ASSERT_FALSE(trajectory->Estimate(position, moving, overdue));
+}
+
+// an encoder offset during the move is blended out until the target
+void test_correction_while_moving()
+{
+    bool moving = false;
+    bool overdue = false;
+    trajectory->Publish(0, 1000, kSpeed, kAccel, false);
+    delay(500);
+    trajectory->Correct(270, true); // 20 steps ahead of the profile
+    TEST_ASSERT_INT32_WITHIN(1, 270, estimateAfter(0, moving, overdue));
+    int32_t position = estimateAfter(250, moving, overdue); // profile 500
+    TEST_ASSERT_TRUE(position > 500 && position < 520);
+    TEST_ASSERT_INT32_WITHIN(2, 1000, estimateAfter(749, moving, overdue));
+    TEST_ASSERT_EQUAL_INT32(1000, estimateAfter(10, moving, overdue));
+}
+
+void test_expire_is_overdue()
+{
+    bool moving = false;
+    bool overdue = false;
+    trajectory->Publish(0, 1000, kSpeed, kAccel, false);
+    estimateAfter(100, moving, overdue);
+    TEST_ASSERT_FALSE(overdue);
+    trajectory->Expire();
+    estimateAfter(0, moving, overdue);
+    TEST_ASSERT_TRUE(moving);
+    TEST_ASSERT_TRUE(overdue);
+    trajectory->Clear();
+    int32_t position = 0;
+    TEST_ASSERT_FALSE(trajectory->Estimate(position, moving, overdue));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_nothing_published);
+    RUN_TEST(test_trapezoid);
+    RUN_TEST(test_triangle_inward);
+    RUN_TEST(test_s_curve);
+    RUN_TEST(test_end_correction);
+    RUN_TEST(test_correction_while_moving);
+    RUN_TEST(test_expire_is_overdue);
+    return UNITY_END();
+}
@@ -0,0 +1,181 @@
+/**************************************************************************************************
+  Filename:       test_main.cpp
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Host test of AlpacaPositionJournal - recovery after a power cut at every byte
+
+  pio test -e native -f test_position_journal
+  The journal partition of the esp_partition shim has two sectors, so a few hundred writes wrap
+  it. The power cut test truncates the write sequence at every programmed byte in turn, reboots
+  and checks that every key recovers its latest completed value or the one being written.
+**************************************************************************************************/
+#include <unity.h>
+#include <map>
+#include "AlpacaPositionJournal.h"
+
+static const uint32_t kSectors = 2;
+static const uint32_t kScenarioWrites = 600;
+
+static const uint16_t kKeyFocuser = AlpacaPositionJournal::Key(AlpacaPositionJournalKind_t::kFocuserPosition, 0);
+static const uint16_t kKeyDome = AlpacaPositionJournal::Key(AlpacaPositionJournalKind_t::kDomeAzimuth, 0);
+static const uint16_t kKeyFocuser1 = AlpacaPositionJournal::Key(AlpacaPositionJournalKind_t::kFocuserPosition, 1);
+
+static AlpacaPositionJournal *journal = nullptr;
+
+// new journal on the same flash, like after a reset
+static void reboot()
+{
+    delete journal;
+    journal = new AlpacaPositionJournal();
+    TEST_ASSERT_TRUE(journal->Begin());
+}
+
+void setUp()
+{
+    native::AddPartition(kAlpacaJournalPartitionLabel, kAlpacaJournalPartitionSubtype, kSectors * 4096);
+    journal = nullptr;
+    reboot();
+}
+
+void tearDown()
+{
+    delete journal;
+    journal = nullptr;
+    native::ResetPartitions();
+}
+
+static void assertValue(uint16_t key, int32_t expected, uint16_t expected_flags = 0)
+{
+    int32_t value = 0;
+    uint16_t flags = 0;
+    TEST_ASSERT_TRUE(journal->Read(key, value, flags));
+    TEST_ASSERT_EQUAL_INT32(expected, value);
+    TEST_ASSERT_EQUAL_UINT16(expected_flags, flags);
+}
+
+void test_disabled_without_partition()
+{
+    native::ResetPartitions();
+    AlpacaPositionJournal none;
+    TEST_ASSERT_FALSE(none.Begin());
+    TEST_ASSERT_FALSE(none.Write(kKeyFocuser, 1));
+}
+
+void test_values_over_reset()
+{
+    TEST_ASSERT_TRUE(journal->Write(kKeyFocuser, 1234));
+    TEST_ASSERT_TRUE(journal->Write(kKeyDome, 18000, 0x01));
+    TEST_ASSERT_TRUE(journal->Write(kKeyFocuser, -5));
+    reboot();
+    assertValue(kKeyFocuser, -5);
+    assertValue(kKeyDome, 18000, 0x01);
+    int32_t value = 0;
+    uint16_t flags = 0;
+    TEST_ASSERT_FALSE(journal->Read(kKeyFocuser1, value, flags));
+}
+
+void test_unchanged_value_not_written()
+{
+    TEST_ASSERT_TRUE(journal->Write(kKeyFocuser, 100));
+    uint64_t bytes = native::ProgrammedBytes();
+    TEST_ASSERT_TRUE(journal->Write(kKeyFocuser, 100));
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)(native::ProgrammedBytes() - bytes));
+    TEST_ASSERT_TRUE(journal->Write(kKeyFocuser, 100, 0x01)); // flags are part of the value
+    TEST_ASSERT_EQUAL_UINT32(sizeof(AlpacaPositionJournalRecord_t), (uint32_t)(native::ProgrammedBytes() - bytes));
+}
+
+// the sector switch carries every key over, so erasing the oldest sector loses nothing
+void test_wrap_keeps_every_key()
+{
+    AlpacaPositionJournalStats_t stats;
+    TEST_ASSERT_TRUE(journal->Write(kKeyFocuser1, 77));
+    TEST_ASSERT_TRUE(journal->Write(kKeyDome, 9000));
+    for (int32_t i = 0; i < 2000; i++)
+        TEST_ASSERT_TRUE(journal->Write(kKeyFocuser, i));
+    journal->GetStats(stats);
+    TEST_ASSERT_TRUE(stats.erases >= 2000 / (4096 / sizeof(AlpacaPositionJournalRecord_t)));
+    reboot();
+    assertValue(kKeyFocuser, 1999);
+    assertValue(kKeyFocuser1, 77);
+    assertValue(kKeyDome, 9000);
+    journal->GetStats(stats);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.torn);
+}
+
+// the focuser moves often, the dome now and then, a second focuser once; stops at the first failed
+// write like a reset would
+struct Scenario
+{
+    std::map<uint16_t, int32_t> committed;
+    bool cut = false;
+    uint16_t cut_key = 0;
+    int32_t cut_value = 0;
+
+    void Run()
+    {
+        for (int32_t i = 0; i < (int32_t)kScenarioWrites; i++)
+        {
+            uint16_t key = i == 0 ? kKeyFocuser1 : (i % 7 == 0 ? kKeyDome : kKeyFocuser);
+            if (!journal->Write(key, i))
+            {
+                cut = true;
+                cut_key = key;
+                cut_value = i;
+                return;
+            }
+            committed[key] = i;
+        }
+    }
+};
+
+void test_power_cut_at_every_byte()
+{
+    Scenario full;
+    uint64_t start = native::ProgrammedBytes();
+    full.Run();
+    TEST_ASSERT_FALSE(full.cut);
+    uint32_t total = (uint32_t)(native::ProgrammedBytes() - start);
+    TEST_ASSERT_TRUE(total > kSectors * 4096); // wraps the partition
+
+    for (uint32_t cut = 0; cut < total; cut++)
+    {
+        native::ResetPartitions();
+        native::AddPartition(kAlpacaJournalPartitionLabel, kAlpacaJournalPartitionSubtype, kSectors * 4096);
+        reboot();
+        native::CutPowerAfter(cut);
+        Scenario scenario;
+        scenario.Run();
+        TEST_ASSERT_TRUE(scenario.cut);
+        native::RestorePower();
+        reboot();
+
+        for (uint16_t key : {kKeyFocuser, kKeyDome, kKeyFocuser1})
+        {
+            int32_t value = 0;
+            uint16_t flags = 0;
+            bool found = journal->Read(key, value, flags);
+            bool committed = scenario.committed.count(key) > 0;
+            if (found && key == scenario.cut_key && value == scenario.cut_value)
+                continue; // the record being written was complete
+            TEST_ASSERT_EQUAL(committed, found);
+            if (committed)
+                TEST_ASSERT_EQUAL_INT32(scenario.committed[key], value);
+        }
+
+        // the journal goes on after the recovery
+        TEST_ASSERT_TRUE(journal->Write(kKeyFocuser, -1));
+        reboot();
+        assertValue(kKeyFocuser, -1);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_disabled_without_partition);
+    RUN_TEST(test_values_over_reset);
+    RUN_TEST(test_unchanged_value_not_written);
+    RUN_TEST(test_wrap_keeps_every_key);
+    RUN_TEST(test_power_cut_at_every_byte);
+    return UNITY_END();
+}
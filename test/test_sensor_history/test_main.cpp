@@ -0,0 +1,194 @@
+/**************************************************************************************************
+  Filename:       test_main.cpp
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Host test of AlpacaSensorHistory - codec round trip and gapless streaming
+
+  pio test -e native -f test_sensor_history
+  Every sample is encoded after a reference sample and decoded again; times and the float bits
+  must come back unchanged and take the bits of the documented code.
+**************************************************************************************************/
+#include <unity.h>
+#include <vector>
+#include "AlpacaSensorHistory.h"
+
+static const uint32_t kBlockBits = sizeof(((AlpacaSensorHistoryBlock_t *)nullptr)->data) * 8;
+
+void setUp() {}
+void tearDown() {}
+
+static float floatOf(uint32_t bits)
+{
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static uint32_t bitsOf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// one sample after the reference state; returns the encoded bits
+static uint32_t roundTrip(const AlpacaSensorHistoryCodec_t &reference, uint32_t time_ms, float value)
+{
+    uint8_t data[16] = {0};
+    AlpacaSensorHistoryCodec_t encoder = reference;
+    AlpacaSensorHistoryCodec_t decoder = reference;
+    uint32_t n = AlpacaSensorHistory::Encode(data, 0, sizeof(data) * 8, encoder, time_ms, value);
+    TEST_ASSERT_TRUE(n > 0);
+    uint32_t decoded_ms = 0;
+    float decoded = 0.0f;
+    TEST_ASSERT_EQUAL_UINT32(n, AlpacaSensorHistory::Decode(data, 0, decoder, decoded_ms, decoded));
+    TEST_ASSERT_EQUAL_UINT32(time_ms, decoded_ms);
+    TEST_ASSERT_EQUAL_HEX32(bitsOf(value), bitsOf(decoded));
+    TEST_ASSERT_EQUAL_INT32(encoder.delta_ms, decoder.delta_ms);
+    TEST_ASSERT_EQUAL_UINT8(encoder.leading, decoder.leading);
+    TEST_ASSERT_EQUAL_UINT8(encoder.trailing, decoder.trailing);
+    return n;
+}
+
+// previous sample at 10 s, 1 s before the one before; the value is unchanged: 1 bit
+void test_dod_ranges()
+{
+    const AlpacaSensorHistoryCodec_t reference = {10000, 1000, bitsOf(12.5f), 0xFF, 0};
+    const struct
+    {
+        int32_t dod;
+        uint32_t bits;
+    } cases[] = {
+        {0, 1},
+        {-1, 9}, {-63, 9}, {64, 9},
+        {-64, 12}, {65, 12}, {-255, 12}, {256, 12},
+        {-256, 16}, {257, 16}, {-2047, 16}, {2048, 16},
+        {-2048, 36}, {2049, 36}, {-999, 16}, {-1000, 16}, {3600000, 36}, {-3600000, 36},
+    };
+    for (const auto &c : cases)
+    {
+        uint32_t time_ms = (uint32_t)(10000 + 1000 + c.dod);
+        TEST_ASSERT_EQUAL_UINT32(c.bits + 1, roundTrip(reference, time_ms, 12.5f));
+    }
+}
+
+void test_xor_windows()
+{
+    const uint32_t value = 0x41480000; // 12.5f
+    AlpacaSensorHistoryCodec_t reference = {10000, 1000, value, 0xFF, 0};
+    // zero xor
+    TEST_ASSERT_EQUAL_UINT32(1 + 1, roundTrip(reference, 11000, floatOf(value)));
+    // new window without a previous one: '11', 5 bits leading, 5 bits length - 1, 3 meaningful bits
+    TEST_ASSERT_EQUAL_UINT32(1 + 2 + 5 + 5 + 3, roundTrip(reference, 11000, floatOf(value ^ 0x00070000)));
+    // within the previous window: '10' and its 12 bits
+    reference.leading = 8;
+    reference.trailing = 12;
+    TEST_ASSERT_EQUAL_UINT32(1 + 2 + 12, roundTrip(reference, 11000, floatOf(value ^ 0x00070000)));
+    TEST_ASSERT_EQUAL_UINT32(1 + 2 + 12, roundTrip(reference, 11000, floatOf(value ^ 0x00801000)));
+    // outside of it at either end: a new window
+    TEST_ASSERT_EQUAL_UINT32(1 + 2 + 5 + 5 + 1, roundTrip(reference, 11000, floatOf(value ^ 0x01000000)));
+    TEST_ASSERT_EQUAL_UINT32(1 + 2 + 5 + 5 + 1, roundTrip(reference, 11000, floatOf(value ^ 0x00000800)));
+    // all 32 bits meaningful, e.g. a sign change
+    reference.leading = 0xFF;
+    TEST_ASSERT_EQUAL_UINT32(1 + 2 + 5 + 5 + 32, roundTrip(reference, 11000, floatOf(value ^ 0x80000001)));
+    reference.leading = 0;
+    reference.trailing = 0;
+    TEST_ASSERT_EQUAL_UINT32(1 + 2 + 32, roundTrip(reference, 11000, floatOf(value ^ 0x80000001)));
+}
+
+// a sample that does not fit changes neither the block nor the codec
+void test_encode_full_block()
+{
+    uint8_t data[8] = {0};
+    AlpacaSensorHistoryCodec_t codec = {10000, 1000, bitsOf(1.0f), 0xFF, 0};
+    AlpacaSensorHistoryCodec_t before = codec;
+    TEST_ASSERT_EQUAL_UINT32(0, AlpacaSensorHistory::Encode(data, 50, 64, codec, 11000, -3.75f));
+    TEST_ASSERT_EQUAL_UINT32(before.time_ms, codec.time_ms);
+    TEST_ASSERT_EQUAL_UINT32(before.value, codec.value);
+    for (uint8_t byte : data)
+        TEST_ASSERT_EQUAL_UINT8(0, byte);
+}
+
+// a block full of irregular samples decodes back in sequence
+void test_block_round_trip()
+{
+    AlpacaSensorHistoryBlock_t block = {};
+    uint32_t time_ms = 5000;
+    float value = 15.0f;
+    AlpacaSensorHistoryCodec_t encoder = {time_ms, 0, bitsOf(value), 0xFF, 0};
+    std::vector<uint32_t> times;
+    std::vector<float> values;
+    uint32_t bits = 0;
+    for (uint32_t i = 1;; i++)
+    {
+        time_ms += 1000 + (i % 5 == 0 ? 37 : 0) + (i % 17 == 0 ? 5000 : 0);
+        value = (i % 11 == 0) ? value : value + 0.01f * (float)((int32_t)(i * 7919 % 13) - 6);
+        uint32_t n = AlpacaSensorHistory::Encode(block.data, bits, kBlockBits, encoder, time_ms, value);
+        if (n == 0)
+            break;
+        bits += n;
+        times.push_back(time_ms);
+        values.push_back(value);
+    }
+    TEST_ASSERT_TRUE(times.size() > 20);
+
+    AlpacaSensorHistoryCodec_t decoder = {5000, 0, bitsOf(15.0f), 0xFF, 0};
+    uint32_t pos = 0;
+    for (size_t i = 0; i < times.size(); i++)
+    {
+        uint32_t decoded_ms = 0;
+        float decoded = 0.0f;
+        pos += AlpacaSensorHistory::Decode(block.data, pos, decoder, decoded_ms, decoded);
+        TEST_ASSERT_EQUAL_UINT32(times[i], decoded_ms);
+        TEST_ASSERT_EQUAL_HEX32(bitsOf(values[i]), bitsOf(decoded));
+    }
+    TEST_ASSERT_EQUAL_UINT32(bits, pos);
+}
+
+// samples appended to the newest block while a reader is at its end are not skipped
+void test_reader_follows_the_writer()
+{
+    static AlpacaSensorHistory history; // the ring is never freed
+    TEST_ASSERT_TRUE(history.Begin());
+    AlpacaSensorHistoryReader reader;
+    uint32_t next_ms = 1000;
+    uint32_t expected_ms = 1000;
+    uint32_t time_ms = 0;
+    float value = 0.0f;
+
+    reader.Begin(&history, 0);
+    for (int round = 0; round < 30; round++)
+    {
+        // a few samples: mostly in the same block, now and then into a new one
+        for (int i = 0; i < 7; i++, next_ms += 1000)
+            history.Add(next_ms, 10.0f + 0.37f * (float)((next_ms / 1000) % 23));
+        while (reader.Next(time_ms, value))
+        {
+            TEST_ASSERT_EQUAL_UINT32(expected_ms, time_ms);
+            TEST_ASSERT_EQUAL_FLOAT(10.0f + 0.37f * (float)((time_ms / 1000) % 23), value);
+            expected_ms += 1000;
+        }
+        TEST_ASSERT_EQUAL_UINT32(next_ms, expected_ms);
+    }
+    AlpacaSensorHistoryStats_t stats;
+    history.GetStats(stats);
+    TEST_ASSERT_TRUE(stats.bits > kBlockBits); // more than one block written
+
+    // a new stream from the latest sample has nothing; the next sample comes
+    reader.Begin(&history, next_ms - 1000);
+    TEST_ASSERT_FALSE(reader.Next(time_ms, value));
+    history.Add(next_ms, 1.0f);
+    TEST_ASSERT_TRUE(reader.Next(time_ms, value));
+    TEST_ASSERT_EQUAL_UINT32(next_ms, time_ms);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_dod_ranges);
+    RUN_TEST(test_xor_windows);
+    RUN_TEST(test_encode_full_block);
+    RUN_TEST(test_block_round_trip);
+    RUN_TEST(test_reader_follows_the_writer);
+    return UNITY_END();
+}
@@ -0,0 +1,141 @@
+/**************************************************************************************************
+  Filename:       test_main.cpp
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Host test of AlpacaSensorSeries - sliding mean over AveragePeriod
+
+  pio test -e native -f test_sensor_series
+  Samples are added at the simulated time of the Arduino shim, as SetSensorValueByIdx() adds
+  them at millis(). A bucket spans window / (kAlpacaOcSeriesSize - 1), so the edge of the window
+  is exact to one bucket.
+**************************************************************************************************/
+#include <unity.h>
+#include "AlpacaSensorSeries.h"
+
+static const uint32_t kWindowMs = 60000;
+static const uint32_t kBucketMs = kWindowMs / (kAlpacaOcSeriesSize - 1);
+
+void setUp() { native::Now() = 0; }
+void tearDown() {}
+
+static void at(uint32_t time_ms) { native::Now() = (int64_t)time_ms * 1000; }
+
+// one sample per second of value in [from_ms, to_ms)
+static void addSamples(AlpacaSensorSeries &series, double value, uint32_t from_ms, uint32_t to_ms)
+{
+    for (uint32_t t = from_ms; t < to_ms; t += 1000)
+    {
+        at(t);
+        series.Add(value, t);
+    }
+}
+
+// angular distance in deg
+static double angleDiff(double a, double b)
+{
+    double d = fmod(fabs(a - b), 360.0);
+    return d > 180.0 ? 360.0 - d : d;
+}
+
+void test_mean_of_window()
+{
+    AlpacaSensorSeries series;
+    series.SetWindow(kWindowMs);
+    addSamples(series, 10.0, 0, 30000);
+    addSamples(series, 20.0, 30000, 60000);
+    TEST_ASSERT_DOUBLE_WITHIN(0.5, 15.0, series.Mean());
+    TEST_ASSERT_EQUAL_DOUBLE(20.0, series.Latest());
+
+    // the samples of 10 leave the window while the samples of 20 keep coming
+    addSamples(series, 20.0, 60000, 90000 + 2 * kBucketMs);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 20.0, series.Mean());
+}
+
+// a sensor that stops sending: the window still ends at millis(), not at the latest sample
+void test_window_eviction_without_samples()
+{
+    AlpacaSensorSeries series;
+    series.SetWindow(kWindowMs);
+    addSamples(series, 10.0, 0, 30000);
+    addSamples(series, 20.0, 30000, 60000);
+
+    at(90000 + 2 * kBucketMs);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 20.0, series.Mean());
+
+    // long after: the newest bucket stays; its mean is the latest value
+    at(3600000);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 20.0, series.Mean());
+    series.Add(30.0, 3600000);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 30.0, series.Mean());
+}
+
+void test_circular_mean_across_zero()
+{
+    AlpacaSensorSeries series;
+    series.SetCircular(true);
+    series.SetWindow(kWindowMs);
+    for (uint32_t t = 0; t < 60000; t += 1000)
+    {
+        at(t);
+        series.Add((t / 1000) % 2 ? 350.0 : 10.0, t);
+    }
+    double mean = series.Mean();
+    TEST_ASSERT_TRUE(mean >= 0.0 && mean < 360.0);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-3, 0.0, angleDiff(mean, 0.0));
+
+    series.Clear();
+    for (uint32_t t = 60000; t < 120000; t += 1000)
+    {
+        at(t);
+        series.Add((t / 1000) % 2 ? 340.0 : 0.0, t);
+    }
+    TEST_ASSERT_DOUBLE_WITHIN(1e-3, 350.0, series.Mean());
+
+    // opposite directions cancel out; the latest sample is reported
+    series.Clear();
+    for (uint32_t t = 120000; t < 180000; t += 1000)
+    {
+        at(t);
+        series.Add((t / 1000) % 2 ? 270.0 : 90.0, t);
+    }
+    TEST_ASSERT_EQUAL_DOUBLE(series.Latest(), series.Mean());
+}
+
+void test_set_window_shrink()
+{
+    AlpacaSensorSeries series;
+    series.SetWindow(kWindowMs);
+    addSamples(series, 10.0, 0, 30000);
+    addSamples(series, 20.0, 30000, 60000);
+    TEST_ASSERT_DOUBLE_WITHIN(0.5, 15.0, series.Mean());
+
+    // 20 s: the samples of 10 are dropped right away
+    series.SetWindow(20000);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 20.0, series.Mean());
+    addSamples(series, 40.0, 60000, 70000);
+    TEST_ASSERT_DOUBLE_WITHIN(0.5, 30.0, series.Mean());
+
+    // window of 0: the latest sample
+    series.SetWindow(0);
+    TEST_ASSERT_EQUAL_DOUBLE(40.0, series.Mean());
+}
+
+// running totals against many evictions; the resum keeps them exact
+void test_long_run()
+{
+    AlpacaSensorSeries series;
+    series.SetWindow(kWindowMs);
+    addSamples(series, 1000.1, 0, 24 * 3600000);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-3, 1000.1, series.Mean());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_mean_of_window);
+    RUN_TEST(test_window_eviction_without_samples);
+    RUN_TEST(test_circular_mean_across_zero);
+    RUN_TEST(test_set_window_shrink);
+    RUN_TEST(test_long_run);
+    return UNITY_END();
+}
@@ -0,0 +1,223 @@
+/**************************************************************************************************
+  Filename:       test_main.cpp
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Host benchmark of the settings file format - JSON vs MessagePack
+
+  pio test -e native -f test_settings_format -v
+  A settings file of the server and kAlpacaMaxDevices simulated devices is built from the shipped
+  settings tables and loaded like the old (one JSON document) and the new LoadSettings() (one
+  filtered MessagePack pass per section). Load time and peak JSON heap are printed; the new format
+  has to be smaller and to need less heap. The file is parsed from RAM; LittleFS reads are not
+  included.
+**************************************************************************************************/
+#include <unity.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "AlpacaJsonAllocator.h"
+#include "AlpacaServerSettings.h"
+#include "AlpacaSimSettings.h"
+
+static const int kRuns = 200;
+static const char *const kDeviceUIDs[] = {"4431a2c0-0000-4000-8000-000000000000", "4431a2c0-0001-4000-8000-000000000001",
+                                          "4431a2c0-0002-4000-8000-000000000002", "4431a2c0-0003-4000-8000-000000000003"};
+static_assert(sizeof(kDeviceUIDs) / sizeof(kDeviceUIDs[0]) >= kAlpacaMaxDevices, "UID per device");
+
+static std::string json_file;
+static std::vector<uint8_t> msgpack_file;
+
+struct Load_t
+{
+    double us;   // per load
+    size_t heap; // peak JSON heap [bytes]
+};
+
+// "Simulator" section of device i; a different simulator per device
+static void _writeSimulator(int i, JsonObject device)
+{
+    AlpacaSimConfig_t sim = {20, 5, 10, 4711};
+    AlpacaSettings::Write(kAlpacaSimSettings, &sim, device);
+    AlpacaSimCounters_t counters = {123456, 789};
+    AlpacaSettings::Write(kAlpacaSimCounters, &counters, device);
+    switch (i % 4)
+    {
+    case 0:
+    {
+        AlpacaSimFocuserConfig_t focuser = {50000, 12.5, 0.2, -0.5};
+        AlpacaSimFocuserMotion_t motion = {800.0f, 2000.0f, 20, 1234};
+        AlpacaSettings::Write(kAlpacaSimFocuserSettings, &focuser, device);
+        AlpacaSettings::Write(kAlpacaSimFocuserProfileSettings, &motion, device);
+        AlpacaSettings::Write(kAlpacaSimFocuserLoadSettings, &motion, device);
+        break;
+    }
+    case 1:
+    {
+        AlpacaSimDomeConfig_t dome = {20000, 5.0f, 2.0f};
+        AlpacaSettings::Write(kAlpacaSimDomeSettings, &dome, device);
+        break;
+    }
+    case 2:
+    {
+        AlpacaSimObservingConditionsConfig_t oc = {1000, 0.05};
+        AlpacaSettings::Write(kAlpacaSimObservingConditionsSettings, &oc, device);
+        break;
+    }
+    default:
+    {
+        AlpacaSimSwitchConfig_t sw = {20};
+        AlpacaSettings::Write(kAlpacaSimSwitchSettings, &sw, device);
+        break;
+    }
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void _buildFiles()
+{
+    JsonDocument doc;
+    JsonObject root = doc.to<JsonObject>();
+    root["SettingsVersion"] = 1;
+    AlpacaServerSettings_t server = {"ALPACA-TS-ESP32", "a1b2c3d4e5f6", 80, 32227, "192.168.1.10", SLOG_INFO, true};
+    AlpacaSettings::Write(kAlpacaServerSettings, &server, root);
+    for (uint32_t i = 0; i < kAlpacaMaxDevices; i++)
+    {
+        JsonObject device = root[kDeviceUIDs[i]].to<JsonObject>();
+        JsonObject general = device["General"].to<JsonObject>();
+        general["Name"] = "sim-device";
+        general["Description"] = "Alpaca simulated reference device";
+        general["DriverInfo"] = "ESP32 simulated driver";
+        general["Location"] = "observatory";
+        _writeSimulator(i, device);
+    }
+    json_file.clear();
+    serializeJson(doc, json_file);
+    msgpack_file.resize(measureMsgPack(doc));
+    serializeMsgPack(doc, msgpack_file.data(), msgpack_file.size());
+}
+
+// sections of the file as LoadSettings() reads them
+static void _readServer(JsonObject root)
+{
+    AlpacaServerSettings_t server = {};
+    AlpacaSettings::Read(kAlpacaServerSettings, root, &server);
+    TEST_ASSERT_EQUAL_UINT16(32227, server.port_udp);
+}
+
+static void _readDevice(JsonObject device)
+{
+    AlpacaSimConfig_t sim = {};
+    AlpacaSettings::Read(kAlpacaSimSettings, device, &sim);
+    TEST_ASSERT_EQUAL_UINT32(4711, sim.seed);
+}
+
+// old format: the whole JSON file in one document
+static void _loadJson(AlpacaJsonPeakAllocator &allocator)
+{
+    JsonDocument doc(&allocator);
+    TEST_ASSERT_FALSE(deserializeJson(doc, json_file.data(), json_file.size()));
+    JsonObject root = doc.as<JsonObject>();
+    _readServer(root);
+    for (uint32_t i = 0; i < kAlpacaMaxDevices; i++)
+        _readDevice(root[kDeviceUIDs[i]]);
+}
+
+// the whole MessagePack file in one document; the format alone
+static void _loadMsgPack(AlpacaJsonPeakAllocator &allocator)
+{
+    JsonDocument doc(&allocator);
+    TEST_ASSERT_FALSE(deserializeMsgPack(doc, msgpack_file.data(), msgpack_file.size()));
+    JsonObject root = doc.as<JsonObject>();
+    _readServer(root);
+    for (uint32_t i = 0; i < kAlpacaMaxDevices; i++)
+        _readDevice(root[kDeviceUIDs[i]]);
+}
+
+// new LoadSettings(): a filtered pass per section, one section in RAM at a time
+static void _loadMsgPackSections(AlpacaJsonPeakAllocator &allocator)
+{
+    {
+        JsonDocument filter(&allocator);
+        JsonObject filter_obj = filter.to<JsonObject>();
+        filter_obj["SettingsVersion"] = true;
+        AlpacaSettings::Filter(kAlpacaServerSettings, filter_obj);
+        JsonDocument doc(&allocator);
+        TEST_ASSERT_FALSE(deserializeMsgPack(doc, msgpack_file.data(), msgpack_file.size(), DeserializationOption::Filter(filter)));
+        _readServer(doc.as<JsonObject>());
+    }
+    for (uint32_t i = 0; i < kAlpacaMaxDevices; i++)
+    {
+        JsonDocument filter(&allocator);
+        JsonObject filter_obj = filter[kDeviceUIDs[i]].to<JsonObject>();
+        filter_obj["General"] = true;
+        filter_obj["Simulator"] = true;
+        JsonDocument doc(&allocator);
+        TEST_ASSERT_FALSE(deserializeMsgPack(doc, msgpack_file.data(), msgpack_file.size(), DeserializationOption::Filter(filter)));
+        _readDevice(doc[kDeviceUIDs[i]]);
+    }
+}
+
+static Load_t _measure(const char *name, void (*load)(AlpacaJsonPeakAllocator &))
+{
+    AlpacaJsonPeakAllocator allocator;
+    load(allocator);
+    TEST_ASSERT_EQUAL_UINT32(0, allocator.GetUsed());
+    auto start = std::chrono::steady_clock::now();
+    for (int run = 0; run < kRuns; run++)
+        load(allocator);
+    auto end = std::chrono::steady_clock::now();
+    Load_t result = {std::chrono::duration<double, std::micro>(end - start).count() / kRuns, allocator.GetPeak()};
+    printf("%-28s %8.1f us/load %7u bytes peak JSON heap\n", name, result.us, (unsigned)result.heap);
+    return result;
+}
+
+void test_file_size()
+{
+    _buildFiles();
+    printf("settings of the server and %u devices: JSON %u bytes, MessagePack %u bytes\n", (unsigned)kAlpacaMaxDevices,
+           (unsigned)json_file.size(), (unsigned)msgpack_file.size());
+    TEST_ASSERT_LESS_THAN_UINT32(json_file.size(), msgpack_file.size());
+}
+
+void test_load()
+{
+    _buildFiles();
+    Load_t json = _measure("JSON, one document", _loadJson);
+    Load_t msgpack = _measure("MessagePack, one document", _loadMsgPack);
+    Load_t sections = _measure("MessagePack, per section", _loadMsgPackSections);
+
+    // times are printed, not checked, since they depend on the host; the passes per section trade
+    // some of the faster parsing for a peak heap of one section instead of the whole file
+    TEST_ASSERT_LESS_THAN_UINT32(json.heap, sections.heap);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(msgpack.heap, sections.heap);
+}
+
+void test_allocator_balance()
+{
+    AlpacaJsonPeakAllocator allocator;
+    {
+        JsonDocument doc(&allocator);
+        for (int i = 0; i < 100; i++)
+            doc["key"][i] = std::string("copied into the document");
+        TEST_ASSERT_GREATER_THAN_UINT32(0, allocator.GetUsed());
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, allocator.GetUsed());
+    size_t peak = allocator.GetPeak();
+    TEST_ASSERT_GREATER_THAN_UINT32(0, peak);
+    allocator.ResetPeak();
+    TEST_ASSERT_EQUAL_UINT32(0, allocator.GetPeak());
+    allocator.Hold(100);
+    allocator.Release(100);
+    TEST_ASSERT_EQUAL_UINT32(100, allocator.GetPeak());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_file_size);
+    RUN_TEST(test_load);
+    RUN_TEST(test_allocator_balance);
+    return UNITY_END();
+}
@@ -0,0 +1,163 @@
+/**************************************************************************************************
+  Filename:       test_main.cpp
+  Revised:        $Date: 2026-10-19$
+  Revision:       $Revision: 01 $
+  Description:    Host test of AlpacaSimCore - latency and failure model of the simulated drivers
+
+  pio test -e native -f test_simulators
+  delay() of the Arduino shim advances the simulated time, so the latency of a call is measured
+  without blocking the host.
+**************************************************************************************************/
+#include <unity.h>
+#include <vector>
+#include "AlpacaSimCore.h"
+
+static const uint32_t kTaskWatchdogMs = 5000; // CONFIG_ESP_TASK_WDT_TIMEOUT_S of the Arduino core
+
+void setUp() { native::Now() = 0; }
+void tearDown() {}
+
+struct Call_t
+{
+    bool ok;
+    uint32_t latency_ms;
+};
+
+// run n driver calls; result and simulated latency of each call
+static std::vector<Call_t> run(AlpacaSimCore &sim, uint32_t n, uint32_t extra_ms = 0)
+{
+    std::vector<Call_t> calls;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        int64_t start_us = native::Now();
+        bool ok = sim.SimCall(extra_ms);
+        calls.push_back({ok, (uint32_t)((native::Now() - start_us) / 1000)});
+    }
+    return calls;
+}
+
+void test_same_seed_same_run()
+{
+    AlpacaSimCore a, b;
+    a.SetSimConfig({5, 200, 50, 1234});
+    b.SetSimConfig({5, 200, 50, 1234});
+    std::vector<Call_t> run_a = run(a, 10000);
+    std::vector<Call_t> run_b = run(b, 10000);
+    for (uint32_t i = 0; i < run_a.size(); i++)
+    {
+        TEST_ASSERT_EQUAL(run_a[i].ok, run_b[i].ok);
+        TEST_ASSERT_EQUAL_UINT32(run_a[i].latency_ms, run_b[i].latency_ms);
+    }
+    TEST_ASSERT_EQUAL_UINT32(a.GetSimFailures(), b.GetSimFailures());
+}
+
+void test_other_seed_other_run()
+{
+    AlpacaSimCore a, b;
+    a.SetSimConfig({0, 0, 500, 1});
+    b.SetSimConfig({0, 0, 500, 2});
+    std::vector<Call_t> run_a = run(a, 64);
+    std::vector<Call_t> run_b = run(b, 64);
+    uint32_t differ = 0;
+    for (uint32_t i = 0; i < run_a.size(); i++)
+        differ += run_a[i].ok != run_b[i].ok ? 1 : 0;
+    TEST_ASSERT_GREATER_THAN_UINT32(0, differ);
+}
+
+void test_reseed_restarts_run()
+{
+    AlpacaSimCore sim;
+    sim.SetSimConfig({0, 100, 100, 77});
+    std::vector<Call_t> first = run(sim, 1000);
+    sim.SetSimConfig({0, 100, 100, 77});
+    std::vector<Call_t> second = run(sim, 1000);
+    for (uint32_t i = 0; i < first.size(); i++)
+    {
+        TEST_ASSERT_EQUAL(first[i].ok, second[i].ok);
+        TEST_ASSERT_EQUAL_UINT32(first[i].latency_ms, second[i].latency_ms);
+    }
+    TEST_ASSERT_EQUAL_UINT32(2000, sim.GetSimCalls());
+}
+
+void test_seed_zero_is_default_seed()
+{
+    AlpacaSimCore a, b;
+    a.SetSimConfig({0, 0, 500, 0});
+    b.SetSimConfig({0, 0, 500, 1});
+    std::vector<Call_t> run_a = run(a, 256);
+    std::vector<Call_t> run_b = run(b, 256);
+    for (uint32_t i = 0; i < run_a.size(); i++)
+        TEST_ASSERT_EQUAL(run_a[i].ok, run_b[i].ok);
+}
+
+void test_failure_rate()
+{
+    AlpacaSimCore sim;
+    sim.SetSimConfig({0, 0, 100, 4711});
+    run(sim, 100000);
+    TEST_ASSERT_EQUAL_UINT32(100000, sim.GetSimCalls());
+    TEST_ASSERT_UINT32_WITHIN(1000, 10000, sim.GetSimFailures());
+
+    sim.SetSimConfig({0, 0, 0, 4711});
+    for (const Call_t &call : run(sim, 1000))
+        TEST_ASSERT_TRUE(call.ok);
+    sim.SetSimConfig({0, 0, 1000, 4711});
+    for (const Call_t &call : run(sim, 1000))
+        TEST_ASSERT_FALSE(call.ok);
+}
+
+void test_latency_and_jitter()
+{
+    AlpacaSimCore sim;
+    sim.SetSimConfig({30, 0, 0, 1});
+    for (const Call_t &call : run(sim, 100))
+        TEST_ASSERT_EQUAL_UINT32(30, call.latency_ms);
+    TEST_ASSERT_EQUAL_UINT32(3000, millis());
+
+    sim.SetSimConfig({10, 20, 0, 1});
+    uint32_t min_ms = UINT32_MAX, max_ms = 0;
+    for (const Call_t &call : run(sim, 10000))
+    {
+        min_ms = min(min_ms, call.latency_ms);
+        max_ms = max(max_ms, call.latency_ms);
+    }
+    TEST_ASSERT_EQUAL_UINT32(10, min_ms);
+    TEST_ASSERT_EQUAL_UINT32(30, max_ms);
+}
+
+// the call holds the driver lock on the AsyncTCP task; it must never come near the task watchdog
+void test_latency_clamped()
+{
+    AlpacaSimCore sim;
+    sim.SetSimConfig({UINT32_MAX, UINT32_MAX, 0, 1});
+    for (const Call_t &call : run(sim, 1000, UINT32_MAX))
+        TEST_ASSERT_EQUAL_UINT32(kAlpacaSimMaxLatencyMs, call.latency_ms);
+
+    sim.SetSimConfig({kAlpacaSimMaxLatencyMs, kAlpacaSimMaxLatencyMs, 0, 1});
+    for (const Call_t &call : run(sim, 1000, kAlpacaSimMaxLatencyMs))
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(kAlpacaSimMaxLatencyMs, call.latency_ms);
+    TEST_ASSERT_LESS_THAN_UINT32(kTaskWatchdogMs / 2, kAlpacaSimMaxLatencyMs);
+}
+
+// write latency of the switch adds to the common latency
+void test_extra_latency()
+{
+    AlpacaSimCore sim;
+    sim.SetSimConfig({5, 0, 0, 1});
+    for (const Call_t &call : run(sim, 10, 20))
+        TEST_ASSERT_EQUAL_UINT32(25, call.latency_ms);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_same_seed_same_run);
+    RUN_TEST(test_other_seed_other_run);
+    RUN_TEST(test_reseed_restarts_run);
+    RUN_TEST(test_seed_zero_is_default_seed);
+    RUN_TEST(test_failure_rate);
+    RUN_TEST(test_latency_and_jitter);
+    RUN_TEST(test_latency_clamped);
+    RUN_TEST(test_extra_latency);
+    return UNITY_END();
+}
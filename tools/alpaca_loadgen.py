@@ -0,0 +1,291 @@
+#!/usr/bin/env python3
+"""
+  Filename:       alpaca_loadgen.py
+  Description:    Replayable Alpaca request load generator for the ESP32 Alpaca server
+
+  Replays a recorded or synthetic request trace against an Alpaca server (a board on the
+  network or a host build with simulated devices) and reports throughput, tail latency
+  and error counts for several numbers of concurrent clients.
+
+  Trace format (one JSON object per line):
+      {"method": "GET", "path": "/api/v1/dome/0/shutterstatus", "params": {"Foo": "1"}}
+      {"method": "PUT", "path": "/api/v1/switch/0/setswitchvalue", "params": {"Id": "0", "Value": "1"}}
+  "ClientID" and "ClientTransactionID" are added by the generator, one ClientID per
+  simulated client. An optional "think_ms" delays the client before the request.
+  The leading "connected" PUTs of a trace are its prologue: every client sends them once, then
+  loops over the rest of the trace from its own start position.
+
+  Examples:
+      alpaca_loadgen.py --host 192.168.1.50 --synthetic nina --duration 20
+      alpaca_loadgen.py --host 127.0.0.1 --port 8080 --trace traces/nina_session.jsonl
+      alpaca_loadgen.py --host 192.168.1.50 --synthetic churn --clients 1,4 --dump-trace churn.jsonl
+"""
+import argparse
+import http.client
+import json
+import random
+import socket
+import sys
+import threading
+import time
+import urllib.parse
+
+# device types polled by the synthetic traces; device number is always 0 unless --devices says otherwise
+POLL_GETS = {
+    "dome": ["shutterstatus", "slewing", "connected"],
+    "focuser": ["position", "ismoving", "temperature", "connected"],
+    "switch": ["getswitchvalue", "getswitch", "maxswitch"],
+    "observingconditions": ["temperature", "humidity", "dewpoint", "pressure", "averageperiod"],
+    "safetymonitor": ["issafe"],
+}
+
+
+def _dev_path(dev_type, dev_num, command):
+    return "/api/v1/%s/%d/%s" % (dev_type, dev_num, command)
+
+
+def _get(dev_type, dev_num, command, **params):
+    return {"method": "GET", "path": _dev_path(dev_type, dev_num, command), "params": params}
+
+
+def _put(dev_type, dev_num, command, **params):
+    return {"method": "PUT", "path": _dev_path(dev_type, dev_num, command), "params": params}
+
+
+def synthetic_trace(kind, devices, length, seed):
+    """Build a synthetic trace.
+    nina  - mixed GET polling across all devices, like an imaging application during a sequence
+    burst - polling interleaved with PUT bursts (switch writes, focuser moves, shutter commands)
+    churn - connect/disconnect churn mixed with light polling (ConformU style)"""
+    rnd = random.Random(seed)
+    trace = []
+    # prologue: every client connects to all devices before its first poll
+    for dev_type, dev_num in devices:
+        trace.append(_put(dev_type, dev_num, "connected", Connected="True"))
+
+    def poll():
+        dev_type, dev_num = rnd.choice(devices)
+        command = rnd.choice(POLL_GETS.get(dev_type, ["connected"]))
+        params = {}
+        if dev_type == "switch" and command.startswith("getswitch"):
+            params["Id"] = str(rnd.randrange(0, 4))
+        return _get(dev_type, dev_num, command, **params)
+
+    while len(trace) < length:
+        if kind == "nina":
+            trace.append(poll())
+        elif kind == "burst":
+            if rnd.random() < 0.1:
+                dev_type, dev_num = rnd.choice(devices)
+                for _ in range(rnd.randrange(4, 12)):
+                    if dev_type == "switch":
+                        trace.append(_put(dev_type, dev_num, "setswitchvalue", Id=str(rnd.randrange(0, 4)), Value=str(rnd.randrange(0, 2))))
+                    elif dev_type == "focuser":
+                        trace.append(_put(dev_type, dev_num, "move", Position=str(rnd.randrange(0, 10000))))
+                    elif dev_type == "dome":
+                        trace.append(_put(dev_type, dev_num, rnd.choice(["openshutter", "closeshutter", "abortslew"])))
+                    else:
+                        trace.append(poll())
+            else:
+                trace.append(poll())
+        elif kind == "churn":
+            dev_type, dev_num = rnd.choice(devices)
+            trace.append(_put(dev_type, dev_num, "connected", Connected="False"))
+            trace.append(_put(dev_type, dev_num, "connected", Connected="True"))
+            for _ in range(rnd.randrange(1, 5)):
+                trace.append(poll())
+        else:
+            raise ValueError("unknown synthetic trace '%s'" % kind)
+    return trace[:length]
+
+
+def load_trace(path):
+    trace = []
+    with open(path, "r", encoding="utf-8") as f:
+        for line_no, line in enumerate(f, 1):
+            line = line.strip()
+            if not line or line.startswith("#"):
+                continue
+            try:
+                entry = json.loads(line)
+            except json.JSONDecodeError as e:
+                sys.exit("%s:%d: %s" % (path, line_no, e))
+            entry.setdefault("method", "GET")
+            entry.setdefault("params", {})
+            trace.append(entry)
+    return trace
+
+
+class Stats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.latencies_ms = []
+        self.requests = 0
+        self.http_errors = 0     # status != 200 (400 included; the server uses it for malformed requests)
+        self.alpaca_errors = 0   # HTTP 200 but ErrorNumber != 0
+        self.net_errors = 0      # timeouts, resets, refused connections
+        self.bad_json = 0
+
+    def add(self, latency_ms, status, body):
+        with self.lock:
+            self.requests += 1
+            self.latencies_ms.append(latency_ms)
+            if status != 200:
+                self.http_errors += 1
+                return
+            try:
+                rsp = json.loads(body)
+            except ValueError:
+                self.bad_json += 1
+                return
+            if isinstance(rsp, dict) and rsp.get("ErrorNumber", 0) != 0:
+                self.alpaca_errors += 1
+
+    def add_net_error(self):
+        with self.lock:
+            self.requests += 1
+            self.net_errors += 1
+
+
+def _percentile(sorted_values, p):
+    if not sorted_values:
+        return 0.0
+    k = min(len(sorted_values) - 1, max(0, int(round(p / 100.0 * (len(sorted_values) - 1)))))
+    return sorted_values[k]
+
+
+def prologue_length(trace):
+    """Number of leading PUT connected entries; sent once per client, not looped."""
+    n = 0
+    while n < len(trace) and trace[n]["method"].upper() == "PUT" and trace[n]["path"].endswith("/connected"):
+        n += 1
+    return n
+
+
+def client_worker(args, trace, client_id, stop_at, stats):
+    conn = None
+    transaction_id = 0
+    prologue = prologue_length(trace)
+    loop_len = len(trace) - prologue
+    entries = iter(trace[:prologue])
+    # after the prologue, clients loop from different trace positions
+    idx = prologue + ((client_id * 7919) % loop_len if loop_len > 0 else 0)
+    while time.monotonic() < stop_at:
+        entry = next(entries, None)
+        if entry is None:
+            if loop_len == 0:
+                break
+            entry = trace[idx]
+            idx = prologue + (idx + 1 - prologue) % loop_len
+        if entry.get("think_ms"):
+            time.sleep(entry["think_ms"] / 1000.0)
+        transaction_id += 1
+        params = dict(entry["params"])
+        params["ClientID"] = str(client_id)
+        params["ClientTransactionID"] = str(transaction_id)
+        query = urllib.parse.urlencode(params)
+        method = entry["method"].upper()
+        if method == "GET":
+            url, body, headers = entry["path"] + "?" + query, None, {}
+        else:
+            url, body, headers = entry["path"], query, {"Content-Type": "application/x-www-form-urlencoded"}
+        t0 = time.perf_counter()
+        try:
+            if conn is None:
+                conn = http.client.HTTPConnection(args.host, args.port, timeout=args.timeout)
+                conn.connect()
+                # headers and body go out as separate writes; Nagle would add ~40ms to each PUT
+                conn.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+            conn.request(method, url, body=body, headers=headers)
+            rsp = conn.getresponse()
+            data = rsp.read()
+            stats.add((time.perf_counter() - t0) * 1000.0, rsp.status, data)
+            if rsp.getheader("Connection", "").lower() == "close":
+                conn.close()
+                conn = None
+        except (OSError, http.client.HTTPException):
+            stats.add_net_error()
+            if conn is not None:
+                conn.close()
+            conn = None
+            time.sleep(0.05)  # do not spin on a dead server
+    if conn is not None:
+        conn.close()
+
+
+def run_level(args, trace, n_clients):
+    stats = Stats()
+    stop_at = time.monotonic() + args.duration
+    threads = [threading.Thread(target=client_worker, args=(args, trace, args.first_client_id + i, stop_at, stats), daemon=True)
+               for i in range(n_clients)]
+    t0 = time.monotonic()
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    elapsed = time.monotonic() - t0
+    lat = sorted(stats.latencies_ms)
+    return {
+        "clients": n_clients,
+        "requests": stats.requests,
+        "rps": stats.requests / elapsed if elapsed > 0 else 0.0,
+        "p50_ms": _percentile(lat, 50),
+        "p95_ms": _percentile(lat, 95),
+        "p99_ms": _percentile(lat, 99),
+        "max_ms": lat[-1] if lat else 0.0,
+        "http_errors": stats.http_errors,
+        "alpaca_errors": stats.alpaca_errors,
+        "net_errors": stats.net_errors,
+        "bad_json": stats.bad_json,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Replay Alpaca request traces and report throughput, tail latency and errors.")
+    parser.add_argument("--host", required=True)
+    parser.add_argument("--port", type=int, default=80)
+    src = parser.add_mutually_exclusive_group(required=True)
+    src.add_argument("--trace", help="recorded trace file (JSON lines)")
+    src.add_argument("--synthetic", choices=["nina", "burst", "churn"], help="generate a synthetic trace")
+    parser.add_argument("--devices", default="dome:0,focuser:0,switch:0,observingconditions:0",
+                        help="device list for synthetic traces, <type>:<number>,...")
+    parser.add_argument("--length", type=int, default=2000, help="synthetic trace length")
+    parser.add_argument("--seed", type=int, default=1, help="seed for synthetic traces")
+    parser.add_argument("--clients", default="1,4,16,64", help="concurrency levels")
+    parser.add_argument("--duration", type=float, default=10.0, help="seconds per concurrency level")
+    parser.add_argument("--timeout", type=float, default=5.0, help="per request timeout [s]")
+    parser.add_argument("--first-client-id", type=int, default=1000)
+    parser.add_argument("--dump-trace", help="write the trace used to this file and continue")
+    parser.add_argument("--json", action="store_true", help="print results as JSON")
+    args = parser.parse_args()
+
+    if args.trace:
+        trace = load_trace(args.trace)
+    else:
+        devices = []
+        for item in args.devices.split(","):
+            dev_type, _, dev_num = item.partition(":")
+            devices.append((dev_type.strip(), int(dev_num or 0)))
+        trace = synthetic_trace(args.synthetic, devices, args.length, args.seed)
+    if not trace:
+        sys.exit("empty trace")
+    if args.dump_trace:
+        with open(args.dump_trace, "w", encoding="utf-8") as f:
+            for entry in trace:
+                f.write(json.dumps(entry) + "\n")
+
+    results = []
+    for n in [int(c) for c in args.clients.split(",") if c.strip()]:
+        result = run_level(args, trace, n)
+        results.append(result)
+        if not args.json:
+            print("clients=%3d req=%7d rps=%8.1f p50=%7.1fms p95=%7.1fms p99=%7.1fms max=%7.1fms http_err=%d alpaca_err=%d net_err=%d bad_json=%d"
+                  % (result["clients"], result["requests"], result["rps"], result["p50_ms"], result["p95_ms"], result["p99_ms"],
+                     result["max_ms"], result["http_errors"], result["alpaca_errors"], result["net_errors"], result["bad_json"]))
+            sys.stdout.flush()
+    if args.json:
+        print(json.dumps(results, indent=2))
+
+
+if __name__ == "__main__":
+    main()
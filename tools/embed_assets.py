@@ -0,0 +1,213 @@
+#!/usr/bin/env python3
+"""
+  Filename:       embed_assets.py
+  Description:    Embed data/www as gzip byte arrays into src/AlpacaWebAssets.h
+
+  Runs as PlatformIO pre script (see platformio.ini) and defines ALPACA_EMBEDDED_WEB_ASSETS,
+  or standalone: python3 tools/embed_assets.py [project_dir]
+
+  - *.gz files are embedded as they are and served without the .gz suffix
+  - all other files are gzip compressed (deterministic, mtime=0)
+  - ETag is a content hash of the served gzip data
+  - references to embedded assets in setup.html get "?v=<etag>", so they can be cached as
+    immutable; setup.html itself is revalidated with its ETag
+  - /favicon.ico is an alias of www/TSS.ico
+  - setup.html is also bundled into one document (kAlpacaSetupBundle) with the page specific css and js
+    inlined; the *.min.* libraries and the icon stay references to the cached assets, see
+    AlpacaServer::SendSetupPage()
+  The header is only rewritten when its content changes.
+"""
+import gzip
+import hashlib
+import os
+import re
+import sys
+import zlib
+
+CONTENT_TYPES = {
+    ".html": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".ico": "image/x-icon",
+    ".png": "image/png",
+    ".svg": "image/svg+xml",
+    ".json": "application/json",
+}
+SETUP_PAGE = "/www/setup.html"
+ALIASES = {"/favicon.ico": "/www/TSS.ico"}
+HEADER = "AlpacaWebAssets.h"
+
+
+def _gzip(data):
+    return gzip.compress(data, compresslevel=9, mtime=0)
+
+
+def _etag(gz):
+    return hashlib.sha256(gz).hexdigest()[:16]
+
+
+def _c_string(text):
+    """C string literal of text; quotes, backslashes and non printable bytes escaped"""
+    out = []
+    for b in text.encode("utf-8"):
+        c = chr(b)
+        if c in "\\\"":
+            out.append("\\" + c)
+        elif 0x20 <= b < 0x7f and c != "?":  # "?" escaped against trigraphs
+            out.append(c)
+        else:
+            out.append("\\%03o" % b)
+    return '"' + "".join(out) + '"'
+
+
+def _c_bytes(data):
+    """initializer lines of a byte array, 16 bytes per line"""
+    return ["    " + ", ".join("0x%02x" % b for b in data[k:k + 16]) + "," for k in range(0, len(data), 16)]
+
+
+def collect(data_dir):
+    """url -> {"gz": bytes, "type": str, "etag": str, "immutable": bool}"""
+    assets = {}
+    www_dir = os.path.join(data_dir, "www")
+    for root, _, files in os.walk(www_dir):
+        for name in sorted(files):
+            path = os.path.join(root, name)
+            url = "/" + os.path.relpath(path, data_dir).replace(os.sep, "/")
+            with open(path, "rb") as f:
+                raw = f.read()
+            if url.endswith(".gz"):
+                url, gz = url[:-3], raw
+            else:
+                gz = _gzip(raw)
+            ext = os.path.splitext(url)[1]
+            assets[url] = {"raw": raw, "gz": gz, "type": CONTENT_TYPES.get(ext, "application/octet-stream"),
+                           "etag": _etag(gz), "immutable": url != SETUP_PAGE}
+
+    # version the asset references of the setup page
+    if SETUP_PAGE in assets:
+        html = assets[SETUP_PAGE]["raw"].decode("utf-8")
+        for url, asset in assets.items():
+            if url != SETUP_PAGE:
+                html = html.replace('"%s"' % url, '"%s?v=%s"' % (url, asset["etag"]))
+        gz = _gzip(html.encode("utf-8"))
+        assets[SETUP_PAGE].update({"gz": gz, "etag": _etag(gz)})
+    return assets
+
+
+def _minify_html(html):
+    html = re.sub(r"<!--.*?-->", "", html, flags=re.S)
+    return "\n".join(line.strip() for line in html.splitlines() if line.strip())
+
+
+def _minify_css(css):
+    css = re.sub(r"/\*.*?\*/", "", css, flags=re.S)
+    return re.sub(r"\s+", " ", css).strip()
+
+
+def _minify_js(js):
+    # only indentation and empty lines; safe for code without multi-line string literals
+    return "\n".join(line.strip() for line in js.splitlines() if line.strip())
+
+
+def bundle(data_dir, assets):
+    """setup.html with the page css and js inlined; returns (prefix, suffix) around the boot data script"""
+    def read(url):
+        path = os.path.join(data_dir, url.lstrip("/"))
+        if os.path.exists(path + ".gz"):
+            with open(path + ".gz", "rb") as f:
+                return gzip.decompress(f.read())
+        with open(path, "rb") as f:
+            return f.read()
+
+    def versioned(url):
+        return "%s?v=%s" % (url, assets[url]["etag"]) if url in assets else url
+
+    # libraries are shared by every page view and cached as immutable; only the page code is inlined
+    def style(m):
+        if ".min." in m.group(1):
+            return '<link rel="stylesheet" href="%s">' % versioned(m.group(1))
+        return "<style>%s</style>" % _minify_css(read(m.group(1)).decode("utf-8"))
+
+    def script(m):
+        if ".min." in m.group(1):
+            return '<script src="%s"></script>' % versioned(m.group(1))
+        return "<script>%s</script>" % _minify_js(read(m.group(1)).decode("utf-8")).replace("</script", "<\\/script")
+
+    def icon(m):
+        return '<link rel="icon" href="%s">' % versioned(m.group(1))
+
+    html = _minify_html(read(SETUP_PAGE).decode("utf-8"))
+    html = re.sub(r'<link rel="stylesheet" href="(/www/[^"]+)">', style, html)
+    html = re.sub(r'<script src="(/www/[^"]+)"></script>', script, html)
+    html = re.sub(r'<link rel="icon" href="(/www/[^"]+)"\s*/?>', icon, html)
+    end = html.rindex("</body>")
+    return html[:end].encode("utf-8"), html[end:].replace("\n", "")
+
+
+def render_bundle(prefix, suffix):
+    """gzip member without end: header and deflate blocks of prefix, byte aligned by a sync flush"""
+    comp = zlib.compressobj(9, zlib.DEFLATED, -15)
+    data = b"\x1f\x8b\x08\x00\x00\x00\x00\x00\x02\xff" + comp.compress(prefix) + comp.flush(zlib.Z_SYNC_FLUSH)
+    out = ["// setup.html with the page css and js inlined; open gzip stream, see AlpacaServer::SendSetupPage()",
+           "static const uint8_t kAlpacaSetupBundle[] = {"]
+    out += _c_bytes(data)
+    out.append("};")
+    out.append("static const uint32_t kAlpacaSetupBundleCrc = 0x%08x;  // crc32 of the uncompressed page" % (zlib.crc32(prefix) & 0xffffffff))
+    out.append("static const uint32_t kAlpacaSetupBundleSize = %d;     // size of the uncompressed page" % len(prefix))
+    out.append("static const char kAlpacaSetupBundleEnd[] = %s; // appended after the boot data" % _c_string(suffix))
+    out.append("")
+    return out
+
+
+def render(assets, setup_bundle):
+    out = ["// generated by tools/embed_assets.py from data/www - do not edit",
+           "#pragma once",
+           "#include \"AlpacaServer.h\"",
+           ""]
+    names = {}
+    for i, (url, asset) in enumerate(sorted(assets.items())):
+        names[url] = "kAlpacaWebAsset%d" % i
+        out.append("// %s (%d bytes gzip)" % (url, len(asset["gz"])))
+        out.append("static const uint8_t %s[] = {" % names[url])
+        out += _c_bytes(asset["gz"])
+        out.append("};")
+    out.append("")
+    out.append("static const AlpacaWebAsset_t kAlpacaWebAssets[] = {")
+    urls = sorted(assets) + sorted(a for a in ALIASES if ALIASES[a] in assets)
+    for url in urls:
+        asset = assets[ALIASES.get(url, url)]
+        name = names[ALIASES.get(url, url)]
+        out.append('    {%s, %s, %s, sizeof(%s), %s, %s},' % (
+            _c_string(url), _c_string(asset["type"]), name, name, _c_string('"%s"' % asset["etag"]),
+            "true" if asset["immutable"] and url not in ALIASES else "false"))
+    out.append("};")
+    out.append("static const size_t kAlpacaWebAssetsCount = sizeof(kAlpacaWebAssets) / sizeof(kAlpacaWebAssets[0]);")
+    out.append("")
+    out += render_bundle(*setup_bundle)
+    return "\n".join(out)
+
+
+def generate(project_dir):
+    assets = collect(os.path.join(project_dir, "data"))
+    text = render(assets, bundle(os.path.join(project_dir, "data"), assets))
+    header = os.path.join(project_dir, "src", HEADER)
+    old = None
+    if os.path.exists(header):
+        with open(header, "r", encoding="utf-8") as f:
+            old = f.read()
+    if old != text:
+        with open(header, "w", encoding="utf-8") as f:
+            f.write(text)
+        print("embed_assets: wrote %s (%d assets)" % (header, len(assets)))
+
+
+try:
+    Import("env")  # noqa: F821 - PlatformIO/SCons
+except NameError:
+    env = None
+
+if env is not None:
+    generate(env.subst("$PROJECT_DIR"))
+    env.Append(CPPDEFINES=["ALPACA_EMBEDDED_WEB_ASSETS"])
+elif __name__ == "__main__":
+    generate(os.path.normpath(sys.argv[1] if len(sys.argv) > 1 else os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")))